@@ -1,8 +1,21 @@
 #include "../logs/Xulog.h"
+#include "../extend/DataBaseSink.hpp"
+#include "../extend/ServerSink.hpp"
+#include "../extend/UdpSink.hpp"
+#include "../server/codec.hpp"
+#include "../server/compress.hpp"
+#include "../server/server.hpp"
+#include "../server/session.hpp"
+#include "../server/udpserver.hpp"
+#include <ctime>
 #include <vector>
 #include <thread>
 #include <chrono>
-void bench(const std::string &logger_name, size_t thr_count, size_t msg_count, size_t msg_len)
+#include <atomic>
+/// @brief 日志接口成员函数指针，默认以 FATAL 等级压测
+using LogFunc = void (Xulog::Logger::*)(const std::string &, size_t, const char *, ...);
+void bench(const std::string &logger_name, size_t thr_count, size_t msg_count, size_t msg_len,
+           LogFunc log_func = &Xulog::Logger::fatal)
 {
     // 获取日志器
     Xulog::Logger::ptr logger = Xulog::getLogger(logger_name);
@@ -27,7 +40,7 @@ void bench(const std::string &logger_name, size_t thr_count, size_t msg_count, s
                                 // 循环写日志
                                 for (int j = 0; j < msg_per_thr; j++)
                                 {
-                                    fatal(logger, "%s", msg.c_str());
+                                    (logger.get()->*log_func)(__FILE__, __LINE__, "%s", msg.c_str());
                                 }
                                 // 结束计时
                                 auto end = std::chrono::high_resolution_clock::now();
@@ -72,8 +85,527 @@ void async_bench()
     builder->build();
     bench("Asynclogger", 3, 100 * 1000, 100);
 }
-int main()
+// 同步日志器多线程扩展性：FileSink（O_APPEND 无锁）+ RollSinkBySize（sink 级锁）
+// 两个 sink 写不同 fd，线程数增加时不应被单一日志器锁完全串行化
+void sync_scaling_bench()
 {
-    async_bench();
+    std::unique_ptr<Xulog::LoggerBuilder> builder(new Xulog::GlobalLoggerBuild());
+    builder->buildLoggerName("SyncScaling");
+    builder->buildFormatter("%m%n");
+    builder->buildLoggerType(Xulog::LoggerType::LOGGER_SYNC);
+    builder->buildSink<Xulog::FileSink>("./log/SyncScaling.log");
+    builder->buildSink<Xulog::RollSinkBySize>("./log/SyncScaling-roll-", 64 * 1024 * 1024);
+    builder->build();
+    size_t thr_counts[] = {1, 2, 4, 8};
+    for (size_t thr : thr_counts)
+    {
+        std::cout << "==== 同步日志器 " << thr << " 线程 ====" << std::endl;
+        bench("SyncScaling", thr, 400 * 1000, 100);
+    }
+}
+/// @brief 以指定存储参数和组提交参数压测数据库落地，同时开一个只读线程持续查询
+void db_case(const std::string &name, const SqliteProfile &profile, size_t batch_rows, size_t msg_count,
+             size_t thr_count = 1, size_t queue_rows = 0)
+{
+    std::string dbfile = "./log/bench-" + name + ".db";
+    std::unique_ptr<Xulog::LoggerBuilder> builder(new Xulog::GlobalLoggerBuild());
+    builder->buildLoggerName(name);
+    builder->buildFormatter("%m");
+    builder->buildLoggerType(Xulog::LoggerType::LOGGER_SYNC);
+    builder->buildSink<DataBaseSink>(dbfile, name, batch_rows, 200, profile, false, DBPartition::NONE, 0, queue_rows);
+    builder->build();
+
+    // 读者不设 busy_timeout：被写者阻塞时立即返回 SQLITE_BUSY 并计数
+    std::atomic<bool> stop(false);
+    size_t reads = 0, busy = 0;
+    std::thread reader([&]()
+                       {
+                           sqlite3 *db = nullptr;
+                           sqlite3_open_v2(dbfile.c_str(), &db, SQLITE_OPEN_READONLY, nullptr);
+                           while (!stop.load())
+                           {
+                               sqlite3_stmt *stmt = nullptr;
+                               int rc = sqlite3_prepare_v2(db, "SELECT COUNT(*) FROM logs", -1, &stmt, nullptr);
+                               if (rc == SQLITE_OK)
+                                   rc = sqlite3_step(stmt);
+                               sqlite3_finalize(stmt);
+                               if (rc == SQLITE_ROW)
+                                   reads++;
+                               else
+                                   busy++;
+                               std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                           }
+                           sqlite3_close(db); });
+    std::cout << "==== " << name << " journal_mode=" << profile.journal_mode
+              << " synchronous=" << profile.synchronous << " batch_rows=" << batch_rows
+              << " queue_rows=" << queue_rows << " ====" << std::endl;
+    auto start = std::chrono::steady_clock::now();
+    bench(name, thr_count, msg_count, 100, &Xulog::Logger::info);
+    stop = true;
+    reader.join();
+    std::cout << "并发读者 成功查询:" << reads << " 被阻塞:" << busy << std::endl;
+
+    // 端到端：等到全部日志对读者可见（写线程模式下业务线程返回时日志可能仍在队列中）
+    sqlite3 *db = nullptr;
+    sqlite3_open_v2(dbfile.c_str(), &db, SQLITE_OPEN_READONLY, nullptr);
+    sqlite3_busy_timeout(db, 1000);
+    long long rows = 0;
+    while (rows < (long long)msg_count)
+    {
+        sqlite3_stmt *stmt = nullptr;
+        sqlite3_prepare_v2(db, "SELECT COUNT(*) FROM logs", -1, &stmt, nullptr);
+        if (sqlite3_step(stmt) == SQLITE_ROW)
+            rows = sqlite3_column_int64(stmt, 0);
+        sqlite3_finalize(stmt);
+        if (rows < (long long)msg_count)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    sqlite3_close(db);
+    std::chrono::duration<double> total = std::chrono::steady_clock::now() - start;
+    std::cout << "全部提交耗时: " << total.count() << "s" << std::endl;
+}
+void db_bench()
+{
+    // 逐行提交：每行一次事务，只跑少量数据
+    db_case("legacy-per-row", SqliteProfile::legacy(), 1, 2 * 1000);
+    db_case("wal-per-row", SqliteProfile(), 1, 20 * 1000);
+    // 组提交：每 1000 行或 200ms 一个事务（INFO 等级，不触发 ERROR 立即提交）
+    db_case("legacy-batch", SqliteProfile::legacy(), 1000, 500 * 1000);
+    db_case("wal-batch", SqliteProfile(), 1000, 500 * 1000);
+    // 4 个业务线程共用同步日志器：调用线程内插入 vs 写线程
+    db_case("wal-batch-4thr", SqliteProfile(), 1000, 500 * 1000, 4);
+    db_case("wal-writer-4thr", SqliteProfile(), 1000, 500 * 1000, 4, 8192);
+    // 突发：队列放得下时业务线程只付出一次入队
+    db_case("wal-burst-4thr", SqliteProfile(), 1000, 8 * 1000, 4);
+    db_case("wal-writer-burst-4thr", SqliteProfile(), 1000, 8 * 1000, 4, 16384);
+}
+/// @brief 编解码单项计时，返回每条耗时（纳秒）
+template <typename Fn>
+double codec_case(size_t count, Fn fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++)
+        fn(i);
+    std::chrono::duration<double, std::nano> cost = std::chrono::steady_clock::now() - start;
+    return cost.count() / count;
+}
+/// @brief 线上编码对比：Json 与二进制的单条编码、解码耗时和字节数
+void codec_bench()
+{
+    const size_t count = 500 * 1000;
+    Xulog::LogMsg msg(Xulog::LogLevel::value::INFO, 128, "src/service/handler.cc", "order-service",
+                      std::string(100, 'X'));
+    std::cout << "==== codec " << count << " 条，正文 100B ====" << std::endl;
+
+    Json::StreamWriterBuilder writer;
+    std::unique_ptr<Json::CharReader> reader(Json::CharReaderBuilder().newCharReader());
+    std::string json;
+    double json_enc = codec_case(count, [&](size_t)
+                                 { json = Json::writeString(writer, Xulog::Codec::toJson(msg)); });
+    size_t sink = 0;
+    double json_dec = codec_case(count, [&](size_t)
+                                 {
+                                     Json::Value root;
+                                     reader->parse(json.data(), json.data() + json.size(), &root, nullptr);
+                                     sink += Xulog::Codec::fromJson(root).format_msg._payload.size(); });
+
+    std::string bin;
+    double bin_enc = codec_case(count, [&](size_t)
+                                {
+                                    bin.clear();
+                                    Xulog::Codec::toBinary(msg, &bin); });
+    double bin_dec = codec_case(count, [&](size_t)
+                                {
+                                    Xulog::WireMsg wire;
+                                    Xulog::Codec::parseBinary(bin.data(), bin.size(), &wire);
+                                    sink += Xulog::Codec::msgFromWire(wire)._payload.size(); });
+    double bin_view = codec_case(count, [&](size_t)
+                                 {
+                                     Xulog::WireMsg wire;
+                                     Xulog::Codec::parseBinary(bin.data(), bin.size(), &wire);
+                                     sink += wire.payload.len; });
+    std::cout << "Json   编码 " << json_enc << " ns/条  解码 " << json_dec << " ns/条  " << json.size() << " 字节/条\n";
+    std::cout << "二进制 编码 " << bin_enc << " ns/条  解码 " << bin_dec << " ns/条（原地解析 " << bin_view
+              << " ns/条）  " << bin.size() << " 字节/条\n";
+    std::cout << "(校验和 " << sink << ")" << std::endl;
+}
+/// @brief 模拟线上日志：少量模板、文件名和日志器，数字字段各不相同
+Xulog::LogMsg sampleMsg(size_t i)
+{
+    static const char *files[] = {"src/order/handler.cc", "src/pay/gateway.cc", "src/cache/client.cc"};
+    static const char *loggers[] = {"order-service", "pay-service", "cache"};
+    char payload[128];
+    switch (i % 3)
+    {
+    case 0:
+        snprintf(payload, sizeof(payload), "order %zu paid amount=%zu.%02zu user=%zu", 100000 + i * 7, i % 997, i % 100, i * 31 % 100003);
+        break;
+    case 1:
+        snprintf(payload, sizeof(payload), "POST /api/v1/payments/%zu 200 %zums upstream=10.0.%zu.%zu", i * 13, i % 250, i % 8, i % 200);
+        break;
+    default:
+        snprintf(payload, sizeof(payload), "cache miss key=sku:%zu ttl=%zus fallback=db", i * 17 % 1000003, i % 600);
+        break;
+    }
+    return Xulog::LogMsg(Xulog::LogLevel::value::INFO, 40 + i % 3 * 37, files[i % 3], loggers[i % 3], payload);
+}
+/// @brief 一批 count 条日志的长度前缀帧
+std::string sampleBatch(size_t from, size_t count)
+{
+    std::string batch;
+    for (size_t i = from; i < from + count; i++)
+    {
+        std::string bin;
+        Xulog::Codec::toBinary(sampleMsg(i), &bin);
+        XuServer::FrameDecoder::encode(bin.data(), bin.size(), &batch);
+    }
+    return batch;
+}
+/// @brief 本机回环发送 count 条日志，统计线上字节数与耗时
+void compress_loopback(const std::string &name, size_t count, const ServerSinkOptions &options,
+                       const Xulog::Inflater::Dictionaries &dicts)
+{
+    std::atomic<size_t> received{0};
+    XuServer::SessionTable sessions;
+    XuServer::TcpServer server(0, [&](XuServer::Buffer &buf, bool *ok, std::shared_ptr<void> *context)
+                               {
+                                   thread_local Xulog::Inflater inflater;
+                                   return sessions.decode(buf, ok, context, [&](const char *data, size_t len)
+                                                          {
+                                                              std::string batch;
+                                                              if (!Xulog::Compression::isCompressed(data, len))
+                                                                  return (void)received.fetch_add(1);
+                                                              if (!inflater.decompress(data, len, dicts, XuServer::FrameDecoder::MAX_FRAME, &batch))
+                                                                  return;
+                                                              XuServer::Buffer in;
+                                                              in.append(batch.data(), batch.size());
+                                                              XuServer::FrameDecoder::decode(in, [&](const char *, size_t)
+                                                                                             { received.fetch_add(1); }); },
+                                                          []() {}); },
+                               1, 1);
+    std::thread loop([&server]()
+                     { server.Loop(); });
+    std::clock_t cpu = std::clock();
+    auto start = std::chrono::steady_clock::now();
+    {
+        ServerSink sink("127.0.0.1", server.Port(), "bench", Xulog::WireFormat::BINARY, options);
+        for (size_t i = 0; i < count; i++)
+            sink.log(nullptr, 0, sampleMsg(i));
+        sink.flush(30 * 1000);
+        std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+        double cpu_sec = double(std::clock() - cpu) / CLOCKS_PER_SEC;
+        std::cout << name << "  收到 " << received.load() << " 条  线上 " << sink.wireBytes() / 1024 << " KB（原始 "
+                  << sink.rawBytes() / 1024 << " KB）  耗时 " << cost.count() << " s  进程 CPU " << cpu_sec << " s\n";
+    }
+    server.Stop();
+    loop.join();
+}
+/// @brief 批量压缩：不同批大小下的压缩比与单批压缩、解压耗时，以及本机回环的线上字节数
+void compress_bench()
+{
+    // 字典用另一段日志训练，与被压缩的数据不重叠
+    std::vector<std::string> samples;
+    for (size_t i = 0; i < 1000; i++)
+    {
+        std::string bin;
+        Xulog::Codec::toBinary(sampleMsg(1000000 + i), &bin);
+        samples.push_back(bin);
+    }
+    std::string dict = Xulog::Compression::trainDictionary(samples);
+    Xulog::Inflater::Dictionaries dicts;
+    dicts[Xulog::Compression::dictionaryId(dict)] = dict;
+    std::cout << "==== compress 字典 " << dict.size() << " 字节 ====" << std::endl;
+
+    const size_t sizes[] = {1024, 4 * 1024, 16 * 1024, 64 * 1024};
+    for (size_t bytes : sizes)
+    {
+        size_t per = bytes / sampleBatch(0, 1).size();
+        std::vector<std::string> batches;
+        size_t raw = 0;
+        for (size_t i = 0; raw < 8 * 1024 * 1024; i += per)
+        {
+            batches.push_back(sampleBatch(i, per));
+            raw += batches.back().size();
+        }
+        Xulog::Deflater plain(1), with_dict(1, dict);
+        Xulog::Inflater inflater;
+        std::string out, back;
+        for (int d = 0; d < 2; d++)
+        {
+            Xulog::Deflater &deflater = d ? with_dict : plain;
+            size_t wire = 0;
+            double enc = codec_case(batches.size(), [&](size_t i)
+                                    {
+                                        out.clear();
+                                        deflater.compress(batches[i].data(), batches[i].size(), &out);
+                                        wire += out.size(); });
+            std::vector<std::string> packed(batches.size());
+            for (size_t i = 0; i < batches.size(); i++)
+                deflater.compress(batches[i].data(), batches[i].size(), &packed[i]);
+            double dec = codec_case(batches.size(), [&](size_t i)
+                                    { inflater.decompress(packed[i].data(), packed[i].size(), dicts, bytes * 2, &back); });
+            std::cout << "批 " << bytes / 1024.0 << " KB（" << per << " 条）" << (d ? " 字典  " : " 无字典")
+                      << "  压缩比 " << double(raw) / wire << "  压缩 " << enc / 1000 << " µs/批（" << enc / per
+                      << " ns/条）  解压 " << dec / 1000 << " µs/批\n";
+        }
+    }
+
+    const size_t count = 200 * 1000;
+    ServerSinkOptions options;
+    options.queue_bytes = 64 * 1024 * 1024;
+    compress_loopback("不压缩    ", count, options, dicts);
+    options.compress_level = 1;
+    compress_loopback("压缩      ", count, options, dicts);
+    options.dictionary = dict;
+    compress_loopback("压缩+字典 ", count, options, dicts);
+    options.batch_bytes = 4 * 1024;
+    compress_loopback("压缩+字典 4KB 批", count, options, dicts);
+    options.dictionary.clear();
+    compress_loopback("压缩 4KB 批      ", count, options, dicts);
+}
+/// @brief 本机回环 UDP 发送一轮，返回耗时与进程 CPU（秒）
+void udp_case(const std::string &name, const std::vector<Xulog::LogMsg> &msgs, const UdpSinkOptions &options)
+{
+    std::atomic<size_t> received{0};
+    XuServer::UdpServer server(0, [&](const char *, size_t)
+                               { received.fetch_add(1); });
+    std::thread loop([&server]()
+                     { server.Loop(); });
+    std::clock_t cpu = std::clock();
+    auto start = std::chrono::steady_clock::now();
+    UdpSink sink("127.0.0.1", server.Port(), Xulog::WireFormat::BINARY, options);
+    for (auto &msg : msgs)
+        sink.log(nullptr, 0, msg);
+    sink.flush(30 * 1000);
+    std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+    double cpu_sec = double(std::clock() - cpu) / CLOCKS_PER_SEC;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100)); // 等服务端收完内核缓冲中的数据报
+    server.Stop();
+    loop.join();
+    std::cout << name << "  耗时 " << cost.count() << " s  进程 CPU " << cpu_sec << " s  送达 " << received.load()
+              << " 条  数据报 " << sink.datagrams() << std::endl;
+}
+/// @brief 本机回环：TCP（ServerSink，带确认）与 UDP（UdpSink）发送同样的日志，比较耗时、CPU 与送达条数
+void udp_bench()
+{
+    const size_t count = 500 * 1000;
+    std::vector<Xulog::LogMsg> msgs;
+    for (size_t i = 0; i < count; i++)
+        msgs.push_back(sampleMsg(i));
+    std::cout << "==== udp " << count << " 条（预先生成，只计发送）====" << std::endl;
+    {
+        std::atomic<size_t> received{0};
+        XuServer::SessionTable sessions;
+        XuServer::TcpServer server(0, [&](XuServer::Buffer &buf, bool *ok, std::shared_ptr<void> *context)
+                                   { return sessions.decode(buf, ok, context, [&](const char *, size_t)
+                                                            { received.fetch_add(1); },
+                                                            []() {}); },
+                                   1, 1);
+        std::thread loop([&server]()
+                         { server.Loop(); });
+        std::clock_t cpu = std::clock();
+        auto start = std::chrono::steady_clock::now();
+        {
+            ServerSinkOptions options;
+            options.queue_bytes = 128 * 1024 * 1024;
+            ServerSink sink("127.0.0.1", server.Port(), "bench", Xulog::WireFormat::BINARY, options);
+            for (auto &msg : msgs)
+                sink.log(nullptr, 0, msg);
+            sink.flush(30 * 1000);
+            std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+            double cpu_sec = double(std::clock() - cpu) / CLOCKS_PER_SEC;
+            std::cout << "TCP ServerSink     耗时 " << cost.count() << " s  进程 CPU " << cpu_sec << " s  送达 "
+                      << received.load() << " 条" << std::endl;
+        }
+        server.Stop();
+        loop.join();
+    }
+    UdpSinkOptions options;
+    options.queue_bytes = 128 * 1024 * 1024;
+    udp_case("UDP 1400B 数据报 ", msgs, options);
+    options.datagram_bytes = 8 * 1024;
+    udp_case("UDP 8KB 数据报   ", msgs, options);
+}
+/// @brief 本机回环：多个客户端同时发送，服务端逐条解码并格式化，比较不同线程模型的接收耗时
+/// @param threads 工作线程数，0 表示在事件循环线程上直接处理
+/// @param loops 事件循环数
+/// @param reuse_port 是否分片监听
+void shards_case(const std::string &name, const std::vector<std::string> &batches, size_t clients, size_t count,
+                 int threads, int loops, bool reuse_port)
+{
+    std::atomic<size_t> received{0};
+    XuServer::TcpServer server(0, [&](XuServer::Buffer &buf, bool *ok)
+                               {
+                                   thread_local Xulog::Formatter formatter;
+                                   *ok = XuServer::FrameDecoder::decode(buf, [&](const char *data, size_t len)
+                                                                        {
+                                                                            Xulog::WireMsg wire;
+                                                                            if (!Xulog::Codec::parseBinary(data, len, &wire))
+                                                                                return;
+                                                                            Xulog::LogMsg msg = Xulog::Codec::msgFromWire(wire);
+                                                                            std::string line = formatter.Format(msg);
+                                                                            received.fetch_add(1, std::memory_order_relaxed); });
+                                   return std::string(); },
+                               threads, loops, reuse_port);
+    std::thread loop([&server]()
+                     { server.Loop(); });
+    std::vector<int> fds;
+    for (size_t c = 0; c < clients; c++)
+    {
+        XuServer::TcpSocket sock;
+        std::string ip = "127.0.0.1";
+        sock.BuildConnectSockedMethod(ip, server.Port());
+        fds.push_back(sock.GetSockFd());
+    }
+    std::clock_t cpu = std::clock();
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> senders;
+    for (size_t c = 0; c < clients; c++)
+        senders.emplace_back([&, c]()
+                             {
+                                 XuServer::TcpSocket sock(fds[c]);
+                                 for (auto &batch : batches)
+                                     sock.SendAll(batch.data(), batch.size()); });
+    for (auto &t : senders)
+        t.join();
+    while (received.load() < clients * count)
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+    double cpu_sec = double(std::clock() - cpu) / CLOCKS_PER_SEC;
+    for (int fd : fds)
+        ::close(fd);
+    server.Stop();
+    loop.join();
+    std::cout << name << "  耗时 " << cost.count() << " s  进程 CPU " << cpu_sec << " s  "
+              << size_t(clients * count / cost.count()) << " 条/秒" << std::endl;
+}
+/// @brief 线程池模型与 SO_REUSEPORT 分片模型的接收吞吐
+void shards_bench()
+{
+    const size_t clients = 8, count = 100 * 1000, per_batch = 500;
+    std::vector<std::string> batches;
+    for (size_t i = 0; i < count; i += per_batch)
+    {
+        std::string batch;
+        for (size_t j = i; j < i + per_batch; j++)
+        {
+            std::string bin;
+            Xulog::Codec::toBinary(sampleMsg(j), &bin);
+            XuServer::FrameDecoder::encode(bin.data(), bin.size(), &batch);
+        }
+        batches.push_back(batch);
+    }
+    size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "==== shards " << clients << " 个客户端 x " << count << " 条，" << cores << " 核 ====" << std::endl;
+    shards_case("1 循环 + 1 工作线程    ", batches, clients, count, 1, 1, false);
+    shards_case("1 循环 + N 工作线程    ", batches, clients, count, cores, 1, false);
+    shards_case("N 分片 SO_REUSEPORT    ", batches, clients, count, 0, cores, true);
+}
+const size_t ACKS_CLIENTS = 4; ///< acks 模式的客户端数
+/// @brief 本机回环：ServerSink 发送，服务端逐条写入数据库落地，比较确认关闭、每次读取都提交后确认、批量确认的吞吐
+/// @param acks 客户端是否请求确认
+/// @param policy 服务端确认策略
+/// @param paced 为 true 时每个客户端每写 20 条休眠 1ms，模拟未打满的日常流量
+void acks_case(const std::string &name, const std::vector<Xulog::LogMsg> &msgs, bool acks, const XuServer::AckPolicy &policy,
+               bool paced)
+{
+    std::string dbfile = "./log/bench-acks.db";
+    ::unlink(dbfile.c_str());
+    ::unlink((dbfile + "-wal").c_str());
+    ::unlink((dbfile + "-shm").c_str());
+    DataBaseSink db(dbfile, "server");
+    std::atomic<size_t> received{0}, commits{0};
+    XuServer::SessionTable sessions;
+    XuServer::TcpServer server(0, [&](XuServer::Buffer &buf, bool *ok, std::shared_ptr<void> *context)
+                               { return sessions.decode(buf, ok, context, [&](const char *data, size_t len)
+                                                        {
+                                                            Xulog::WireMsg wire;
+                                                            if (!Xulog::Codec::parseBinary(data, len, &wire))
+                                                                return;
+                                                            db.log(Xulog::Codec::msgFromWire(wire));
+                                                            received.fetch_add(1, std::memory_order_relaxed); },
+                                                        [&]()
+                                                        {
+                                                            db.flush();
+                                                            commits.fetch_add(1, std::memory_order_relaxed); },
+                                                        XuServer::FrameDecoder::MAX_FRAME, policy); },
+                               1, 1);
+    std::thread loop([&server]()
+                     { server.Loop(); });
+    std::clock_t cpu = std::clock();
+    auto start = std::chrono::steady_clock::now();
+    // 多个客户端各自小批发送：服务端每次读到的数据少，逐次提交时提交次数最多
+    std::vector<std::thread> clients;
+    for (size_t c = 0; c < ACKS_CLIENTS; c++)
+        clients.emplace_back([&, c]()
+                             {
+                                 ServerSinkOptions options;
+                                 options.acks = acks;
+                                 options.batch_bytes = 4 * 1024;
+                                 options.flush_ms = 1;
+                                 options.queue_bytes = 128 * 1024 * 1024;
+                                 ServerSink sink("127.0.0.1", server.Port(), "bench", Xulog::WireFormat::BINARY, options);
+                                 for (size_t i = c, n = 0; i < msgs.size(); i += ACKS_CLIENTS)
+                                 {
+                                     sink.log(nullptr, 0, msgs[i]);
+                                     if (paced && ++n % 20 == 0)
+                                         std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                                 } 
+                                 sink.flush(60 * 1000); });
+    for (auto &t : clients)
+        t.join();
+    // 确认关闭时客户端发完即返回：等服务端全部写入并提交，三种情况都计到数据落盘为止
+    while (received.load() < msgs.size())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    db.flush();
+    std::chrono::duration<double> cost = std::chrono::steady_clock::now() - start;
+    double cpu_sec = double(std::clock() - cpu) / CLOCKS_PER_SEC;
+    server.Stop();
+    loop.join();
+    std::cout << name << "  耗时 " << cost.count() << " s  " << size_t(msgs.size() / cost.count())
+              << " 条/秒  进程 CPU " << cpu_sec << " s  确认触发的提交 " << commits.load() << " 次" << std::endl;
+}
+/// @brief ServerSink 吞吐：确认关闭、逐次提交确认、批量确认；分别在打满与限速两种流量下测量
+void acks_bench()
+{
+    XuServer::AckPolicy eager;
+    eager.frames = 1;
+    eager.ms = 0;
+    Xulog::Util::File::createDirectory("./log");
+    const size_t counts[] = {200 * 1000, 40 * 1000};
+    for (size_t count : counts)
+    {
+        bool paced = count < 200 * 1000;
+        std::vector<Xulog::LogMsg> msgs;
+        for (size_t i = 0; i < count; i++)
+            msgs.push_back(sampleMsg(i));
+        std::cout << "==== acks " << ACKS_CLIENTS << " 个客户端共 " << count << " 条，4KB 小批，" << (paced ? "限速" : "打满")
+                  << "，服务端写数据库落地（batch_rows=1000 batch_ms=200）====" << std::endl;
+        acks_case("确认关闭                 ", msgs, false, XuServer::AckPolicy(), paced);
+        acks_case("确认开启，每次读取都提交 ", msgs, true, eager, paced);
+        acks_case("确认开启，批量确认       ", msgs, true, XuServer::AckPolicy(), paced);
+    }
+}
+int main(int argc, char *argv[])
+{
+    std::string mode = argc > 1 ? argv[1] : "async";
+    if (mode == "sync")
+        sync_bench();
+    else if (mode == "scaling")
+        sync_scaling_bench();
+    else if (mode == "db")
+        db_bench();
+    else if (mode == "codec")
+        codec_bench();
+    else if (mode == "compress")
+        compress_bench();
+    else if (mode == "udp")
+        udp_bench();
+    else if (mode == "shards")
+        shards_bench();
+    else if (mode == "acks")
+        acks_bench();
+    else
+        async_bench();
     return 0;
 }
\ No newline at end of file
@@ -15,6 +15,61 @@
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <sqlite3.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @struct SqliteProfile
+ * @brief SQLite 存储参数，打开数据库后以 PRAGMA 形式应用
+ *
+ * 默认使用 WAL + synchronous=NORMAL：查询工具读库时不阻塞落库写者，
+ * 每次提交只写 WAL 不做 fsync，只在检查点时同步，掉电最多丢失最近几个事务。
+ * legacy() 为 SQLite 出厂设置（回滚日志 + FULL），用于对比或要求每次提交都落盘的场景。
+ */
+struct SqliteProfile
+{
+    std::string journal_mode = "WAL";          ///< DELETE / TRUNCATE / PERSIST / MEMORY / WAL / OFF
+    std::string synchronous = "NORMAL";        ///< OFF / NORMAL / FULL / EXTRA
+    int page_size = 4096;                      ///< 页大小（字节），只对新建的库生效
+    int cache_size = -16384;                   ///< 页缓存，正数为页数，负数为 KiB
+    long long mmap_size = 256LL * 1024 * 1024; ///< 内存映射读取上限（字节），0 关闭
+    int wal_autocheckpoint = 1000;             ///< WAL 达到多少页时自动检查点，0 关闭
+    long long journal_size_limit = 64LL * 1024 * 1024; ///< 检查点后 WAL 文件截断到的上限（字节）
+    int busy_timeout_ms = 5000;                ///< 遇到锁时的等待时间（毫秒）
+
+    /// @brief SQLite 出厂设置
+    static SqliteProfile legacy()
+    {
+        SqliteProfile p;
+        p.journal_mode = "DELETE";
+        p.synchronous = "FULL";
+        p.cache_size = -2000;
+        p.mmap_size = 0;
+        p.journal_size_limit = -1;
+        return p;
+    }
+    /// @brief 检查枚举型取值，避免把任意字符串拼进 PRAGMA
+    bool valid() const
+    {
+        static const char *JOURNAL[] = {"DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF"};
+        static const char *SYNC[] = {"OFF", "NORMAL", "FULL", "EXTRA"};
+        bool j = false, s = false;
+        for (auto m : JOURNAL)
+            j = j || journal_mode == m;
+        for (auto m : SYNC)
+            s = s || synchronous == m;
+        return j && s;
+    }
+};
 
 /**
  * @class SqliteHelper
@@ -90,6 +145,26 @@ public:
         }
         return true;
     }
+    /**
+     * @brief 执行只返回一个整数的查询
+     * @param sql 查询语句
+     * @param out 查询结果，无结果行时不修改
+     * @return 成功返回 true，失败返回 false
+     */
+    bool queryInt(const std::string &sql, long long *out)
+    {
+        sqlite3_stmt *stmt = nullptr;
+        if (sqlite3_prepare_v2(_handler, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+        {
+            std::cout << sql.c_str() << "--查询失败: " << sqlite3_errmsg(_handler) << std::endl;
+            return false;
+        }
+        int rc = sqlite3_step(stmt);
+        if (rc == SQLITE_ROW)
+            *out = sqlite3_column_int64(stmt, 0);
+        sqlite3_finalize(stmt);
+        return rc == SQLITE_ROW || rc == SQLITE_DONE;
+    }
     /**
      * @brief 关闭数据库
      *
@@ -97,43 +172,180 @@ public:
      */
     void close()
     {
+        for (auto &kv : _stmts)
+            sqlite3_finalize(kv.second);
+        _stmts.clear();
         sqlite3_close_v2(_handler);
+        _handler = nullptr;
+    }
+    /**
+     * @brief 应用存储参数
+     * @param profile 存储参数
+     * @return 成功返回 true，失败返回 false
+     *
+     * page_size 必须在建表之前设置才会生效，因此应在 open() 之后立即调用。
+     */
+    bool applyProfile(const SqliteProfile &profile)
+    {
+        if (!profile.valid())
+        {
+            std::cout << "非法的 SQLite 参数: journal_mode=" << profile.journal_mode
+                      << " synchronous=" << profile.synchronous << std::endl;
+            return false;
+        }
+        sqlite3_busy_timeout(_handler, profile.busy_timeout_ms);
+        std::string sql = "PRAGMA page_size=" + std::to_string(profile.page_size) + ";" +
+                          "PRAGMA journal_mode=" + profile.journal_mode + ";" +
+                          "PRAGMA synchronous=" + profile.synchronous + ";" +
+                          "PRAGMA cache_size=" + std::to_string(profile.cache_size) + ";" +
+                          "PRAGMA mmap_size=" + std::to_string(profile.mmap_size) + ";" +
+                          "PRAGMA wal_autocheckpoint=" + std::to_string(profile.wal_autocheckpoint) + ";" +
+                          "PRAGMA journal_size_limit=" + std::to_string(profile.journal_size_limit) + ";";
+        return exec(sql, nullptr, nullptr);
+    }
+    /**
+     * @brief 开启事务
+     * @return 成功返回 true，失败返回 false
+     */
+    bool begin()
+    {
+        return exec("BEGIN;", nullptr, nullptr);
+    }
+    /**
+     * @brief 提交事务
+     * @return 成功返回 true，失败返回 false
+     */
+    bool commit()
+    {
+        return exec("COMMIT;", nullptr, nullptr);
     }
     /**
      * @brief 以参数绑定方式插入一条日志，避免 SQL 注入与单引号崩溃
      * @return 成功返回 true，失败返回 false
+     *
+     * 语句只在首次调用时 prepare，之后用 sqlite3_reset 复用。
+     * time_us 为 UTC 纪元微秒，其余 *_ref 为维度表中的 id。
      */
     bool insertLog(const std::string &sql,
-                   long long ctime, long long line, const std::string &tid,
-                   const std::string &level, const std::string &file,
-                   const std::string &logger, const std::string &payload)
+                   long long time_us, long long line, long long thread_ref,
+                   long long level_ref, long long file_ref,
+                   long long logger_ref, const std::string &payload)
     {
+        sqlite3_stmt *stmt = prepared(sql);
+        if (stmt == nullptr)
+            return false;
+        sqlite3_bind_int64(stmt, 1, time_us);
+        sqlite3_bind_int64(stmt, 2, line);
+        sqlite3_bind_int64(stmt, 3, thread_ref);
+        sqlite3_bind_int64(stmt, 4, level_ref);
+        sqlite3_bind_int64(stmt, 5, file_ref);
+        sqlite3_bind_int64(stmt, 6, logger_ref);
+        sqlite3_bind_text(stmt, 7, payload.c_str(), (int)payload.size(), SQLITE_STATIC);
+        return stepOnce(stmt) == SQLITE_DONE;
+    }
+    /**
+     * @brief 执行只绑定整数参数的语句（语句缓存复用）
+     * @param sql 带 ?1.. 占位符的语句
+     * @param args 依次绑定的参数
+     * @return 成功返回 true，失败返回 false
+     */
+    bool execInts(const std::string &sql, std::initializer_list<long long> args)
+    {
+        sqlite3_stmt *stmt = prepared(sql);
+        if (stmt == nullptr)
+            return false;
+        int idx = 1;
+        for (long long v : args)
+            sqlite3_bind_int64(stmt, idx++, v);
+        return stepOnce(stmt) == SQLITE_DONE;
+    }
+    /**
+     * @brief 在维度表中查找名称对应的 id，不存在则插入
+     * @param table 维度表名（调用方保证是内部常量）
+     * @param name 名称
+     * @param id 输出 id
+     * @return 成功返回 true，失败返回 false
+     */
+    bool intern(const std::string &table, const std::string &name, long long *id)
+    {
+        sqlite3_stmt *sel = prepared("SELECT id FROM " + table + " WHERE name=?1;");
+        sqlite3_stmt *ins = prepared("INSERT OR IGNORE INTO " + table + " (name) VALUES (?1);");
+        if (sel == nullptr || ins == nullptr)
+            return false;
+        for (int round = 0; round < 2; round++)
+        {
+            sqlite3_bind_text(sel, 1, name.c_str(), (int)name.size(), SQLITE_STATIC);
+            if (sqlite3_step(sel) == SQLITE_ROW)
+            {
+                *id = sqlite3_column_int64(sel, 0);
+                sqlite3_reset(sel);
+                sqlite3_clear_bindings(sel);
+                return true;
+            }
+            sqlite3_reset(sel);
+            sqlite3_clear_bindings(sel);
+            sqlite3_bind_text(ins, 1, name.c_str(), (int)name.size(), SQLITE_STATIC);
+            if (stepOnce(ins) != SQLITE_DONE)
+                return false;
+        }
+        return false;
+    }
+
+private:
+    /// @brief 取缓存的预编译语句，首次使用时 prepare
+    sqlite3_stmt *prepared(const std::string &sql)
+    {
+        auto it = _stmts.find(sql);
+        if (it != _stmts.end())
+            return it->second;
         sqlite3_stmt *stmt = nullptr;
         if (sqlite3_prepare_v2(_handler, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
         {
             std::cout << "prepare 失败: " << sqlite3_errmsg(_handler) << std::endl;
-            return false;
+            return nullptr;
         }
-        sqlite3_bind_int64(stmt, 1, ctime);
-        sqlite3_bind_int64(stmt, 2, line);
-        sqlite3_bind_text(stmt, 3, tid.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 4, level.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 5, file.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 6, logger.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 7, payload.c_str(), -1, SQLITE_TRANSIENT);
-        bool ok = (sqlite3_step(stmt) == SQLITE_DONE);
-        if (!ok)
+        _stmts.emplace(sql, stmt);
+        return stmt;
+    }
+    /// @brief 执行一次并复位语句，返回 sqlite3_step 的结果
+    int stepOnce(sqlite3_stmt *stmt)
+    {
+        int rc = sqlite3_step(stmt);
+        if (rc != SQLITE_DONE && rc != SQLITE_ROW)
             std::cout << "step 失败: " << sqlite3_errmsg(_handler) << std::endl;
-        sqlite3_finalize(stmt);
-        return ok;
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+        return rc;
     }
 
-private:
-    std::string _dbfile; ///< 数据库文件路径
-    sqlite3 *_handler;   ///< SQLite 数据库句柄
+    std::string _dbfile;                                    ///< 数据库文件路径
+    sqlite3 *_handler;                                      ///< SQLite 数据库句柄
+    std::unordered_map<std::string, sqlite3_stmt *> _stmts; ///< 预编译语句缓存
+};
+
+/// @brief 数据库分区粒度
+enum class DBPartition
+{
+    NONE, ///< 不分区，所有日志写入同一个库
+    HOUR, ///< 每小时一个库文件
+    DAY   ///< 每天一个库文件
 };
 
 /// @brief 数据库落地类
+///
+/// 插入按组提交：攒满 batch_rows 条、距事务开始超过 batch_ms 毫秒或遇到 ERROR 及以上等级时 COMMIT，
+/// 把每行一次 fsync 摊薄为每批一次。时间窗口在写入时检查；不启用写线程时另有一个提交线程，
+/// 写入停下后由它在事务开始 batch_ms 毫秒后提交尾批，单条日志之后长时间没有新日志也不会一直不可见。
+///
+/// 按时间分区时 dbfile 是清单库，只有一张 log_partitions 表记录各分区文件及其时间范围（按本地时区切分），
+/// 日志写入同目录下的 <名称>.<YYYYMMDD[HH]>.db。各分区的 id 从分区起始时间（纪元微秒）开始递增，
+/// 因此 id 在所有分区间唯一且与时间同序；清理过期日志只需从清单删除并 unlink 文件。
+/// 最近写入的几个分区保持打开，各自攒批提交，多个客户端时钟不一致或补发旧日志时不会每行重开分区；
+/// 所属分区已被保留策略删除（或一建立就会被删除）的迟到日志直接丢弃并计数（expiredRows()），不重建分区文件。
+///
+/// queue_rows 大于 0 时启用写线程：日志只拷贝进有界队列，由单一写线程成组插入并提交，
+/// 同步日志器的业务线程不再在 sqlite3_step 上排队；队列满时写入方等待（不丢日志）。
+/// 此时 ERROR 也不再同步落盘，需要持久化保证的调用方使用 flush() 作为屏障。
 class DataBaseSink : public Xulog::LogSink
 {
 public:
@@ -141,27 +353,81 @@ public:
     /// @brief 数据库落地类构造函数
     /// @param dbfile 数据库文件路径
     /// @param name 日志器名称
-    DataBaseSink(const std::string &dbfile, const std::string &name)
-        : _helper(dbfile), _logger_name(name)
+    /// @param batch_rows 每个事务最多包含的行数，1 表示逐行提交
+    /// @param batch_ms 每个事务最长持续时间（毫秒）
+    /// @param profile 存储参数
+    /// @param full_text 是否维护 FTS5 全文索引 logs_fts，供关键词检索使用
+    /// @param partition 分区粒度，NONE 时 dbfile 即日志库，否则为分区清单
+    /// @param max_partitions 最多保留的分区数，超出时删除最旧的分区文件，0 表示不限
+    /// @param queue_rows 写线程队列容量（条），0 表示不启用写线程、在调用线程中直接插入
+    DataBaseSink(const std::string &dbfile, const std::string &name,
+                 size_t batch_rows = 1000, size_t batch_ms = 200,
+                 const SqliteProfile &profile = SqliteProfile(), bool full_text = false,
+                 DBPartition partition = DBPartition::NONE, size_t max_partitions = 0,
+                 size_t queue_rows = 0)
+        : _logger_name(name), _batch_rows(batch_rows ? batch_rows : 1), _batch_ms(batch_ms),
+          _full_text(full_text), _profile(profile), _manifest(dbfile), _partition(partition),
+          _max_partitions(max_partitions), _queue_rows(queue_rows)
     {
-        if (!Xulog::Util::File::exists(dbfile))
+        size_t pos = dbfile.find_last_of('/');
+        _dir = pos == std::string::npos ? "" : dbfile.substr(0, pos + 1);
+        _base = dbfile.substr(_dir.size());
+        if (_partition == DBPartition::NONE)
         {
-            std::string path = Xulog::Util::File::path(dbfile);
-            Xulog::Util::File::createDirectory(path);
-            Xulog::Util::File::createFile(dbfile);
+            _files.emplace_back(new DBFile(dbfile));
+            _cur = _files.front().get();
+            openFile(_cur->helper, dbfile);
+            createTable();
         }
-        assert(_helper.open());
-        createTable();
+        else
+        {
+            openFile(_manifest, dbfile);
+            if (!_manifest.exec(std::string(CREATE_MANIFEST) + "PRAGMA user_version=" + std::to_string(SCHEMA_VERSION) + ";",
+                                nullptr, nullptr))
+            {
+                ERROR("创建分区清单失败!");
+                abort();
+            }
+        }
+        if (_queue_rows > 0)
+            _writer = std::thread(&DataBaseSink::writerLoop, this);
+        else if (_batch_rows > 1 && _batch_ms > 0)
+            _committer = std::thread(&DataBaseSink::committerLoop, this);
     }
-    /// @brief 用于创建日志表
+    /// @brief 当前表结构版本，记录在 PRAGMA user_version 中
+    ///
+    /// v1：log_time 为 datetime(?, 'unixepoch', '+8 hours') 生成的 TEXT，无索引（user_version 为 0）
+    /// v2：log_time 为 UTC 纪元微秒 INTEGER，带时间、等级+时间、日志器+时间三个索引
+    /// v3：线程/等级/文件/日志器字典编码到维度表，事实表 log_records 只存整数 id；
+    ///     同名视图 logs 连接回原来的列，查询侧 SQL 不变
+    /// v4：增加按分钟的计数汇总表 log_rollup_minute（分钟 × 等级 × 日志器），统计查询不再扫描原始行
+    static constexpr int SCHEMA_VERSION = 4;
+
+    /// @brief 用于创建日志表；已有旧版本表时原地逐级迁移
     void createTable()
     {
-        const char *CREATE_TABLE = "CREATE TABLE IF NOT EXISTS logs (id INTEGER PRIMARY KEY AUTOINCREMENT, log_time TIMESTAMP NOT NULL,\
-                                    line_number INT, thread_id VARCHAR(255), log_level VARCHAR(10) NOT NULL,\
-                                    source_file VARCHAR(255), logger_name VARCHAR(255),message TEXT);";
-        bool ret = _helper.exec(CREATE_TABLE, nullptr, nullptr);
+        long long old_table = 0, version = 0, fts = 0;
+        bool ret = _cur->helper.queryInt("SELECT COUNT(*) FROM sqlite_master WHERE type='table' AND name='logs';", &old_table) &&
+                   _cur->helper.queryInt("PRAGMA user_version;", &version);
+        if (ret && old_table > 0 && version < 2)
+            ret = migrateV1();
+        if (ret && old_table > 0)
+            ret = migrateV2();
+        else if (ret && version < 3)
+            ret = _cur->helper.exec(std::string("BEGIN;") + CREATE_TABLES_V3 + CREATE_INDEXES_V3 + CREATE_VIEW_V3 +
+                                   "PRAGMA user_version=3;COMMIT;",
+                               nullptr, nullptr);
+        if (ret)
+            ret = _cur->helper.queryInt("PRAGMA user_version;", &version);
+        if (ret && version < 4)
+            ret = migrateV3();
+        if (ret)
+            ret = _cur->helper.queryInt("SELECT COUNT(*) FROM sqlite_master WHERE name='logs_fts';", &fts);
+        if (ret && (_full_text || fts > 0))
+            ret = createFullText(fts > 0);
         if (ret == false)
         {
+            _cur->helper.exec("ROLLBACK;", nullptr, nullptr);
             ERROR("创建日志数据库表失败!");
             abort();
         }
@@ -169,37 +435,623 @@ public:
     /// @brief 结构化落地：接收调用链传入的 LogMsg，用参数绑定避免 SQL 注入
     void log(const char *data, size_t len, const Xulog::LogMsg &msg) override
     {
-        insertLog(msg);
+        if (_queue_rows > 0)
+            enqueue(msg);
+        else
+            insertLog(msg);
     }
     /// @brief 字节落地兜底：无 LogMsg 时跳过落库（正常路径不走这里）
     void log(const char *data, size_t len) override {}
     /// @brief 服务端直接传入 LogMsg 落库（保留给 serverlog.hpp 使用）
     void log(const Xulog::LogMsg &msg)
     {
+        if (_queue_rows > 0)
+            return enqueue(msg);
+        std::unique_lock<std::mutex> lock(mutex());
         insertLog(msg);
     }
-    ~DataBaseSink() {}
+    /// @brief 启用写线程时队列自带互斥，同步日志器无需再为其加锁
+    bool threadSafe() const override { return _queue_rows > 0; }
+    /// @brief 持久化屏障：返回时此前写入的日志均已提交
+    void flush()
+    {
+        if (_queue_rows == 0)
+        {
+            std::unique_lock<std::mutex> lock(mutex());
+            commitBatch();
+            return;
+        }
+        std::unique_lock<std::mutex> lock(_queue_mutex);
+        uint64_t target = _pushed;
+        if (_flush_target < target)
+            _flush_target = target;
+        _not_empty.notify_one();
+        _flushed.wait(lock, [&]()
+                      { return _committed >= target; });
+    }
+    /// @brief 因所属分区已被保留策略删除而丢弃的迟到日志条数
+    size_t expiredRows()
+    {
+        std::unique_lock<std::mutex> lock(mutex());
+        return _expired_rows;
+    }
+    /// @brief 删除结束时间不晚于 cutoff 的分区（当前正在写入的分区除外）
+    /// @param cutoff 截止时间（纪元秒）
+    /// @return 删除的分区数，未分区时为 0
+    size_t dropPartitionsBefore(time_t cutoff)
+    {
+        std::unique_lock<std::mutex> lock(mutex());
+        if (_partition == DBPartition::NONE)
+            return 0;
+        return dropPartitions("SELECT file, end_us FROM log_partitions WHERE end_us <= " +
+                              std::to_string((long long)cutoff * 1000000) + ";");
+    }
+    ~DataBaseSink()
+    {
+        if (_writer.joinable())
+        {
+            {
+                std::unique_lock<std::mutex> lock(_queue_mutex);
+                _stop = true;
+            }
+            _not_empty.notify_one();
+            _writer.join(); // 写线程退出前写完队列并提交
+        }
+        if (_committer.joinable())
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex());
+                _closing = true;
+            }
+            _txn_open.notify_one();
+            _committer.join();
+        }
+        commitBatch();
+        for (auto &file : _files)
+            file->helper.close();
+        _manifest.close();
+    }
 
 private:
+    static constexpr size_t LEVEL_SLOTS = 8;         ///< 等级 id 直接按枚举值下标缓存
+    static constexpr size_t MAX_OPEN_PARTITIONS = 4; ///< 同时保持打开的分区数，各自攒批
+    using RollupKey = std::tuple<long long, long long, long long>; ///< (分钟, 等级 id, 日志器 id)
+
+    /// @brief 一个打开的库文件及其未提交的批次；维度 id 只在同一个库文件内有效，缓存随文件走
+    struct DBFile
+    {
+        explicit DBFile(const std::string &path) : helper(path) {}
+
+        SqliteHelper helper;         ///< 库文件句柄
+        std::string file;            ///< 分区文件名（相对清单目录），不分区时为空
+        long long start_us = 0;      ///< 分区起始时间（含）
+        long long end_us = 0;        ///< 分区结束时间（不含）
+        size_t pending = 0;          ///< 当前事务中未提交的行数
+        uint64_t txn_start = 0;      ///< 当前事务开始时间（毫秒）
+        std::thread::id last_tid;    ///< 上一行的线程 ID
+        long long thread_ref = -1;   ///< 上一行线程的维度 id，同一线程连续写入时免去格式化与查表
+        long long level_refs[LEVEL_SLOTS] = {-1, -1, -1, -1, -1, -1, -1, -1}; ///< 等级 → 维度 id
+        std::unordered_map<std::string, long long> level_name_refs; ///< 等级名称缓存
+        std::unordered_map<std::string, long long> thread_refs;     ///< 线程 ID 文本缓存
+        std::unordered_map<std::string, long long> file_refs;       ///< 源文件缓存
+        std::unordered_map<std::string, long long> logger_refs;     ///< 日志器缓存
+        std::map<RollupKey, long long> rollup; ///< 当前事务中各汇总键新增的条数，提交前写入汇总表
+        RollupKey rollup_key;                  ///< 上一次累加的键
+        long long *rollup_hit = nullptr;       ///< 上一次累加的计数
+    };
+
+    static constexpr const char *CREATE_TABLE_V2 =
+        "CREATE TABLE IF NOT EXISTS logs (id INTEGER PRIMARY KEY AUTOINCREMENT, log_time INTEGER NOT NULL,"
+        "line_number INT, thread_id VARCHAR(255), log_level VARCHAR(10) NOT NULL,"
+        "source_file VARCHAR(255), logger_name VARCHAR(255), message TEXT);";
+    static constexpr const char *CREATE_INDEXES_V2 =
+        "CREATE INDEX IF NOT EXISTS idx_logs_time ON logs(log_time);"
+        "CREATE INDEX IF NOT EXISTS idx_logs_level_time ON logs(log_level, log_time);"
+        "CREATE INDEX IF NOT EXISTS idx_logs_logger_time ON logs(logger_name, log_time);";
+    static constexpr const char *CREATE_TABLES_V3 =
+        "CREATE TABLE IF NOT EXISTS log_levels (id INTEGER PRIMARY KEY, name TEXT NOT NULL UNIQUE);"
+        "CREATE TABLE IF NOT EXISTS log_loggers (id INTEGER PRIMARY KEY, name TEXT NOT NULL UNIQUE);"
+        "CREATE TABLE IF NOT EXISTS log_files (id INTEGER PRIMARY KEY, name TEXT NOT NULL UNIQUE);"
+        "CREATE TABLE IF NOT EXISTS log_threads (id INTEGER PRIMARY KEY, name TEXT NOT NULL UNIQUE);"
+        "CREATE TABLE IF NOT EXISTS log_records (id INTEGER PRIMARY KEY AUTOINCREMENT, log_time INTEGER NOT NULL,"
+        "line_number INT, thread_ref INTEGER NOT NULL, level_ref INTEGER NOT NULL,"
+        "file_ref INTEGER NOT NULL, logger_ref INTEGER NOT NULL, message TEXT);";
+    static constexpr const char *CREATE_INDEXES_V3 =
+        "CREATE INDEX IF NOT EXISTS idx_records_time ON log_records(log_time);"
+        "CREATE INDEX IF NOT EXISTS idx_records_level_time ON log_records(level_ref, log_time);"
+        "CREATE INDEX IF NOT EXISTS idx_records_logger_time ON log_records(logger_ref, log_time);";
+    /// 内连接便于优化器先按名称查出维度 id，再走事实表上的 (ref, log_time) 索引
+    static constexpr const char *CREATE_VIEW_V3 =
+        "CREATE VIEW IF NOT EXISTS logs AS SELECT r.id AS id, r.log_time AS log_time, r.line_number AS line_number,"
+        "t.name AS thread_id, l.name AS log_level, f.name AS source_file, g.name AS logger_name, r.message AS message "
+        "FROM log_records r JOIN log_levels l ON l.id = r.level_ref JOIN log_threads t ON t.id = r.thread_ref "
+        "JOIN log_files f ON f.id = r.file_ref JOIN log_loggers g ON g.id = r.logger_ref;";
+    /// 分钟汇总：minute 为 UTC 纪元分钟；计数由写入端在提交前按批累加，删除原始行时由触发器扣减
+    static constexpr const char *CREATE_ROLLUP =
+        "CREATE TABLE IF NOT EXISTS log_rollup_minute (minute INTEGER NOT NULL, level_ref INTEGER NOT NULL,"
+        "logger_ref INTEGER NOT NULL, count INTEGER NOT NULL, PRIMARY KEY (minute, level_ref, logger_ref)) WITHOUT ROWID;"
+        "CREATE TRIGGER IF NOT EXISTS log_rollup_ad AFTER DELETE ON log_records BEGIN "
+        "UPDATE log_rollup_minute SET count = count - 1 WHERE minute = old.log_time / 60000000 "
+        "AND level_ref = old.level_ref AND logger_ref = old.logger_ref; END;";
+    /// FTS5 外部内容表：只存倒排索引，正文经视图 logs 读取；触发器随插入同步，与主表同一事务提交
+    static constexpr const char *CREATE_FULL_TEXT =
+        "CREATE VIRTUAL TABLE logs_fts USING fts5(message, content='logs', content_rowid='id');";
+    static constexpr const char *CREATE_FULL_TEXT_TRIGGERS =
+        "CREATE TRIGGER IF NOT EXISTS logs_fts_ai AFTER INSERT ON log_records BEGIN "
+        "INSERT INTO logs_fts(rowid, message) VALUES (new.id, new.message); END;"
+        "CREATE TRIGGER IF NOT EXISTS logs_fts_ad AFTER DELETE ON log_records BEGIN "
+        "INSERT INTO logs_fts(logs_fts, rowid, message) VALUES ('delete', old.id, old.message); END;";
+    static constexpr long long V1_UTC_OFFSET = 8 * 3600; ///< v1 写入时固定加的时区偏移（秒）
+    /// 分区清单：文件名相对清单所在目录，时间范围为 [start_us, end_us)；user_version 与分区库一致
+    static constexpr const char *CREATE_MANIFEST =
+        "CREATE TABLE IF NOT EXISTS log_partitions (file TEXT PRIMARY KEY, start_us INTEGER NOT NULL,"
+        "end_us INTEGER NOT NULL);";
+
+    /// @brief 打开（必要时创建）库文件并应用存储参数
+    void openFile(SqliteHelper &helper, const std::string &file)
+    {
+        if (!Xulog::Util::File::exists(file))
+        {
+            std::string path = Xulog::Util::File::path(file);
+            Xulog::Util::File::createDirectory(path);
+            Xulog::Util::File::createFile(file);
+        }
+        bool opened = helper.open();
+        assert(opened);
+        (void)opened;
+        if (!helper.applyProfile(_profile))
+            ERROR("应用数据库存储参数失败，使用 SQLite 默认设置");
+    }
+    /// @brief 切换到消息时间所属的分区：先在已打开的分区中查找，否则打开该分区（不存在时新建并登记到清单），
+    /// 打开的分区超过 MAX_OPEN_PARTITIONS 个时提交并关闭最久未写入的一个
+    /// @return 所属分区已被保留策略删除时返回 false，调用方丢弃该行
+    bool usePartition(long long time_us)
+    {
+        for (auto it = _files.begin(); it != _files.end(); ++it)
+        {
+            if (time_us >= (*it)->start_us && time_us < (*it)->end_us)
+            {
+                _files.splice(_files.begin(), _files, it);
+                _cur = _files.front().get();
+                return true;
+            }
+        }
+
+        time_t sec = (time_t)(time_us / 1000000);
+        struct tm t;
+        localtime_r(&sec, &t);
+        t.tm_min = 0;
+        t.tm_sec = 0;
+        if (_partition == DBPartition::DAY)
+            t.tm_hour = 0;
+        char stamp[16];
+        strftime(stamp, sizeof(stamp), _partition == DBPartition::DAY ? "%Y%m%d" : "%Y%m%d%H", &t);
+        t.tm_isdst = -1;
+        long long start_us = (long long)mktime(&t) * 1000000;
+        if (_partition == DBPartition::DAY)
+            t.tm_mday++;
+        else
+            t.tm_hour++;
+        t.tm_isdst = -1;
+        long long end_us = (long long)mktime(&t) * 1000000;
+
+        std::string file = partitionName(stamp);
+        if (expired(file, start_us, end_us))
+            return false;
+        _files.emplace_front(new DBFile(_dir + file));
+        _cur = _files.front().get();
+        _cur->file = file;
+        _cur->start_us = start_us;
+        _cur->end_us = end_us;
+        openFile(_cur->helper, _dir + file);
+        createTable();
+        // 新分区的自增序列从分区起始时间开始，已有分区沿用自身序列
+        bool ret = _cur->helper.exec("INSERT INTO sqlite_sequence (name, seq) SELECT 'log_records', " +
+                                         std::to_string(start_us) +
+                                         " WHERE NOT EXISTS (SELECT 1 FROM sqlite_sequence WHERE name='log_records');",
+                                     nullptr, nullptr) &&
+                   _manifest.exec("INSERT OR IGNORE INTO log_partitions (file, start_us, end_us) VALUES (" +
+                                      quote(file) + ", " + std::to_string(start_us) + ", " + std::to_string(end_us) + ");",
+                                  nullptr, nullptr);
+        if (!ret)
+        {
+            ERROR("登记日志分区失败!");
+            abort();
+        }
+        while (_files.size() > MAX_OPEN_PARTITIONS)
+        {
+            commitFile(*_files.back());
+            _files.back()->helper.close();
+            _files.pop_back();
+        }
+        if (_max_partitions > 0)
+            dropPartitions("SELECT file, end_us FROM log_partitions ORDER BY start_us DESC LIMIT -1 OFFSET " +
+                           std::to_string(_max_partitions) + ";");
+        return true;
+    }
+    /// @brief 尚未登记的分区是否已过保留期：早于已删除的分区，或保留数已满且比现存最旧的分区还旧
+    bool expired(const std::string &file, long long start_us, long long end_us)
+    {
+        long long registered = 0, count = 0, oldest = 0;
+        if (!_manifest.queryInt("SELECT COUNT(*) FROM log_partitions WHERE file=" + quote(file) + ";", &registered) ||
+            registered > 0)
+            return false;
+        if (end_us <= _retained_from_us)
+            return true;
+        if (_max_partitions == 0)
+            return false;
+        return _manifest.queryInt("SELECT COUNT(*) FROM log_partitions;", &count) &&
+               _manifest.queryInt("SELECT COALESCE(MIN(start_us), 0) FROM log_partitions;", &oldest) &&
+               count >= (long long)_max_partitions && start_us < oldest;
+    }
+    /// @brief 由清单库文件名生成分区文件名：log.db → log.2024070108.db
+    std::string partitionName(const std::string &stamp) const
+    {
+        size_t dot = _base.find_last_of('.');
+        if (dot == std::string::npos || dot == 0)
+            return _base + "." + stamp + ".db";
+        return _base.substr(0, dot) + "." + stamp + _base.substr(dot);
+    }
+    /// @brief 删除 select 查出的分区（select 返回 file, end_us）：先从清单中移除，再删除文件；
+    /// 跳过当前分区，其余已打开的分区先提交并关闭
+    size_t dropPartitions(const std::string &select)
+    {
+        std::vector<std::pair<std::string, long long>> parts;
+        auto collect = [](void *arg, int, char **values, char **) -> int
+        {
+            if (values[0] && values[1])
+                static_cast<std::vector<std::pair<std::string, long long>> *>(arg)->emplace_back(values[0], atoll(values[1]));
+            return 0;
+        };
+        if (!_manifest.exec(select, collect, &parts))
+            return 0;
+        size_t dropped = 0;
+        for (auto &part : parts)
+        {
+            if (_cur != nullptr && part.first == _cur->file)
+                continue;
+            if (!_manifest.exec("DELETE FROM log_partitions WHERE file=" + quote(part.first) + ";", nullptr, nullptr))
+                continue;
+            for (auto it = _files.begin(); it != _files.end(); ++it)
+            {
+                if ((*it)->file != part.first)
+                    continue;
+                commitFile(**it);
+                (*it)->helper.close();
+                _files.erase(it);
+                break;
+            }
+            for (const char *suffix : {"", "-wal", "-shm"})
+                unlink((_dir + part.first + suffix).c_str());
+            if (part.second > _retained_from_us)
+                _retained_from_us = part.second;
+            dropped++;
+        }
+        return dropped;
+    }
+    static std::string quote(const std::string &s)
+    {
+        std::string out = "'";
+        for (char c : s)
+        {
+            if (c == '\'')
+                out += '\'';
+            out += c;
+        }
+        return out + "'";
+    }
+    /// @brief 拷贝进写线程队列，队列满时等待写线程腾出空间
+    void enqueue(const Xulog::LogMsg &msg)
+    {
+        std::unique_lock<std::mutex> lock(_queue_mutex);
+        _not_full.wait(lock, [&]()
+                       { return _queued < _queue_rows; });
+        // 槽位复用：赋值沿用旧字符串的容量，稳定后入队不再分配内存
+        if (_queued < _queue.size())
+            _queue[_queued] = msg;
+        else
+            _queue.push_back(msg);
+        _pushed++;
+        if (++_queued == 1)
+            _not_empty.notify_one();
+    }
+    /// @brief 写线程：与入队方交换双缓冲，取走队列中的全部日志并在一个事务中插入；
+    /// 空闲超过 batch_ms、收到 flush() 或退出时提交尾批并通知等待的 flush()
+    void writerLoop()
+    {
+        std::vector<Xulog::LogMsg> batch;
+        uint64_t written = 0, committed = 0;
+        while (true)
+        {
+            bool stop = false, flush = false;
+            size_t count = 0;
+            {
+                std::unique_lock<std::mutex> lock(_queue_mutex);
+                auto ready = [&]()
+                { return _queued > 0 || _stop || _flush_target > committed; };
+                // 只看写线程自己的计数：_files 受 mutex() 保护，dropPartitions 可能在调用方线程中修改它
+                if (written == committed)
+                    _not_empty.wait(lock, ready);
+                else
+                    _not_empty.wait_for(lock, std::chrono::milliseconds(_batch_ms ? _batch_ms : 1), ready);
+                batch.swap(_queue);
+                count = _queued;
+                _queued = 0;
+                stop = _stop;
+                flush = _flush_target > committed;
+            }
+            _not_full.notify_all();
+
+            std::unique_lock<std::mutex> lock(mutex());
+            for (size_t i = 0; i < count; i++)
+                insertLog(batch[i]);
+            written += count;
+            if (count == 0 || flush || stop)
+            {
+                commitBatch();
+                lock.unlock();
+                committed = written;
+                {
+                    std::unique_lock<std::mutex> qlock(_queue_mutex);
+                    _committed = committed;
+                }
+                _flushed.notify_all();
+                if (stop && count == 0)
+                    return;
+            }
+        }
+    }
+    /// @brief 提交线程（不启用写线程时）：等到最早开启的事务满 batch_ms 毫秒，提交所有到期的批次。
+    /// 与写入方共用 mutex()，写入方开启新事务时通知它
+    void committerLoop()
+    {
+        std::unique_lock<std::mutex> lock(mutex());
+        while (!_closing)
+        {
+            uint64_t oldest = 0;
+            bool open = false;
+            for (auto &file : _files)
+            {
+                if (file->pending > 0 && (!open || file->txn_start < oldest))
+                    oldest = file->txn_start;
+                open = open || file->pending > 0;
+            }
+            if (!open)
+            {
+                _txn_open.wait(lock);
+                continue;
+            }
+            uint64_t now = nowMs();
+            if (now - oldest < _batch_ms)
+            {
+                _txn_open.wait_for(lock, std::chrono::milliseconds(oldest + _batch_ms - now));
+                continue;
+            }
+            for (auto &file : _files)
+                if (file->pending > 0 && now - file->txn_start >= _batch_ms)
+                    commitFile(*file);
+        }
+    }
+
+    /// @brief v1 → v2：在一个事务内重建表，把 TEXT 时间换算回 UTC 纪元微秒，失败则整体回滚
+    bool migrateV1()
+    {
+        std::string sql = std::string("BEGIN;"
+                                      "ALTER TABLE logs RENAME TO logs_v1;") +
+                          CREATE_TABLE_V2 +
+                          "INSERT INTO logs (id, log_time, line_number, thread_id, log_level, source_file, logger_name, message) "
+                          "SELECT id, COALESCE(CAST(strftime('%s', log_time) AS INTEGER) - " + std::to_string(V1_UTC_OFFSET) + ", 0) * 1000000, "
+                          "line_number, thread_id, log_level, source_file, logger_name, message FROM logs_v1;"
+                          "DROP TABLE logs_v1;" +
+                          CREATE_INDEXES_V2 +
+                          "PRAGMA user_version=2;"
+                          "COMMIT;";
+        if (_cur->helper.exec(sql, nullptr, nullptr))
+            return true;
+        _cur->helper.exec("ROLLBACK;", nullptr, nullptr);
+        return false;
+    }
+    /// @brief v2 → v3：把字符串列收集进维度表，按 id 重写事实表，保留原 id；失败则整体回滚
+    bool migrateV2()
+    {
+        std::string sql = std::string("BEGIN;"
+                                      "ALTER TABLE logs RENAME TO logs_v2;") +
+                          CREATE_TABLES_V3 +
+                          "INSERT OR IGNORE INTO log_levels (name) SELECT DISTINCT log_level FROM logs_v2;"
+                          "INSERT OR IGNORE INTO log_loggers (name) SELECT DISTINCT COALESCE(logger_name, '') FROM logs_v2;"
+                          "INSERT OR IGNORE INTO log_files (name) SELECT DISTINCT COALESCE(source_file, '') FROM logs_v2;"
+                          "INSERT OR IGNORE INTO log_threads (name) SELECT DISTINCT COALESCE(thread_id, '') FROM logs_v2;"
+                          "INSERT INTO log_records (id, log_time, line_number, thread_ref, level_ref, file_ref, logger_ref, message) "
+                          "SELECT v.id, v.log_time, v.line_number, t.id, l.id, f.id, g.id, v.message FROM logs_v2 v "
+                          "JOIN log_levels l ON l.name = v.log_level "
+                          "JOIN log_threads t ON t.name = COALESCE(v.thread_id, '') "
+                          "JOIN log_files f ON f.name = COALESCE(v.source_file, '') "
+                          "JOIN log_loggers g ON g.name = COALESCE(v.logger_name, '');"
+                          "DROP TABLE logs_v2;" +
+                          CREATE_INDEXES_V3 + CREATE_VIEW_V3 +
+                          "PRAGMA user_version=3;"
+                          "COMMIT;";
+        if (_cur->helper.exec(sql, nullptr, nullptr))
+            return true;
+        _cur->helper.exec("ROLLBACK;", nullptr, nullptr);
+        return false;
+    }
+    /// @brief v3 → v4：建立分钟汇总表，并由已有的行补齐计数
+    bool migrateV3()
+    {
+        std::string sql = std::string("BEGIN;") + CREATE_ROLLUP +
+                          "INSERT INTO log_rollup_minute (minute, level_ref, logger_ref, count) "
+                          "SELECT log_time / 60000000, level_ref, logger_ref, COUNT(*) FROM log_records GROUP BY 1, 2, 3;"
+                          "PRAGMA user_version=4;"
+                          "COMMIT;";
+        if (_cur->helper.exec(sql, nullptr, nullptr))
+            return true;
+        _cur->helper.exec("ROLLBACK;", nullptr, nullptr);
+        return false;
+    }
+    /// @brief 首次启用时建立全文索引并为已有的行补建索引；已存在时只确保同步触发器在位（迁移会随旧表删除触发器）
+    bool createFullText(bool exists)
+    {
+        std::string sql = "BEGIN;";
+        if (!exists)
+            sql += CREATE_FULL_TEXT;
+        sql += CREATE_FULL_TEXT_TRIGGERS;
+        if (!exists)
+            sql += "INSERT INTO logs_fts(logs_fts) VALUES ('rebuild');";
+        sql += "COMMIT;";
+        if (_cur->helper.exec(sql, nullptr, nullptr))
+            return true;
+        _cur->helper.exec("ROLLBACK;", nullptr, nullptr);
+        return false;
+    }
+    static uint64_t nowMs()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+    /// @brief 名称 → 维度 id，先查内存缓存，未命中再查库；缓存过大时整体清空
+    long long refOf(const char *table, std::unordered_map<std::string, long long> &cache, const std::string &name)
+    {
+        auto it = cache.find(name);
+        if (it != cache.end())
+            return it->second;
+        long long id = 0;
+        if (!_cur->helper.intern(table, name, &id))
+        {
+            ERROR("写入日志维度表失败!");
+            abort();
+        }
+        if (cache.size() >= MAX_CACHED_REFS)
+            cache.clear();
+        cache.emplace(name, id);
+        return id;
+    }
     void insertLog(const Xulog::LogMsg &msg)
     {
-        static const char *SQL =
-            "INSERT INTO logs (log_time, line_number, thread_id, log_level, source_file, logger_name, message) "
-            "VALUES (datetime(?1, 'unixepoch', '+8 hours'), ?2, ?3, ?4, ?5, ?6, ?7);";
-        std::ostringstream tid_ss;
-        tid_ss << msg._tid;
-        bool ok = _helper.insertLog(SQL,
-                                    (long long)msg._ctime, (long long)msg._line,
-                                    tid_ss.str(),
-                                    Xulog::LogLevel::toString(msg._level),
-                                    msg._file, msg._logger, msg._payload);
+        static const std::string SQL =
+            "INSERT INTO log_records (log_time, line_number, thread_ref, level_ref, file_ref, logger_ref, message) "
+            "VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7);";
+        long long time_us = (long long)msg._ctime * 1000000 + msg._usec;
+        if (_partition != DBPartition::NONE && (_cur == nullptr || time_us < _cur->start_us || time_us >= _cur->end_us) &&
+            !usePartition(time_us))
+        {
+            _expired_rows++;
+            return;
+        }
+        DBFile &f = *_cur;
+        uint64_t now = nowMs();
+        if (f.pending == 0)
+        {
+            if (!f.helper.begin())
+            {
+                ERROR("开启日志事务失败!");
+                abort();
+            }
+            f.txn_start = now;
+            if (_committer.joinable())
+                _txn_open.notify_one();
+        }
+        if (f.thread_ref < 0 || msg._tid != f.last_tid)
+        {
+            std::ostringstream tid_ss;
+            tid_ss << msg._tid;
+            f.thread_ref = refOf("log_threads", f.thread_refs, tid_ss.str());
+            f.last_tid = msg._tid;
+        }
+        long long &level_ref = f.level_refs[(size_t)msg._level % LEVEL_SLOTS];
+        if (level_ref < 0)
+            level_ref = refOf("log_levels", f.level_name_refs, Xulog::LogLevel::toString(msg._level));
+        long long logger_ref = refOf("log_loggers", f.logger_refs, msg._logger);
+        bool ok = f.helper.insertLog(SQL,
+                                     time_us, (long long)msg._line,
+                                     f.thread_ref, level_ref,
+                                     refOf("log_files", f.file_refs, msg._file),
+                                     logger_ref, msg._payload);
         if (!ok)
         {
             ERROR("插入日志数据失败!");
             abort();
         }
+        // 连续的日志多半落在同一分钟、同一等级与日志器，先比较上一次命中的键
+        RollupKey key(time_us / 60000000, level_ref, logger_ref);
+        if (f.rollup_hit == nullptr || key != f.rollup_key)
+        {
+            f.rollup_key = key;
+            f.rollup_hit = &f.rollup[key];
+        }
+        (*f.rollup_hit)++;
+        f.pending++;
+        if (msg._level >= Xulog::LogLevel::value::ERROR)
+            return commitBatch(); // ERROR 返回时此前的日志（含其他分区）均已落盘
+        if (f.pending >= _batch_rows || now - f.txn_start >= _batch_ms)
+            commitFile(f);
+        // 其他打开的分区同样受时间窗口约束
+        for (auto &other : _files)
+            if (other.get() != _cur && other->pending > 0 && now - other->txn_start >= _batch_ms)
+                commitFile(*other);
+    }
+    /// @brief 提交全部打开的库文件中的当前批次，调用方需持有 mutex() 或处于析构中
+    void commitBatch()
+    {
+        for (auto &file : _files)
+            commitFile(*file);
+    }
+    /// @brief 提交一个库文件的当前批次，先把分钟汇总写入同一事务
+    void commitFile(DBFile &f)
+    {
+        if (f.pending == 0)
+            return;
+        f.pending = 0;
+        static const std::string UPSERT =
+            "INSERT INTO log_rollup_minute (minute, level_ref, logger_ref, count) VALUES (?1, ?2, ?3, ?4) "
+            "ON CONFLICT (minute, level_ref, logger_ref) DO UPDATE SET count = count + excluded.count;";
+        bool ok = true;
+        for (auto &kv : f.rollup)
+            ok = ok && f.helper.execInts(UPSERT, {std::get<0>(kv.first), std::get<1>(kv.first),
+                                                  std::get<2>(kv.first), kv.second});
+        f.rollup.clear();
+        f.rollup_hit = nullptr;
+        if (!ok || !f.helper.commit())
+        {
+            ERROR("提交日志事务失败!");
+            abort();
+        }
     }
 
-    SqliteHelper _helper;         ///< 数据库帮助类句柄
     std::string _logger_name;     ///< 日志器名称
+    size_t _batch_rows;           ///< 每批最大行数
+    uint64_t _batch_ms;           ///< 每批最长持续时间（毫秒）
+    bool _full_text;              ///< 是否维护全文索引
+    SqliteProfile _profile;       ///< 存储参数，新建分区时同样应用
+
+    SqliteHelper _manifest;          ///< 分区清单库（仅分区时打开）
+    DBPartition _partition;          ///< 分区粒度
+    size_t _max_partitions;          ///< 最多保留的分区数，0 表示不限
+    std::string _dir;                ///< 清单库所在目录（含末尾 '/'），分区文件与其同目录
+    std::string _base;               ///< 清单库文件名，分区文件名由它派生
+    long long _retained_from_us = 0; ///< 已删除分区的最晚结束时间，更早的迟到日志直接丢弃
+    size_t _expired_rows = 0;        ///< 因分区已删除而丢弃的迟到日志条数
+
+    size_t _queue_rows;                 ///< 写线程队列容量，0 表示不启用写线程
+    std::mutex _queue_mutex;            ///< 保护以下队列状态
+    std::condition_variable _not_empty; ///< 有新日志、flush 请求或退出
+    std::condition_variable _not_full;  ///< 队列腾出空间
+    std::condition_variable _flushed;   ///< 写线程完成一次提交
+    std::vector<Xulog::LogMsg> _queue;  ///< 待写入的日志，前 _queued 个有效，其余为可复用的槽位
+    size_t _queued = 0;                 ///< 队列中待写入的条数
+    uint64_t _pushed = 0;               ///< 累计入队条数
+    uint64_t _flush_target = 0;         ///< flush() 请求提交到的入队序号
+    uint64_t _committed = 0;            ///< 已提交到的入队序号
+    bool _stop = false;                 ///< 析构中，写线程写完队列后退出
+
+    static constexpr size_t MAX_CACHED_REFS = 4096; ///< 每个维度缓存的名称上限
+    std::list<std::unique_ptr<DBFile>> _files;      ///< 打开的库文件，最近写入的在前；不分区时只有一个
+    DBFile *_cur = nullptr;                         ///< 当前写入的库文件
+
+    std::condition_variable _txn_open; ///< 写入方开启了新事务或析构中，配合 mutex() 使用
+    bool _closing = false;             ///< 析构中，提交线程退出；受 mutex() 保护
+
+    std::thread _writer;    ///< 写线程，最后声明以保证其余成员先于它构造
+    std::thread _committer; ///< 提交线程，不启用写线程且按批提交时存在
 };
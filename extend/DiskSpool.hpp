@@ -0,0 +1,281 @@
+/**
+ * @file DiskSpool.hpp
+ * @brief 定义了 DiskSpool 类，远程落地在服务器不可用时使用的本地磁盘暂存
+ *
+ * 暂存由目录下一组只追加的段文件组成（spool-<序号>.seg），内容就是线上的长度前缀帧。
+ * 新帧追加到最新的段，段达到 segment_bytes 后换新段；读取从最旧的段开始，按帧整读，
+ * 发送成功后 consume() 推进读位置，读完的段被删除。
+ * 总大小超过 max_bytes 时从最旧的段开始淘汰；单次追加本身就超过 max_bytes 时先丢弃其中最旧的帧，同样计入淘汰字节数。
+ *
+ * 进程重启后目录中遗留的段会被重新读取；读位置不落盘，重启时最旧段中已发送的部分会再发一次（至少一次）。
+ * 上次进程被中断时段尾可能留下半帧，读到时直接跳过；运行中写入失败的半帧当场截掉。
+ *
+ * 本类不加锁，由调用方（ServerSink）串行化访问。
+ */
+#pragma once
+#include "../logs/Xulog.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/// @brief 本地磁盘暂存
+class DiskSpool
+{
+public:
+    /// @brief 构造函数，打开目录并接管其中遗留的段
+    /// @param dir 暂存目录
+    /// @param max_bytes 暂存总大小上限（字节），超出时淘汰最旧的段
+    /// @param segment_bytes 单个段的大小，达到后换新段
+    DiskSpool(const std::string &dir, size_t max_bytes, size_t segment_bytes)
+        : _dir(dir), _max_bytes(max_bytes), _segment_bytes(segment_bytes)
+    {
+        Xulog::Util::File::createDirectory(_dir);
+        recover();
+    }
+    ~DiskSpool()
+    {
+        closeRead();
+        closeWrite();
+    }
+
+    /// @brief 追加若干完整帧，必要时先淘汰最旧的段
+    /// 这一批本身超过 max_bytes 时只保留能放下的最新若干帧，丢弃的部分计入 evictedBytes()；
+    /// 只写入一部分时（磁盘满、IO 错误）截回追加前的长度，截断也失败时改写新段，段中间不留半帧
+    /// @return 写入失败返回 false，这一批没有写入
+    bool append(const char *data, size_t len)
+    {
+        size_t skip = 0;
+        while (len - skip > _max_bytes)
+        {
+            uint32_t sz;
+            if (len - skip < sizeof(uint32_t))
+            {
+                skip = len;
+                break;
+            }
+            ::memcpy(&sz, data + skip, sizeof(uint32_t));
+            skip = std::min(len, skip + sizeof(uint32_t) + (size_t)ntohl(sz));
+        }
+        _evicted += skip;
+        data += skip;
+        len -= skip;
+        if (len == 0)
+            return true;
+        while (!_segments.empty() && _bytes + len > _max_bytes)
+            evictOldest();
+        if (_write_fd < 0 || _segments.back().size >= _segment_bytes)
+        {
+            closeWrite();
+            Segment seg;
+            seg.seq = _next_seq++;
+            _write_fd = ::open(pathOf(seg.seq).c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+            if (_write_fd < 0)
+                return false;
+            _segments.push_back(seg);
+        }
+        size_t done = 0;
+        while (done < len)
+        {
+            ssize_t n = ::write(_write_fd, data + done, len - done);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                break;
+            done += n;
+        }
+        if (done < len)
+        {
+            if (done > 0 && ::ftruncate(_write_fd, (off_t)_segments.back().size) != 0)
+                closeWrite(); // 文件尾已有半帧，后续追加不能再接在它后面
+            return false;
+        }
+        _segments.back().size += len;
+        _bytes += len;
+        return true;
+    }
+    /// @brief 从最旧的段读出若干完整帧，不推进读位置
+    /// @param out 输出，被覆盖
+    /// @param max_bytes 期望的最大字节数，单帧超过时仍整帧读出
+    /// @return 读出的字节数，暂存为空时为 0
+    size_t read(std::string *out, size_t max_bytes)
+    {
+        out->clear();
+        while (!_segments.empty())
+        {
+            Segment &head = _segments.front();
+            if (_read_fd < 0)
+                _read_fd = ::open(pathOf(head.seq).c_str(), O_RDONLY | O_CLOEXEC);
+            size_t avail = head.size - _read_offset;
+            if (_read_fd >= 0 && avail >= sizeof(uint32_t))
+            {
+                uint32_t sz;
+                if (pread(&sz, sizeof(sz), _read_offset) && sizeof(uint32_t) + ntohl(sz) <= avail)
+                {
+                    // 先按上限读一块，再裁到最后一个完整帧；首帧超过上限时整帧读出
+                    size_t want = std::min(avail, std::max(max_bytes, sizeof(uint32_t) + (size_t)ntohl(sz)));
+                    out->resize(want);
+                    if (pread(&(*out)[0], want, _read_offset))
+                    {
+                        _read_seq = head.seq;
+                        out->resize(wholeFrames(*out));
+                        return out->size();
+                    }
+                }
+            }
+            // 正在写入的段已读完：等待后续追加
+            bool writing = _segments.size() == 1 && _write_fd >= 0;
+            if (writing && avail == 0)
+                return 0;
+            // 打不开的段或段尾残留的半帧（上次进程中断或写入失败）：丢弃该段剩余部分
+            if (writing)
+                closeWrite();
+            dropHead();
+        }
+        return 0;
+    }
+    /// @brief 上一次 read() 的数据已发送成功，推进读位置；读完的段被删除
+    /// @param len 已发送的字节数
+    void consume(size_t len)
+    {
+        // 发送期间该段可能已被淘汰，此时读位置属于下一个段，不能推进
+        if (_segments.empty() || _segments.front().seq != _read_seq)
+            return;
+        _read_offset += len;
+        if (_read_offset >= _segments.front().size)
+            dropHead();
+    }
+    /// @brief 是否没有待发送的数据
+    bool empty() const { return _bytes == _read_offset; }
+    /// @brief 暂存占用的磁盘字节数
+    size_t bytes() const { return _bytes; }
+    /// @brief 因超过上限被淘汰的字节数
+    size_t evictedBytes() const { return _evicted; }
+
+private:
+    /// @brief 一个段文件
+    struct Segment
+    {
+        uint64_t seq = 0; ///< 序号，同时决定文件名与先后顺序
+        size_t size = 0;  ///< 文件大小
+    };
+
+    std::string pathOf(uint64_t seq) const
+    {
+        char name[64];
+        snprintf(name, sizeof(name), "/spool-%020llu.seg", (unsigned long long)seq);
+        return _dir + name;
+    }
+    /// @brief 接管目录中遗留的段，之后的追加写入新段
+    void recover()
+    {
+        DIR *d = ::opendir(_dir.c_str());
+        if (d == nullptr)
+            return;
+        std::vector<Segment> found;
+        while (struct dirent *e = ::readdir(d))
+        {
+            unsigned long long seq;
+            char tail[8];
+            if (sscanf(e->d_name, "spool-%llu.%7s", &seq, tail) != 2 || std::string(tail) != "seg")
+                continue;
+            struct stat st;
+            if (::stat(pathOf(seq).c_str(), &st) != 0)
+                continue;
+            Segment seg;
+            seg.seq = seq;
+            seg.size = st.st_size;
+            found.push_back(seg);
+        }
+        ::closedir(d);
+        std::sort(found.begin(), found.end(), [](const Segment &a, const Segment &b)
+                  { return a.seq < b.seq; });
+        for (auto &seg : found)
+        {
+            _segments.push_back(seg);
+            _bytes += seg.size;
+            _next_seq = seg.seq + 1;
+        }
+    }
+    /// @brief 裁到最后一个完整帧的结尾
+    static size_t wholeFrames(const std::string &buf)
+    {
+        size_t pos = 0;
+        while (pos + sizeof(uint32_t) <= buf.size())
+        {
+            uint32_t sz;
+            ::memcpy(&sz, buf.data() + pos, sizeof(uint32_t));
+            size_t next = pos + sizeof(uint32_t) + ntohl(sz);
+            if (next > buf.size())
+                break;
+            pos = next;
+        }
+        return pos;
+    }
+    bool pread(void *buf, size_t len, size_t offset)
+    {
+        size_t done = 0;
+        while (done < len)
+        {
+            ssize_t n = ::pread(_read_fd, (char *)buf + done, len - done, offset + done);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return false;
+            done += n;
+        }
+        return true;
+    }
+    /// @brief 删除最旧的段
+    void dropHead()
+    {
+        closeRead();
+        Segment head = _segments.front();
+        _segments.pop_front();
+        if (_segments.empty())
+            closeWrite(); // 最后一个段被读完，下次追加重新建段
+        ::unlink(pathOf(head.seq).c_str());
+        _bytes -= head.size;
+    }
+    /// @brief 淘汰最旧的段，未发送的部分计入淘汰字节数
+    void evictOldest()
+    {
+        _evicted += _segments.front().size - _read_offset;
+        dropHead();
+    }
+    void closeRead()
+    {
+        if (_read_fd >= 0)
+            ::close(_read_fd);
+        _read_fd = -1;
+        _read_offset = 0;
+    }
+    void closeWrite()
+    {
+        if (_write_fd >= 0)
+            ::close(_write_fd);
+        _write_fd = -1;
+    }
+
+private:
+    std::string _dir;                ///< 暂存目录
+    size_t _max_bytes;               ///< 总大小上限
+    size_t _segment_bytes;           ///< 单段大小
+    std::deque<Segment> _segments;   ///< 从旧到新的段
+    uint64_t _next_seq = 0;          ///< 下一个新段的序号
+    size_t _bytes = 0;               ///< 所有段的总大小
+    size_t _evicted = 0;             ///< 被淘汰的字节数
+    int _write_fd = -1;              ///< 最新段的写描述符
+    int _read_fd = -1;               ///< 最旧段的读描述符
+    size_t _read_offset = 0;         ///< 最旧段中的读位置
+    uint64_t _read_seq = UINT64_MAX; ///< 上一次 read() 所在的段
+};
@@ -0,0 +1,269 @@
+/**
+ * @file RateLimitSink.hpp
+ * @brief 定义了 RateLimitSink 类，限流去重装饰器：同一调用点的重复日志超过速率后被抑制并汇总
+ *
+ * 依赖故障时同一条 ERROR 可能每秒重复几十万次，压垮异步队列和数据库。
+ * RateLimitSink 包装任意 sink，以 调用点（文件 + 行号 + 等级）+ 正文模板（数字归一化）的哈希为键，
+ * 每个键在一个时间窗口内最多放行 burst 条，其余只计数；
+ * 窗口结束后输出一条 "last message repeated N times" 汇总。汇总由后台线程每个窗口周期检查一次，
+ * 重复风暴停止后无需等下一条日志到来也会输出；汇总行用日志器的格式渲染，与被替代的日志同格式。
+ *
+ * 状态按键哈希分片，每片一把锁，不同调用点之间几乎没有竞争，开销远小于被省掉的那次写入。
+ */
+#pragma once
+#include "../logs/Xulog.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/// @brief 限流去重装饰器落地类
+class RateLimitSink : public Xulog::LogSink
+{
+public:
+    using ptr = std::shared_ptr<RateLimitSink>; ///< 限流去重落地操作句柄
+
+    /// @brief 构造函数
+    /// @param inner 被包装的实际落地
+    /// @param formatter 所属日志器的格式化器，汇总行按它渲染；为空时与日志器一样使用默认格式，
+    ///        本 sink 设置了独立格式（setFormatter）时以独立格式为准
+    /// @param burst 每个键在一个窗口内最多放行的条数
+    /// @param interval_ms 窗口长度（毫秒），同时也是汇总的周期
+    RateLimitSink(const Xulog::LogSink::ptr &inner, const Xulog::Formatter::ptr &formatter,
+                  size_t burst = 10, size_t interval_ms = 1000)
+        : _inner(inner), _burst(burst), _interval_ms(interval_ms ? interval_ms : 1),
+          _logger_formatter(formatter ? formatter : std::make_shared<Xulog::Formatter>()),
+          _next_sweep(nowMs() + _interval_ms)
+    {
+        _sweeper = std::thread(&RateLimitSink::sweepLoop, this);
+    }
+    ~RateLimitSink()
+    {
+        {
+            std::unique_lock<std::mutex> lock(_sweeper_mutex);
+            _stop = true;
+        }
+        _wakeup.notify_one();
+        _sweeper.join();
+        flush();
+    }
+
+    /// @brief 结构化落地：未超限则转发给内部 sink，超限只计数
+    void log(const char *data, size_t len, const Xulog::LogMsg &msg) override
+    {
+        uint64_t now = nowMs();
+        std::vector<Summary> summaries;
+        bool pass = admit(msg, now, &summaries);
+        sweepIfDue(now, &summaries);
+        emit(summaries);
+        if (pass)
+            forward(data, len, msg);
+    }
+    /// @brief 字节落地：无调用点信息，不限流直接转发
+    void log(const char *data, size_t len) override
+    {
+        forward(data, len);
+    }
+    /// @brief 状态分片加锁，内部 sink 按需加锁，同步日志器无需再为其加锁
+    bool threadSafe() const override { return true; }
+
+    /// @brief 立即输出所有待汇总的重复计数
+    void flush()
+    {
+        std::vector<Summary> summaries;
+        for (auto &shard : _shards)
+        {
+            std::unique_lock<std::mutex> lock(shard.mutex);
+            for (auto &kv : shard.states)
+                takeSummary(kv.second, &summaries);
+        }
+        emit(summaries);
+    }
+
+private:
+    static constexpr size_t SHARD_COUNT = 64;      ///< 分片数
+    static constexpr size_t MAX_KEYS_PER_SHARD = 4096; ///< 每片最多跟踪的键，超出时不再限流新键
+
+    /// @brief 单个键的限流状态
+    struct State
+    {
+        uint64_t window_start = 0; ///< 当前窗口起始时间（毫秒）
+        size_t count = 0;          ///< 当前窗口内已放行条数
+        size_t suppressed = 0;     ///< 当前窗口内被抑制的条数
+        Xulog::LogMsg sample;      ///< 被抑制日志的样本，用于生成汇总
+    };
+    /// @brief 状态分片
+    struct Shard
+    {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, State> states;
+    };
+    /// @brief 待输出的汇总
+    struct Summary
+    {
+        Xulog::LogMsg msg;
+        size_t repeated;
+    };
+
+    static uint64_t nowMs()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+    /// @brief FNV-1a：调用点 + 等级 + 正文模板（连续数字折叠为一个 '#'）
+    static uint64_t keyOf(const Xulog::LogMsg &msg)
+    {
+        uint64_t h = 1469598103934665603ULL;
+        auto mix = [&h](unsigned char c)
+        {
+            h ^= c;
+            h *= 1099511628211ULL;
+        };
+        for (unsigned char c : msg._file)
+            mix(c);
+        for (size_t line = msg._line; line; line >>= 8)
+            mix((unsigned char)(line & 0xFF));
+        mix((unsigned char)msg._level);
+        bool in_digits = false;
+        for (unsigned char c : msg._payload)
+        {
+            bool digit = c >= '0' && c <= '9';
+            if (digit && in_digits)
+                continue;
+            in_digits = digit;
+            mix(digit ? '#' : c);
+        }
+        return h;
+    }
+    /// @brief 窗口到期：取出待汇总的计数并开启新窗口
+    void takeSummary(State &st, std::vector<Summary> *out)
+    {
+        if (st.suppressed > 0)
+            out->push_back(Summary{st.sample, st.suppressed});
+        st.suppressed = 0;
+        st.count = 0;
+    }
+    /// @brief 判断是否放行；窗口到期时顺带收集上一窗口的汇总
+    bool admit(const Xulog::LogMsg &msg, uint64_t now, std::vector<Summary> *summaries)
+    {
+        uint64_t key = keyOf(msg);
+        Shard &shard = _shards[key % SHARD_COUNT];
+        std::unique_lock<std::mutex> lock(shard.mutex);
+        auto it = shard.states.find(key);
+        if (it == shard.states.end())
+        {
+            if (shard.states.size() >= MAX_KEYS_PER_SHARD)
+                return true;
+            it = shard.states.emplace(key, State()).first;
+            it->second.window_start = now;
+        }
+        State &st = it->second;
+        if (now - st.window_start >= _interval_ms)
+        {
+            takeSummary(st, summaries);
+            st.window_start = now;
+        }
+        if (st.count < _burst)
+        {
+            st.count++;
+            return true;
+        }
+        if (st.suppressed++ == 0)
+            st.sample = msg;
+        return false;
+    }
+    /// @brief 周期清扫：为已沉默的键输出汇总，并回收空闲状态
+    void sweepIfDue(uint64_t now, std::vector<Summary> *summaries)
+    {
+        uint64_t due = _next_sweep.load(std::memory_order_relaxed);
+        if (now < due || !_next_sweep.compare_exchange_strong(due, now + _interval_ms))
+            return;
+        for (auto &shard : _shards)
+        {
+            std::unique_lock<std::mutex> lock(shard.mutex);
+            for (auto it = shard.states.begin(); it != shard.states.end();)
+            {
+                if (now - it->second.window_start < _interval_ms)
+                {
+                    ++it;
+                    continue;
+                }
+                takeSummary(it->second, summaries);
+                it = shard.states.erase(it);
+            }
+        }
+    }
+    /// @brief 后台清扫线程：每个窗口周期检查一次，重复风暴停止、不再有日志到来时汇总照样输出
+    void sweepLoop()
+    {
+        std::unique_lock<std::mutex> lock(_sweeper_mutex);
+        while (true)
+        {
+            uint64_t now = nowMs(), due = _next_sweep.load(std::memory_order_relaxed);
+            if (_wakeup.wait_for(lock, std::chrono::milliseconds(due > now ? due - now : 0), [this]()
+                                 { return _stop; }))
+                return;
+            lock.unlock();
+            std::vector<Summary> summaries;
+            sweepIfDue(nowMs(), &summaries);
+            emit(summaries);
+            lock.lock();
+        }
+    }
+    void emit(const std::vector<Summary> &summaries)
+    {
+        if (summaries.empty())
+            return;
+        // 日志器按本 sink 的独立格式渲染交给它的日志，未设置时用日志器格式
+        Xulog::Formatter::ptr formatter = getFormatter();
+        if (formatter == nullptr)
+            formatter = _logger_formatter;
+        for (auto &s : summaries)
+        {
+            Xulog::LogMsg msg = s.msg;
+            msg._payload = "last message repeated " + std::to_string(s.repeated) + " times";
+            std::string line = formatter->Format(msg);
+            forward(line.c_str(), line.size(), msg);
+        }
+    }
+    void forward(const char *data, size_t len, const Xulog::LogMsg &msg)
+    {
+        if (_inner->threadSafe())
+        {
+            _inner->log(data, len, msg);
+            return;
+        }
+        std::unique_lock<std::mutex> lock(_inner->mutex());
+        _inner->log(data, len, msg);
+    }
+    void forward(const char *data, size_t len)
+    {
+        if (_inner->threadSafe())
+        {
+            _inner->log(data, len);
+            return;
+        }
+        std::unique_lock<std::mutex> lock(_inner->mutex());
+        _inner->log(data, len);
+    }
+
+private:
+    Xulog::LogSink::ptr _inner;                  ///< 被包装的实际落地
+    size_t _burst;                               ///< 每窗口放行上限
+    uint64_t _interval_ms;                       ///< 窗口长度（毫秒）
+    Xulog::Formatter::ptr _logger_formatter;     ///< 所属日志器的格式，汇总行默认按它渲染
+    std::atomic<uint64_t> _next_sweep;           ///< 下一次清扫时间（毫秒）
+    Shard _shards[SHARD_COUNT];                  ///< 状态分片
+
+    std::mutex _sweeper_mutex;                   ///< 保护 _stop
+    std::condition_variable _wakeup;             ///< 通知清扫线程退出
+    bool _stop = false;                          ///< 退出标志
+    std::thread _sweeper;                        ///< 清扫线程，最后声明以保证其余成员先于它构造
+};
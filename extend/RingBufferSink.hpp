@@ -0,0 +1,244 @@
+/**
+ * @file RingBufferSink.hpp
+ * @brief 定义了 RingBufferSink 类，内存飞行记录仪：环形缓冲保留最近 N 字节日志，出错时落盘
+ *
+ * 日志只写入进程内存中的环形缓冲区，不产生磁盘 I/O，因此可以常开 DEBUG 等级。
+ * 遇到触发等级（默认 ERROR 及以上）的日志、收到注册的信号或调用 dump() 时，
+ * 把缓冲区中尚未导出的记录按顺序交给目标 sink（通常是 FileSink）。
+ *
+ * 写入无锁：多个线程以 fetch_add 预留各自的字节区间后并发拷贝，互不等待。
+ */
+#pragma once
+#include "../logs/Xulog.h"
+#include <atomic>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// @brief 内存环形缓冲日志落地类（飞行记录仪）
+class RingBufferSink : public Xulog::LogSink
+{
+public:
+    using ptr = std::shared_ptr<RingBufferSink>; ///< 环形缓冲落地操作句柄
+
+    /// @brief 构造函数：导出到指定文件
+    /// @param capacity 缓冲区字节数，向上取整为 2 的幂
+    /// @param dump_path 导出文件路径
+    /// @param trigger 触发导出的最低等级，OFF 表示只在信号或手动调用时导出
+    RingBufferSink(size_t capacity, const std::string &dump_path,
+                   Xulog::LogLevel::value trigger = Xulog::LogLevel::value::ERROR)
+        : RingBufferSink(capacity, std::make_shared<Xulog::FileSink>(dump_path), trigger)
+    {
+    }
+    /// @brief 构造函数：导出到任意 sink
+    /// @param capacity 缓冲区字节数，向上取整为 2 的幂
+    /// @param target 导出目标
+    /// @param trigger 触发导出的最低等级，OFF 表示只在信号或手动调用时导出
+    RingBufferSink(size_t capacity, const Xulog::LogSink::ptr &target,
+                   Xulog::LogLevel::value trigger = Xulog::LogLevel::value::ERROR)
+        : _capacity(roundCapacity(capacity)),
+          _buffer(new char[_capacity]),
+          _target(target),
+          _trigger(trigger),
+          _seen_signal(signalGeneration().load(std::memory_order_relaxed))
+    {
+        // 全部填 0xFF：任何位置的标签初始都不等于自身位置，未写过的区域不会被误认成记录
+        memset(_buffer.get(), 0xFF, _capacity);
+    }
+
+    /// @brief 结构化落地：写入环形缓冲，达到触发等级时导出
+    void log(const char *data, size_t len, const Xulog::LogMsg &msg) override
+    {
+        append(data, len);
+        if (msg._level >= _trigger)
+            dump();
+        else
+            checkSignal();
+    }
+    /// @brief 字节落地：只写入环形缓冲
+    void log(const char *data, size_t len) override
+    {
+        append(data, len);
+        checkSignal();
+    }
+    /// @brief 写入无锁，导出自带互斥，同步日志器无需为其加锁
+    bool threadSafe() const override { return true; }
+
+    /// @brief 把上次导出之后仍留在缓冲区中的记录按写入顺序交给目标 sink
+    /// @return 导出的记录条数
+    size_t dump()
+    {
+        std::unique_lock<std::mutex> lock(_dump_mutex);
+        uint64_t head = _head.load(std::memory_order_acquire);
+        uint64_t pos = head > _capacity ? head - _capacity : 0;
+        // 从上次导出处继续时 pos 必定是记录边界；窗口起点可能落在某条记录中间，需要向后找记录头
+        bool boundary = pos <= _dumped;
+        if (pos < _dumped)
+            pos = _dumped;
+        std::vector<std::string> records;
+        std::string rec;
+        while (pos < head)
+        {
+            size_t total = 0;
+            if (readRecord(pos, &rec, &total))
+            {
+                records.push_back(std::move(rec));
+                pos += total;
+                boundary = true;
+                continue;
+            }
+            if (!boundary || overwritten(pos))
+            {
+                pos += ALIGN; // 不在记录边界上或已被覆盖，向后找下一个记录头
+                boundary = false;
+                continue;
+            }
+            // 记录边界上的记录已预留但尚未提交：写者正在拷贝，稍等片刻；
+            // 仍未提交时停在这里，下次导出从该记录继续，不把它当作已导出
+            if (!waitCommitted(pos))
+                break;
+        }
+        _dumped = pos;
+        lock.unlock();
+
+        for (auto &r : records)
+        {
+            if (_target->threadSafe())
+            {
+                _target->log(r.c_str(), r.size());
+                continue;
+            }
+            std::unique_lock<std::mutex> target_lock(_target->mutex());
+            _target->log(r.c_str(), r.size());
+        }
+        return records.size();
+    }
+
+    /// @brief 注册信号：收到该信号后，各 RingBufferSink 在下一条日志到来时导出
+    /// @param signo 信号编号，如 SIGUSR1
+    /// @note 信号处理函数只递增一个原子计数，导出在日志线程完成，不在信号上下文中分配内存或加锁
+    static void dumpOnSignal(int signo)
+    {
+        std::signal(signo, &RingBufferSink::onSignal);
+    }
+
+    /// @brief 缓冲区实际容量（字节）
+    size_t capacity() const { return _capacity; }
+
+private:
+    static constexpr size_t ALIGN = 16;      ///< 记录对齐，保证记录头不跨越缓冲区末尾
+    static constexpr size_t HEADER_SIZE = 16; ///< 记录头：8 字节位置标签 + 4 字节长度 + 4 字节保留
+    static constexpr int COMMIT_SPINS = 1000; ///< 等待未提交记录的最多让出次数
+
+    /// @brief 记录头：tag 等于记录的绝对写入位置时表示该记录已完整提交
+    struct Header
+    {
+        std::atomic<uint64_t> tag;
+        uint32_t len;
+        uint32_t reserved;
+    };
+
+    static size_t roundCapacity(size_t capacity)
+    {
+        size_t cap = 4096;
+        while (cap < capacity)
+            cap <<= 1;
+        return cap;
+    }
+    static std::atomic<unsigned> &signalGeneration()
+    {
+        static std::atomic<unsigned> gen(0);
+        return gen;
+    }
+    static void onSignal(int)
+    {
+        signalGeneration().fetch_add(1, std::memory_order_relaxed);
+    }
+    void checkSignal()
+    {
+        unsigned gen = signalGeneration().load(std::memory_order_relaxed);
+        if (gen == _seen_signal.load(std::memory_order_relaxed))
+            return;
+        _seen_signal.store(gen, std::memory_order_relaxed);
+        dump();
+    }
+    Header *headerAt(uint64_t pos) { return reinterpret_cast<Header *>(_buffer.get() + (pos & (_capacity - 1))); }
+
+    /// @brief pos 处的记录是否已被后续写入覆盖
+    bool overwritten(uint64_t pos) const { return _head.load(std::memory_order_acquire) > pos + _capacity; }
+    /// @brief 短暂等待 pos 处的记录提交，写者只差一次内存拷贝，通常几微秒内完成
+    bool waitCommitted(uint64_t pos)
+    {
+        for (int i = 0; i < COMMIT_SPINS; i++)
+        {
+            if (headerAt(pos)->tag.load(std::memory_order_acquire) == pos || overwritten(pos))
+                return true;
+            std::this_thread::yield();
+        }
+        return false;
+    }
+    /// @brief 无锁追加：预留区间 → 拷贝正文 → 最后发布标签
+    void append(const char *data, size_t len)
+    {
+        size_t max_len = _capacity / 2 - HEADER_SIZE; // 单条记录至多占半个缓冲区，超出截断
+        if (len > max_len)
+            len = max_len;
+        size_t total = (HEADER_SIZE + len + ALIGN - 1) & ~(ALIGN - 1);
+        uint64_t pos = _head.fetch_add(total, std::memory_order_relaxed);
+
+        Header *hdr = headerAt(pos);
+        hdr->tag.store(~uint64_t(0), std::memory_order_relaxed); // 先作废旧标签，防止读到半新半旧的记录
+        hdr->len = (uint32_t)len;
+        copyIn(pos + HEADER_SIZE, data, len);
+        hdr->tag.store(pos, std::memory_order_release);
+    }
+    /// @brief 读取 pos 处的记录，成功时 total 返回记录占用的对齐后字节数
+    bool readRecord(uint64_t pos, std::string *out, size_t *total)
+    {
+        Header *hdr = headerAt(pos);
+        if (hdr->tag.load(std::memory_order_acquire) != pos)
+            return false;
+        size_t len = hdr->len;
+        if (len > _capacity / 2)
+            return false;
+        out->resize(len);
+        copyOut(pos + HEADER_SIZE, &(*out)[0], len);
+        // 拷贝完成后确认期间没有写者预留到覆盖该记录的区间（seqlock 式校验）
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (_head.load(std::memory_order_relaxed) > pos + _capacity)
+            return false;
+        if (hdr->tag.load(std::memory_order_relaxed) != pos)
+            return false;
+        *total = (HEADER_SIZE + len + ALIGN - 1) & ~(ALIGN - 1);
+        return true;
+    }
+    void copyIn(uint64_t pos, const char *data, size_t len)
+    {
+        size_t off = pos & (_capacity - 1);
+        size_t first = len < _capacity - off ? len : _capacity - off;
+        memcpy(_buffer.get() + off, data, first);
+        memcpy(_buffer.get(), data + first, len - first);
+    }
+    void copyOut(uint64_t pos, char *data, size_t len)
+    {
+        size_t off = pos & (_capacity - 1);
+        size_t first = len < _capacity - off ? len : _capacity - off;
+        memcpy(data, _buffer.get() + off, first);
+        memcpy(data + first, _buffer.get(), len - first);
+    }
+
+private:
+    size_t _capacity;                    ///< 缓冲区容量（2 的幂）
+    std::unique_ptr<char[]> _buffer;     ///< 环形缓冲区
+    std::atomic<uint64_t> _head{0};      ///< 下一条记录的绝对写入位置（单调递增）
+    Xulog::LogSink::ptr _target;         ///< 导出目标
+    Xulog::LogLevel::value _trigger;     ///< 触发导出的最低等级
+    std::mutex _dump_mutex;              ///< 导出互斥，写入路径不使用
+    uint64_t _dumped = 0;                ///< 已导出到的绝对位置，避免重复导出
+    std::atomic<unsigned> _seen_signal;  ///< 已处理的信号代数
+};
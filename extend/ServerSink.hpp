@@ -3,15 +3,41 @@
  * @brief 定义了 ServerSink 类，用于将日志信息发送到远程服务器
  *
  * 此文件包含 ServerSink 类的声明，该类继承自 Xulog::LogSink，
- * 实现了将日志信息通过 UDP 协议发送到指定的远程服务器的功能。
+ * 通过一条长连接把日志发送到远程日志服务器。
  *
+ * 业务线程只把编码好的帧追加到内存队列，由后台发送线程攒批后一次写出：
+ * 队列达到 batch_bytes、等待超过 flush_ms 或遇到 ERROR 及以上等级时立即发送。
+ * 连接断开后发送线程按指数退避重连，未发送完的帧在新连接上从帧边界重发；
+ * 队列超过 queue_bytes 时新日志被丢弃并计数，业务线程永远不等待网络。
+ *
+ * 配置 spool_dir 后启用本地磁盘暂存（见 DiskSpool.hpp）：服务器不可用或内存队列已满时，
+ * 内存中未发送的帧连同新日志按顺序追加到磁盘，连接恢复后发送线程先按顺序补发暂存，再发送内存队列。
+ * 退出时若仍无法发送，内存中的帧也写入暂存，下次启动时补发。
+ *
+ * 服务端支持确认时（见 server/session.hpp），每条连接先发 HELLO 声明会话与序号，
+ * 送出的帧保留到服务端回复累计确认为止；重连后重传未确认的帧，由服务端按序号去重，
+ * 连接在发送途中断开也不会丢失或重复。旧服务端不回复确认，此时退回只发送不保留。
+ *
+ * compress_level 大于 0 时每批压成一个压缩帧（见 server/compress.hpp），可选与服务端共享的字典；
+ * 需要服务端同样支持压缩帧，默认关闭。
  */
 #pragma once
 #include "../logs/Xulog.h"
+#include "../server/buffer.hpp"
 #include "../server/codec.hpp"
+#include "../server/compress.hpp"
 #include "../server/Socket.hpp"
+#include "DiskSpool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
+#include <random>
 #include <string>
+#include <thread>
 #include <ctime>
 #include <cstdlib>
 #include <unistd.h>
@@ -19,6 +45,26 @@
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <poll.h>
+
+/// @brief 远程落地的发送参数
+struct ServerSinkOptions
+{
+    size_t queue_bytes = 8 * 1024 * 1024;    ///< 内存队列上限（字节），超出时丢弃新日志
+    size_t batch_bytes = 64 * 1024;          ///< 攒够该字节数立即发送
+    size_t flush_ms = 20;                    ///< 最长攒批时间（毫秒）
+    size_t backoff_min_ms = 100;             ///< 重连退避的初始间隔（毫秒）
+    size_t backoff_max_ms = 5000;            ///< 重连退避的最大间隔（毫秒）
+    int timeout_ms = 3000;                   ///< 连接与单次发送的超时（毫秒）
+    std::string spool_dir;                   ///< 磁盘暂存目录，为空时不启用
+    size_t spool_bytes = 256 * 1024 * 1024;  ///< 磁盘暂存上限（字节），超出时淘汰最旧的段
+    size_t segment_bytes = 16 * 1024 * 1024; ///< 暂存段大小（字节）
+    bool acks = true;                        ///< 是否向服务端请求确认并重传未确认的帧
+    int hello_timeout_ms = 1000;             ///< 等待服务端欢迎确认的时间（毫秒），超时视为不支持确认
+    int compress_level = 0;                  ///< 批量压缩级别 1~9，0 表示不压缩
+    size_t compress_min_bytes = 512;         ///< 小于该字节数的批不压缩
+    std::string dictionary;                  ///< 压缩字典，须与服务端配置的字典一致，为空时不用字典
+};
 
 // 设置远程落地方式
 // 后台运行
@@ -29,10 +75,23 @@ public:
     /// @param serverip 服务器ip地址
     /// @param serverport 服务器端口号
     /// @param name 日志器名称（保留以兼容旧调用，内部不再使用）
-    ServerSink(const std::string &serverip, uint16_t serverport, const std::string &name)
-        : _send_socket(std::make_shared<XuServer::TcpSocket>()), _server_ip(serverip), _server_port(serverport)
+    /// @param wire 线上编码格式，默认二进制；对接只认 Json 的旧服务端时选 JSON
+    /// @param options 发送参数
+    ServerSink(const std::string &serverip, uint16_t serverport, const std::string &name,
+               Xulog::WireFormat wire = Xulog::WireFormat::BINARY,
+               const ServerSinkOptions &options = ServerSinkOptions())
+        : _send_socket(std::make_shared<XuServer::TcpSocket>()), _server_ip(serverip), _server_port(serverport),
+          _wire(wire), _options(options)
     {
         (void)name;
+        std::random_device rd;
+        _session = (static_cast<uint64_t>(rd()) << 32 | rd()) ^
+                   static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+        if (!_options.spool_dir.empty())
+            _spool.reset(new DiskSpool(_options.spool_dir, _options.spool_bytes, _options.segment_bytes));
+        if (_options.compress_level > 0)
+            _deflater.reset(new Xulog::Deflater(_options.compress_level, _options.dictionary));
+        _sender = std::thread(&ServerSink::run, this);
     }
     /// @brief 发送数据（结构化重载，优先使用调用链传入的 LogMsg）
     /// @param data 数据指针
@@ -40,39 +99,525 @@ public:
     /// @param msg 结构化日志消息
     void log(const char *data, size_t len, const Xulog::LogMsg &msg) override
     {
-        Json::StreamWriterBuilder writer;
-        std::string jsonString = Json::writeString(writer, Xulog::Codec::toJson(msg));
-        sendJson(jsonString);
+        thread_local std::string frame;
+        beginFrame(&frame);
+        if (_wire == Xulog::WireFormat::BINARY)
+            Xulog::Codec::toBinary(msg, &frame);
+        else
+            frame += Json::writeString(Json::StreamWriterBuilder(), Xulog::Codec::toJson(msg));
+        enqueue(&frame, msg._level >= Xulog::LogLevel::value::ERROR);
     }
     /// @brief 发送数据（字节兜底：异步路径无结构化数据，按非结构化消息发送）
     /// @param data 数据指针
     /// @param len 数据长度
     void log(const char *data, size_t len) override
     {
-        Json::StreamWriterBuilder writer;
-        std::string jsonString = Json::writeString(writer, Xulog::Codec::toJson(std::string(data, len)));
-        sendJson(jsonString);
+        thread_local std::string frame;
+        beginFrame(&frame);
+        if (_wire == Xulog::WireFormat::BINARY)
+            Xulog::Codec::toBinary(data, len, &frame);
+        else
+            frame += Json::writeString(Json::StreamWriterBuilder(), Xulog::Codec::toJson(std::string(data, len)));
+        enqueue(&frame, false);
+    }
+    /// @brief 队列自带互斥，同步日志器无需再为其加锁
+    bool threadSafe() const override { return true; }
+
+    /// @brief 立即发送队列中的日志并等待发送完毕（启用确认时等到全部被确认）
+    /// @param timeout_ms 最长等待时间（毫秒），服务器不可用时到时返回
+    /// @return 队列是否已清空
+    bool flush(size_t timeout_ms = 1000)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _urgent = true;
+        _not_empty.notify_one();
+        return _drained.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this]()
+                                 { return drained(); });
+    }
+    /// @brief 因队列已满（或暂存写入失败）被丢弃的日志条数
+    size_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+    /// @brief 磁盘暂存占用的字节数
+    size_t spoolBytes()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return _spool ? _spool->bytes() : 0;
+    }
+    /// @brief 磁盘暂存超过上限时被淘汰、未能送达的字节数
+    size_t evictedBytes()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return _spool ? _spool->evictedBytes() : 0;
+    }
+    /// @brief 建立过的连接次数（含重连）
+    size_t connects() const { return _connects.load(std::memory_order_relaxed); }
+    /// @brief 已送出的帧在压缩前的字节数
+    size_t rawBytes() const { return _raw_bytes.load(std::memory_order_relaxed); }
+    /// @brief 已送出的帧在线上的字节数（启用压缩时为压缩后，含重连后重传的待确认帧）
+    size_t wireBytes() const { return _wire_bytes.load(std::memory_order_relaxed); }
+    /// @brief 已送出、尚待服务端确认的字节数
+    size_t unackedBytes()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return _unacked.size();
     }
 
     ~ServerSink()
     {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _not_empty.notify_one();
+        _sender.join(); // 发送线程退出前尽力发完队列
         _send_socket->CloseSockFd();
     }
 
 private:
-    void sendJson(const std::string &jsonString)
+    /// @brief 清空帧缓冲并预留 4 字节长度前缀，正文直接编码在其后
+    static void beginFrame(std::string *frame)
     {
-        uint32_t sz = htonl(static_cast<uint32_t>(jsonString.size()));
-        std::vector<char> buffer(sizeof(uint32_t) + jsonString.size());
-        ::memcpy(buffer.data(), &sz, sizeof(uint32_t));
-        ::memcpy(buffer.data() + sizeof(uint32_t), jsonString.data(), jsonString.size());
-        std::string ip = _server_ip;
-        _send_socket->BuildConnectSockedMethod(ip, _server_port);
-        _send_socket->Send(buffer);
+        frame->assign(sizeof(uint32_t), '\0');
+    }
+    /// @brief 回填长度前缀并入队；队列已满时丢弃
+    void enqueue(std::string *frame, bool urgent)
+    {
+        uint32_t sz = htonl(static_cast<uint32_t>(frame->size() - sizeof(uint32_t)));
+        ::memcpy(&(*frame)[0], &sz, sizeof(uint32_t));
+        std::unique_lock<std::mutex> lock(_mutex);
+        bool full = _pending.size() + _sending.size() + _unacked.size() + frame->size() > _options.queue_bytes;
+        if (_spool && (_down || full))
+        {
+            // 服务器不可用或内存队列已满：连同内存中尚未发送的帧按顺序写入磁盘
+            if (!spill(frame->data(), frame->size()))
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (full)
+        {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        bool was_empty = _pending.empty();
+        _pending += *frame;
+        if (urgent)
+            _urgent = true;
+        if (was_empty || urgent || _pending.size() >= _options.batch_bytes)
+            _not_empty.notify_one();
+    }
+    /// @brief 把 _pending 和 data 依次追加到暂存，须持有 _mutex
+    bool spill(const char *data, size_t len)
+    {
+        if (!_pending.empty() && _spool->append(_pending.data(), _pending.size()))
+            _pending.clear();
+        return _pending.empty() && (len == 0 || _spool->append(data, len));
+    }
+    /// @brief 退出时把内存中未送达的帧写入暂存，下次启动补发，须持有 _mutex
+    void persist()
+    {
+        if (!_spool)
+            return;
+        // 暂存非空时会排在其后，仅此情况下顺序不保证
+        if (!_unacked.empty())
+            _spool->append(_unacked.data(), _unacked.size());
+        if (!_from_spool && !_sending.empty())
+            _spool->append(_sending.data(), _sending.size());
+        _unacked.clear();
+        _unacked_frames = 0;
+        _sending.clear();
+        spill(nullptr, 0);
+    }
+    /// @brief 是否有需要发送线程处理的数据，须持有 _mutex
+    bool hasWork() const
+    {
+        return _stop || !_pending.empty() || !_sending.empty() || (_spool && !_spool->empty());
+    }
+    /// @brief 是否所有日志都已送达（启用确认时为已被服务端确认），须持有 _mutex
+    bool drained() const
+    {
+        return _pending.empty() && _sending.empty() && _unacked.empty() && (!_spool || _spool->empty());
+    }
+    /// @brief 发送线程：补发暂存、攒批、发送、收取确认、失败时退避重连
+    void run()
+    {
+        size_t backoff = _options.backoff_min_ms;
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true)
+        {
+            if (drained())
+                _drained.notify_all();
+            if (_unacked.empty())
+                _not_empty.wait(lock, [this]()
+                                { return hasWork(); });
+            else if (!_not_empty.wait_for(lock, std::chrono::milliseconds(_options.flush_ms), [this]()
+                                          { return hasWork(); }))
+            {
+                // 只剩待确认的帧：收取确认，连接已断开时重连并重传
+                lock.unlock();
+                size_t sent;
+                bool ok = sendBatch(&sent);
+                lock.lock();
+                if (!ok && !backoffWait(lock, &backoff))
+                    break;
+                continue;
+            }
+            if (_sending.empty())
+            {
+                if (_spool && !_spool->empty())
+                {
+                    // 暂存中的帧比内存队列旧，先补发；退出时不再补发，留给下次启动
+                    if (_stop)
+                    {
+                        persist();
+                        break;
+                    }
+                    _spool->read(&_sending, _options.batch_bytes);
+                    _from_spool = true;
+                    _sending_packed = false;
+                }
+                else
+                {
+                    // 攒批：不足一批时最多再等 flush_ms
+                    _not_empty.wait_for(lock, std::chrono::milliseconds(_options.flush_ms), [this]()
+                                        { return _stop || _urgent || _pending.size() >= _options.batch_bytes; });
+                    _sending.swap(_pending);
+                    _from_spool = false;
+                    _sending_packed = false;
+                    _urgent = false;
+                }
+            }
+            if (_sending.empty())
+            {
+                if (_stop)
+                {
+                    finish(lock);
+                    break;
+                }
+                continue;
+            }
+            lock.unlock();
+            // 上一轮已压好、只送出一部分的批原样重发，不能再压一层
+            if (!_sending_packed)
+            {
+                _sending_raw = _sending.size();
+                _sending_packed = pack(lock);
+            }
+            size_t raw = _sending_raw;
+            bool packed = _sending_packed;
+            size_t sent;
+            bool ok = sendBatch(&sent);
+            lock.lock();
+            // 已完整送出的帧编上序号，启用确认时保留到被确认为止；半帧在新连接上从头重发
+            size_t boundary = ok ? sent : frameBoundary(_sending, sent);
+            retain(_sending.data(), boundary);
+            _raw_bytes.fetch_add(packed ? (ok ? raw : 0) : boundary, std::memory_order_relaxed);
+            _wire_bytes.fetch_add(boundary, std::memory_order_relaxed);
+            if (_from_spool)
+                _spool->consume(packed ? (ok ? raw : 0) : boundary); // 其余部分仍在磁盘上，之后重新读取
+            if (ok)
+            {
+                _sending.clear();
+                _down = false;
+                backoff = _options.backoff_min_ms;
+                continue;
+            }
+            if (_from_spool)
+                _sending.clear();
+            else
+            {
+                _sending.erase(0, boundary);
+                if (_spool && _spool->empty() && _spool->append(_sending.data(), _sending.size()))
+                {
+                    _sending.clear();
+                    spill(nullptr, 0);
+                }
+            }
+            if (!backoffWait(lock, &backoff))
+                break;
+        }
+    }
+    /// @brief 把 _sending 压成一个压缩帧，压缩后不更小时保持原样
+    /// @param lock 未持有的 _mutex 锁，只在替换 _sending 时短暂加锁
+    /// @return 是否已替换为压缩帧
+    bool pack(std::unique_lock<std::mutex> &lock)
+    {
+        // 断线积压后 _sending 可能远大于一批：超过服务端的解压上限时不压缩，按原样逐帧发送
+        if (!_deflater || _sending.size() < _options.compress_min_bytes || _sending.size() > Xulog::Compression::MAX_RAW)
+            return false;
+        // 暂存中可能有断线时已压好的批，服务端只解一层，含压缩帧的批按原样发送
+        if (_from_spool && hasPacked(_sending))
+            return false;
+        beginFrame(&_packed);
+        if (!_deflater->compress(_sending.data(), _sending.size(), &_packed) || _packed.size() >= _sending.size())
+            return false;
+        uint32_t sz = htonl(static_cast<uint32_t>(_packed.size() - sizeof(uint32_t)));
+        ::memcpy(&_packed[0], &sz, sizeof(uint32_t));
+        lock.lock();
+        _sending.swap(_packed);
+        lock.unlock();
+        return true;
+    }
+    /// @brief 发送失败后标记断线并退避等待，须持有 _mutex
+    /// @return 需要退出时写入暂存并返回 false
+    bool backoffWait(std::unique_lock<std::mutex> &lock, size_t *backoff)
+    {
+        _down = true;
+        if (_stop)
+        {
+            persist();
+            return false;
+        }
+        _not_empty.wait_for(lock, std::chrono::milliseconds(*backoff), [this]()
+                            { return _stop; });
+        *backoff = std::min(*backoff * 2, _options.backoff_max_ms);
+        return true;
+    }
+    /// @brief 退出前等待最后的确认，仍未确认的帧写入暂存，须持有 _mutex
+    void finish(std::unique_lock<std::mutex> &lock)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(_options.timeout_ms);
+        while (!_unacked.empty() && _send_socket->GetSockFd() != XuServer::DEFAULT_SOCKFD &&
+               std::chrono::steady_clock::now() < deadline)
+        {
+            lock.unlock();
+            bool ok = requestAck() && pollAcks(_options.flush_ms);
+            lock.lock();
+            if (!ok)
+                break;
+        }
+        persist();
+    }
+    /// @brief 记录已送出的帧：推进序号，启用确认时保留到被确认为止，须持有 _mutex
+    void retain(const char *data, size_t len)
+    {
+        size_t frames = frameCount(data, len);
+        _next_seq += frames;
+        if (!_acks)
+            return;
+        _unacked.append(data, len);
+        _unacked_frames += frames;
+        trimAcked();
+    }
+    /// @brief 丢弃已被确认的帧，须持有 _mutex
+    void trimAcked()
+    {
+        size_t pos = 0;
+        uint64_t first = _next_seq - _unacked_frames;
+        while (_unacked_frames > 0 && first <= _acked_seq)
+        {
+            uint32_t sz;
+            ::memcpy(&sz, _unacked.data() + pos, sizeof(uint32_t));
+            pos += sizeof(uint32_t) + ntohl(sz);
+            _unacked_frames--;
+            first++;
+        }
+        _unacked.erase(0, pos);
+    }
+    /// @brief 发送 _sending，必要时先建立连接，发送后收取确认；
+    /// 没有新数据时（只剩待确认的帧）发 SYNC 请求确认：服务端攒够帧数或等满时间才提交并确认，空闲时靠它触发
+    /// @param sent 已发送的 _sending 字节数
+    /// @return 连接是否正常，失败时连接已关闭
+    bool sendBatch(size_t *sent)
+    {
+        *sent = 0;
+        if (_send_socket->GetSockFd() == XuServer::DEFAULT_SOCKFD && !connect())
+            return false;
+        if (_sending.empty() && _acks && !requestAck())
+        {
+            _send_socket->CloseSockFd();
+            return false;
+        }
+        *sent = _send_socket->SendAll(_sending.data(), _sending.size());
+        if (*sent == _sending.size() && pollAcks(0))
+            return true;
         _send_socket->CloseSockFd();
+        return false;
+    }
+    /// @brief 发送 SYNC 控制帧
+    bool requestAck()
+    {
+        std::string body, frame;
+        Xulog::Codec::toControl(Xulog::Codec::Control::SYNC, 0, 0, &body);
+        XuServer::FrameDecoder::encode(body.data(), body.size(), &frame);
+        return _send_socket->SendAll(frame.data(), frame.size()) == frame.size();
+    }
+    /// @brief 建立连接；启用确认时发 HELLO 并重传待确认的帧（服务端按序号去重），再等待欢迎确认
+    bool connect()
+    {
+        std::string ip = _server_ip;
+        if (!_send_socket->BuildConnectSockedMethod(ip, _server_port, _options.timeout_ms))
+        {
+            _send_socket->CloseSockFd();
+            return false;
+        }
+        _send_socket->SetNoDelay(); // 已自行攒批，不再需要 Nagle
+        _connects.fetch_add(1, std::memory_order_relaxed);
+        _acks_in = XuServer::Buffer();
+        if (!_options.acks)
+            return true;
+        std::string hello, body;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _acks = false;
+            Xulog::Codec::toControl(Xulog::Codec::Control::HELLO, _session, _next_seq - _unacked_frames, &body);
+        }
+        XuServer::FrameDecoder::encode(body.data(), body.size(), &hello);
+        // _unacked 只由发送线程修改，此处读取无需加锁
+        if (_send_socket->SendAll(hello.data(), hello.size()) != hello.size() ||
+            _send_socket->SendAll(_unacked.data(), _unacked.size()) != _unacked.size())
+        {
+            _send_socket->CloseSockFd();
+            return false;
+        }
+        _wire_bytes.fetch_add(_unacked.size(), std::memory_order_relaxed); // 重传同样占用线路
+        _welcomed = false;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(_options.hello_timeout_ms);
+        while (!_welcomed && std::chrono::steady_clock::now() < deadline)
+        {
+            if (!pollAcks(_options.flush_ms))
+            {
+                _send_socket->CloseSockFd();
+                return false;
+            }
+        }
+        std::unique_lock<std::mutex> lock(_mutex);
+        _acks = _welcomed;
+        if (!_acks)
+        {
+            // 旧服务端不回复确认：待确认的帧已重发一次，之后不再保留
+            _unacked.clear();
+            _unacked_frames = 0;
+        }
+        return true;
+    }
+    /// @brief 收取服务端的确认
+    /// @param wait_ms 最长等待时间（毫秒），0 表示只读取已到达的数据
+    /// @return 连接已关闭或出错时返回 false
+    bool pollAcks(int wait_ms)
+    {
+        int fd = _send_socket->GetSockFd();
+        if (wait_ms > 0)
+        {
+            struct pollfd pfd = {fd, POLLIN, 0};
+            if (::poll(&pfd, 1, wait_ms) <= 0)
+                return true;
+        }
+        while (true)
+        {
+            char buf[4096];
+            ssize_t n = ::recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+            if (n > 0)
+            {
+                _acks_in.append(buf, n);
+                continue;
+            }
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+                return false;
+            break;
+        }
+        uint64_t acked = 0;
+        bool got = false;
+        bool ok = XuServer::FrameDecoder::decode(_acks_in, [&](const char *data, size_t len)
+                                                 {
+                                                     Xulog::Codec::Control type;
+                                                     uint64_t seq, unused;
+                                                     if (Xulog::Codec::parseControl(data, len, &type, &seq, &unused) &&
+                                                         type == Xulog::Codec::Control::ACK)
+                                                     {
+                                                         acked = std::max(acked, seq);
+                                                         got = true;
+                                                     } });
+        if (got)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _welcomed = true;
+            _acked_seq = std::max(_acked_seq, acked);
+            trimAcked();
+        }
+        return ok;
+    }
+    /// @brief batch 中是否有压缩帧
+    static bool hasPacked(const std::string &batch)
+    {
+        size_t pos = 0;
+        while (pos + sizeof(uint32_t) <= batch.size())
+        {
+            uint32_t sz;
+            ::memcpy(&sz, batch.data() + pos, sizeof(uint32_t));
+            size_t body = pos + sizeof(uint32_t), next = body + ntohl(sz);
+            if (next > batch.size())
+                break;
+            if (Xulog::Compression::isCompressed(batch.data() + body, next - body))
+                return true;
+            pos = next;
+        }
+        return false;
+    }
+    /// @brief [data, data + len) 中的完整帧数
+    static size_t frameCount(const char *data, size_t len)
+    {
+        size_t pos = 0, n = 0;
+        while (pos + sizeof(uint32_t) <= len)
+        {
+            uint32_t sz;
+            ::memcpy(&sz, data + pos, sizeof(uint32_t));
+            pos += sizeof(uint32_t) + ntohl(sz);
+            if (pos > len)
+                break;
+            n++;
+        }
+        return n;
+    }
+    /// @brief 不超过 offset 的最后一个帧边界
+    static size_t frameBoundary(const std::string &batch, size_t offset)
+    {
+        size_t pos = 0;
+        while (pos + sizeof(uint32_t) <= batch.size())
+        {
+            uint32_t sz;
+            ::memcpy(&sz, batch.data() + pos, sizeof(uint32_t));
+            size_t next = pos + sizeof(uint32_t) + ntohl(sz);
+            if (next > offset)
+                break;
+            pos = next;
+        }
+        return pos;
     }
 
-    std::shared_ptr<XuServer::TcpSocket> _send_socket; ///< TCP socket
+    std::shared_ptr<XuServer::TcpSocket> _send_socket; ///< TCP socket，仅发送线程使用
     std::string _server_ip;                            ///< 服务器ip
     uint16_t _server_port;                             ///< 服务器port
-};
\ No newline at end of file
+    Xulog::WireFormat _wire;                           ///< 线上编码格式
+    ServerSinkOptions _options;                        ///< 发送参数
+
+    std::mutex _mutex;                  ///< 保护以下队列状态
+    std::condition_variable _not_empty; ///< 通知发送线程有数据或需要退出
+    std::condition_variable _drained;   ///< 通知 flush 队列已清空
+    std::string _pending;               ///< 业务线程追加的帧
+    std::string _sending;               ///< 发送线程正在发送的一批帧
+    bool _from_spool = false;           ///< _sending 是否读自磁盘暂存
+    bool _down = false;                 ///< 上一次发送失败，新日志直接写入暂存
+    std::unique_ptr<DiskSpool> _spool;  ///< 磁盘暂存，未启用时为空
+    bool _urgent = false;               ///< 跳过攒批立即发送
+    bool _stop = false;                 ///< 退出标志
+    std::string _unacked;               ///< 已送出、待确认的帧，只由发送线程修改
+    size_t _unacked_frames = 0;         ///< _unacked 中的帧数
+    uint64_t _next_seq = 1;             ///< 下一个送出的帧的序号
+    uint64_t _acked_seq = 0;            ///< 服务端确认的最大序号
+    bool _acks = false;                 ///< 当前连接的服务端是否回复确认
+    std::atomic<size_t> _dropped{0};    ///< 队列满时丢弃的条数
+    std::atomic<size_t> _connects{0};   ///< 建立连接的次数
+    std::thread _sender;                ///< 发送线程
+
+    uint64_t _session = 0;      ///< 会话 id，进程内每个落地唯一
+    XuServer::Buffer _acks_in;  ///< 确认帧的读缓冲，仅发送线程使用
+    bool _welcomed = false;     ///< 本连接是否已收到确认，仅发送线程使用
+
+    std::unique_ptr<Xulog::Deflater> _deflater; ///< 批量压缩器，未启用时为空，仅发送线程使用
+    std::string _packed;                        ///< 压缩输出缓冲，仅发送线程使用
+    bool _sending_packed = false;               ///< _sending 已是压缩帧（部分发送后留下的），仅发送线程使用
+    size_t _sending_raw = 0;                    ///< _sending 压缩前的字节数，仅发送线程使用
+    std::atomic<size_t> _raw_bytes{0};          ///< 已送出的压缩前字节数
+    std::atomic<size_t> _wire_bytes{0};         ///< 已送出的线上字节数
+};
@@ -0,0 +1,234 @@
+/**
+ * @file UdpSink.hpp
+ * @brief 定义了 UdpSink 类，用 UDP 把日志发送到远程服务器
+ *
+ * 与 ServerSink 使用相同的帧格式与编码，服务端解码路径相同（见 server/udpserver.hpp）。
+ * 业务线程只把编码好的帧追加到内存队列；后台线程把相邻的多条帧装进同一个数据报
+ * （不超过 datagram_bytes），再用 sendmmsg 一次系统调用发出多个数据报，数据直接从队列缓冲发出，不再拷贝。
+ *
+ * 没有连接、确认与重传：服务器不可用、内核缓冲溢出或网络丢包时日志直接丢失，
+ * 适合量大且可以容忍丢失的调试类日志，开销远低于 ServerSink。
+ */
+#pragma once
+#include "../logs/Xulog.h"
+#include "../server/codec.hpp"
+#include "../server/Socket.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+/// @brief UDP 落地的发送参数
+struct UdpSinkOptions
+{
+    size_t datagram_bytes = 1400;         ///< 单个数据报的目标大小，默认不超过以太网 MTU，避免 IP 分片
+    size_t batch_datagrams = 64;          ///< 每次 sendmmsg 最多发送的数据报数
+    size_t flush_ms = 10;                 ///< 最长攒批时间（毫秒）
+    size_t queue_bytes = 4 * 1024 * 1024; ///< 内存队列上限（字节），超出时丢弃新日志
+};
+
+/// @brief UDP 远程落地，后台发送，允许丢失
+class UdpSink : public Xulog::LogSink
+{
+public:
+    static constexpr size_t MAX_DATAGRAM = 65507; ///< IPv4 UDP 数据报的最大正文，更大的单条日志被丢弃
+
+    /// @brief 构造函数
+    /// @param serverip 服务器ip地址
+    /// @param serverport 服务器UDP端口号
+    /// @param wire 线上编码格式
+    /// @param options 发送参数
+    UdpSink(const std::string &serverip, uint16_t serverport,
+            Xulog::WireFormat wire = Xulog::WireFormat::BINARY,
+            const UdpSinkOptions &options = UdpSinkOptions())
+        : _wire(wire), _options(options), _iovs(options.batch_datagrams), _msgs(options.batch_datagrams)
+    {
+        if (!_socket.BuildConnectSockedMethod(serverip, serverport))
+            throw std::runtime_error("UdpSink 地址无效: " + serverip);
+        for (size_t i = 0; i < _msgs.size(); i++)
+        {
+            ::memset(&_msgs[i], 0, sizeof(_msgs[i]));
+            _msgs[i].msg_hdr.msg_iov = &_iovs[i];
+            _msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        _sender = std::thread(&UdpSink::run, this);
+    }
+    /// @brief 发送数据（结构化重载）
+    /// @param data 数据指针
+    /// @param len 数据长度
+    /// @param msg 结构化日志消息
+    void log(const char *data, size_t len, const Xulog::LogMsg &msg) override
+    {
+        thread_local std::string frame;
+        frame.assign(sizeof(uint32_t), '\0');
+        if (_wire == Xulog::WireFormat::BINARY)
+            Xulog::Codec::toBinary(msg, &frame);
+        else
+            frame += Json::writeString(Json::StreamWriterBuilder(), Xulog::Codec::toJson(msg));
+        enqueue(&frame);
+    }
+    /// @brief 发送数据（字节兜底，按非结构化消息发送）
+    /// @param data 数据指针
+    /// @param len 数据长度
+    void log(const char *data, size_t len) override
+    {
+        thread_local std::string frame;
+        frame.assign(sizeof(uint32_t), '\0');
+        if (_wire == Xulog::WireFormat::BINARY)
+            Xulog::Codec::toBinary(data, len, &frame);
+        else
+            frame += Json::writeString(Json::StreamWriterBuilder(), Xulog::Codec::toJson(std::string(data, len)));
+        enqueue(&frame);
+    }
+    /// @brief 队列自带互斥，同步日志器无需再为其加锁
+    bool threadSafe() const override { return true; }
+
+    /// @brief 立即发出队列中的日志并等待发送线程处理完毕（不代表已送达）
+    /// @param timeout_ms 最长等待时间（毫秒）
+    /// @return 队列是否已清空
+    bool flush(size_t timeout_ms = 1000)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _urgent = true;
+        _not_empty.notify_one();
+        return _drained.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this]()
+                                 { return _pending.empty() && !_busy; });
+    }
+    /// @brief 因队列已满或单条过大被丢弃的日志条数
+    size_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+    /// @brief 已发出的数据报数
+    size_t datagrams() const { return _datagrams.load(std::memory_order_relaxed); }
+    /// @brief 发送失败（如服务器端口不可达）而丢失的数据报数
+    size_t sendErrors() const { return _send_errors.load(std::memory_order_relaxed); }
+
+    ~UdpSink()
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _not_empty.notify_one();
+        _sender.join(); // 发送线程退出前发完队列
+        _socket.CloseSockFd();
+    }
+
+private:
+    /// @brief 回填长度前缀并入队；队列已满或单条超过数据报上限时丢弃
+    void enqueue(std::string *frame)
+    {
+        if (frame->size() > MAX_DATAGRAM)
+        {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        uint32_t sz = htonl(static_cast<uint32_t>(frame->size() - sizeof(uint32_t)));
+        ::memcpy(&(*frame)[0], &sz, sizeof(uint32_t));
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_pending.size() + frame->size() > _options.queue_bytes)
+        {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        bool was_empty = _pending.empty();
+        _pending += *frame;
+        if (was_empty || _pending.size() >= batchBytes())
+            _not_empty.notify_one();
+    }
+    /// @brief 一次 sendmmsg 能装下的字节数，攒够即发送
+    size_t batchBytes() const { return _options.datagram_bytes * _options.batch_datagrams; }
+    /// @brief 发送线程：攒批后整批打包发送
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true)
+        {
+            _not_empty.wait(lock, [this]()
+                            { return _stop || !_pending.empty(); });
+            _not_empty.wait_for(lock, std::chrono::milliseconds(_options.flush_ms), [this]()
+                                { return _stop || _urgent || _pending.size() >= batchBytes(); });
+            _sending.swap(_pending);
+            _urgent = false;
+            _busy = true;
+            lock.unlock();
+            send();
+            _sending.clear();
+            lock.lock();
+            _busy = false;
+            if (_pending.empty())
+                _drained.notify_all();
+            if (_stop && _pending.empty())
+                break;
+        }
+    }
+    /// @brief 把 _sending 中相邻的帧装进数据报，每攒满 batch_datagrams 个调用一次 sendmmsg
+    void send()
+    {
+        size_t count = 0, pos = 0;
+        while (pos < _sending.size())
+        {
+            // 从 pos 起尽量多装完整的帧；单帧超过目标大小时单独成包
+            size_t start = pos;
+            while (pos < _sending.size())
+            {
+                uint32_t sz;
+                ::memcpy(&sz, _sending.data() + pos, sizeof(uint32_t));
+                size_t next = pos + sizeof(uint32_t) + ntohl(sz);
+                if (pos > start && next - start > _options.datagram_bytes)
+                    break;
+                pos = next;
+            }
+            _iovs[count].iov_base = &_sending[start];
+            _iovs[count].iov_len = pos - start;
+            if (++count == _msgs.size())
+            {
+                sendMany(count);
+                count = 0;
+            }
+        }
+        if (count > 0)
+            sendMany(count);
+    }
+    /// @brief 发出 _msgs 的前 count 个数据报；出错时跳过出错的数据报继续发送
+    void sendMany(size_t count)
+    {
+        size_t done = 0;
+        while (done < count)
+        {
+            int n = _socket.SendMany(&_msgs[done], count - done);
+            if (n > 0)
+            {
+                done += n;
+                _datagrams.fetch_add(n, std::memory_order_relaxed);
+                continue;
+            }
+            // 典型情况是上一个数据报触发的 ICMP 端口不可达（ECONNREFUSED），丢弃当前数据报
+            _send_errors.fetch_add(1, std::memory_order_relaxed);
+            done++;
+        }
+    }
+
+    XuServer::UdpSocket _socket;       ///< 已固定对端地址的 UDP socket，仅发送线程使用
+    Xulog::WireFormat _wire;           ///< 线上编码格式
+    UdpSinkOptions _options;           ///< 发送参数
+    std::vector<struct iovec> _iovs;   ///< 每个数据报指向 _sending 中的一段，仅发送线程使用
+    std::vector<struct mmsghdr> _msgs; ///< sendmmsg 的消息数组，仅发送线程使用
+
+    std::mutex _mutex;                   ///< 保护以下队列状态
+    std::condition_variable _not_empty;  ///< 通知发送线程有数据或需要退出
+    std::condition_variable _drained;    ///< 通知 flush 队列已清空
+    std::string _pending;                ///< 业务线程追加的帧
+    std::string _sending;                ///< 发送线程正在发送的一批帧
+    bool _urgent = false;                ///< 跳过攒批立即发送
+    bool _busy = false;                  ///< 发送线程正在发送
+    bool _stop = false;                  ///< 退出标志
+    std::atomic<size_t> _dropped{0};     ///< 丢弃的日志条数
+    std::atomic<size_t> _datagrams{0};   ///< 发出的数据报数
+    std::atomic<size_t> _send_errors{0}; ///< 发送失败的数据报数
+    std::thread _sender;                 ///< 发送线程
+};
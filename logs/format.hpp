@@ -230,6 +230,17 @@ namespace Xulog
         %n 换行
     */
 
+    /**
+     * @brief 一次格式化的结果：输出字节流及其中 %p 的区间
+     */
+    struct FormattedLine
+    {
+        std::string data;                     ///< 格式化后的字节流
+        size_t level_pos = std::string::npos; ///< %p 起始偏移，未知为 npos
+        size_t level_len = 0;                 ///< %p 字节长度
+        bool rendered = false;                ///< 本条消息是否已渲染该格式
+    };
+
     /**
      * @brief 格式化器类，负责将日志消息格式化为字符串
      */
@@ -276,9 +287,25 @@ namespace Xulog
          */
         void Format(std::ostream &out, LogMsg &msg)
         {
-            for (auto &item : _items)
+            msg._level_pos = std::string::npos;
+            msg._level_len = 0;
+            std::streampos base = out.tellp();
+            for (size_t i = 0; i < _items.size(); i++)
             {
-                item->format(out, msg);
+                if (i != _level_idx)
+                {
+                    _items[i]->format(out, msg);
+                    continue;
+                }
+                // 记录 %p 在输出中的字节区间，彩色输出据此直接拼接颜色码
+                std::streampos begin = out.tellp();
+                _items[i]->format(out, msg);
+                std::streampos end = out.tellp();
+                if (base != std::streampos(-1) && begin != std::streampos(-1) && end != std::streampos(-1))
+                {
+                    msg._level_pos = (size_t)(begin - base);
+                    msg._level_len = (size_t)(end - begin);
+                }
             }
         }
         // 对格式化内容进行解析
@@ -366,6 +393,8 @@ namespace Xulog
             // 初始化成员
             for (auto &it : fmt_order)
             {
+                if (it.first == "p" && _level_idx == std::string::npos)
+                    _level_idx = _items.size();
                 _items.push_back(createItem(it.first, it.second));
             }
             return true;
@@ -402,7 +431,8 @@ namespace Xulog
         }
 
     private:
-        std::string _pattern;                ///< 格式化规则字符串
-        std::vector<FormatItem::ptr> _items; ///< 格式化子项集合
+        std::string _pattern;                         ///< 格式化规则字符串
+        std::vector<FormatItem::ptr> _items;          ///< 格式化子项集合
+        size_t _level_idx = std::string::npos;        ///< 首个 %p 子项的下标，无则为 npos
     };
 }
@@ -57,7 +57,36 @@ namespace Xulog
             : _logger_name(loggername),
               _limit_level(level),
               _formatter(formatter),
-              _sinks(sinks.begin(), sinks.end()) {}
+              _sinks(sinks.begin(), sinks.end()),
+              _sink_min_level(LogLevel::value::OFF)
+        {
+            if (_formatter == nullptr)
+                _formatter = std::make_shared<Formatter>();
+            // 格式 0 为日志器自身格式；sink 独立格式按格式串去重，相同格式串共享同一次渲染
+            _formatters.push_back(_formatter);
+            for (auto &sink : _sinks)
+            {
+                size_t idx = 0;
+                Formatter::ptr sink_fmt = sink->getFormatter();
+                if (sink_fmt != nullptr && sink_fmt->getPattern() != _formatter->getPattern())
+                {
+                    idx = _formatters.size();
+                    for (size_t i = 1; i < _formatters.size(); i++)
+                    {
+                        if (_formatters[i]->getPattern() == sink_fmt->getPattern())
+                        {
+                            idx = i;
+                            break;
+                        }
+                    }
+                    if (idx == _formatters.size())
+                        _formatters.push_back(sink_fmt);
+                }
+                _sink_fmt.push_back(idx);
+                if (sink->getLevel() < _sink_min_level)
+                    _sink_min_level = sink->getLevel();
+            }
+        }
         /**
          * @brief 获取日志器名称
          *
@@ -106,33 +135,112 @@ namespace Xulog
         }
 
     protected:
-        /// @brief 纯虚：派生类实现原始字节落地
-        virtual void log(const char *data, size_t len) = 0;
-        /// @brief 纯虚重载：结构化 sink 可覆盖此版本获取 LogMsg；默认转发到字节版本
-        virtual void log(const char *data, size_t len, const LogMsg &) { log(data, len); }
+        /// @brief 纯虚：派生类实现落地，entry 携带结构化 LogMsg 及各格式的渲染结果
+        virtual void log(AsyncEntry &&entry) = 0;
 
         /// @brief 格式化并落地，LogMsg 为栈上局部变量，不共享
         void serialize(LogLevel::value level, const std::string &file, size_t line, char *str)
         {
-            LogMsg msg(level, line, file, _logger_name, str);
-            std::stringstream ss;
-            _formatter->Format(ss, msg);
-            const std::string &out = ss.str();
-            log(out.c_str(), out.size(), msg);
+            AsyncEntry entry{LogMsg(level, line, file, _logger_name, str), std::string(), {}};
+            render(entry);
+            log(std::move(entry));
+        }
+
+        /// @brief 渲染：只渲染本条等级下有 sink 需要的格式，每种不同格式只渲染一次
+        /// @note 日志器格式的 %p 区间留在 entry.msg 中，独立格式的区间记录在各自的 FormattedLine 中
+        void render(AsyncEntry &entry)
+        {
+            LogMsg &msg = entry.msg;
+            if (_formatters.size() > 1)
+                entry.extra.resize(_formatters.size() - 1);
+            bool primary = false;
+            size_t level_pos = std::string::npos, level_len = 0;
+            for (size_t i = 0; i < _sinks.size(); i++)
+            {
+                if (!_sinks[i]->shouldLog(msg._level))
+                    continue;
+                size_t idx = _sink_fmt[i];
+                if (idx == 0)
+                {
+                    if (primary)
+                        continue;
+                    entry.formatted = formatWith(_formatters[0], msg);
+                    level_pos = msg._level_pos;
+                    level_len = msg._level_len;
+                    primary = true;
+                    continue;
+                }
+                FormattedLine &line = entry.extra[idx - 1];
+                if (line.rendered)
+                    continue;
+                line.data = formatWith(_formatters[idx], msg);
+                line.level_pos = msg._level_pos;
+                line.level_len = msg._level_len;
+                line.rendered = true;
+            }
+            msg._level_pos = level_pos;
+            msg._level_len = level_len;
+        }
+
+        /// @brief 分发：按 sink 等级过滤，交给每个 sink 其格式对应的渲染结果
+        /// @note 按 sink 加锁而非整个日志器加锁，写不同 fd 的线程可并行；线程安全的 sink 不加锁
+        void dispatch(AsyncEntry &entry)
+        {
+            LogMsg &msg = entry.msg;
+            size_t level_pos = msg._level_pos, level_len = msg._level_len;
+            for (size_t i = 0; i < _sinks.size(); i++)
+            {
+                LogSink::ptr &sink = _sinks[i];
+                if (!sink->shouldLog(msg._level))
+                    continue;
+                const std::string *data = &entry.formatted;
+                size_t idx = _sink_fmt[i];
+                if (idx == 0)
+                {
+                    msg._level_pos = level_pos;
+                    msg._level_len = level_len;
+                }
+                else
+                {
+                    FormattedLine &line = entry.extra[idx - 1];
+                    data = &line.data;
+                    msg._level_pos = line.level_pos;
+                    msg._level_len = line.level_len;
+                }
+                if (sink->threadSafe())
+                {
+                    sink->log(data->c_str(), data->size(), msg);
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(sink->mutex());
+                sink->log(data->c_str(), data->size(), msg);
+            }
+            msg._level_pos = level_pos;
+            msg._level_len = level_len;
         }
 
-        std::mutex _mutex;                         ///< 互斥锁
         std::string _logger_name;                  ///< 日志器名称
         std::atomic<LogLevel::value> _limit_level; ///< 日志级别
         Formatter::ptr _formatter;                 ///< 日志格式化器
         std::vector<LogSink::ptr> _sinks;          ///< 日志输出接收器
         LoggerType _logger_type;
+        std::vector<Formatter::ptr> _formatters;   ///< 去重后的格式化器，[0] 为日志器自身格式
+        std::vector<size_t> _sink_fmt;             ///< 每个 sink 使用的格式化器在 _formatters 中的下标
+        LogLevel::value _sink_min_level;           ///< 所有 sink 中最低的等级门槛，低于它的日志无人接收
 
     private:
+        /// @brief 用指定格式化器渲染一条消息
+        static std::string formatWith(const Formatter::ptr &formatter, LogMsg &msg)
+        {
+            std::stringstream ss;
+            formatter->Format(ss, msg);
+            return ss.str();
+        }
         /// @brief 五个等级接口的统一实现：等级过滤 → vasprintf → serialize
         void vlog(LogLevel::value level, const std::string &file, size_t line, const char *fmt, va_list ap)
         {
-            if (level < _limit_level)
+            // 没有任何 sink 接收该等级时，连 vasprintf 与格式化都跳过
+            if (level < _limit_level || level < _sink_min_level)
                 return;
             char *res = nullptr;
             int ret = vasprintf(&res, fmt, ap);
@@ -169,26 +277,17 @@ namespace Xulog
         }
 
     protected:
-        /// @brief 同步落地：把字节流和结构化 LogMsg 一并交给各 sink
-        void log(const char *data, size_t len, const LogMsg &msg) override
+        /// @brief 同步落地：在调用线程直接分发给各 sink
+        void log(AsyncEntry &&entry) override
         {
-            std::unique_lock<std::mutex> lock(_mutex);
-            for (auto &sink : _sinks)
-                sink->log(data, len, msg);
-        }
-        /// @brief 纯虚基类要求的字节版本：转发到结构化版本（构造空 msg 兜底，正常不会走到）
-        void log(const char *data, size_t len) override
-        {
-            std::unique_lock<std::mutex> lock(_mutex);
-            for (auto &sink : _sinks)
-                sink->log(data, len);
+            dispatch(entry);
         }
     };
     /**
      * @class AsyncLogger
      * @brief 异步日志器（M2：无锁 MPSC 队列 + 结构化异步落地）
      *
-     * 生产者线程：serialize 格式化 → log(data,len,msg) → 构造 AsyncEntry 入队
+     * 生产者线程：serialize 格式化 → log(entry) → AsyncEntry 入队
      * 消费者线程：realLog 批量取出 → 逐条分发到 sink（结构化 + 字节双形态）
      */
     class AsyncLogger : public Logger
@@ -207,16 +306,10 @@ namespace Xulog
             _logger_type = LoggerType::LOGGER_ASYNC;
         }
 
-        /// @brief 结构化入队：生产者线程调用，构造 AsyncEntry 并推入无锁队列
-        void log(const char *data, size_t len, const LogMsg &msg) override
-        {
-            _looper->push(AsyncEntry{msg, std::string(data, len)});
-        }
-
-        /// @brief 字节版本兜底（不应被调用，serialize 已统一走结构化版本）
-        void log(const char *data, size_t len) override
+        /// @brief 结构化入队：生产者线程调用，把已渲染的 AsyncEntry 推入无锁队列
+        void log(AsyncEntry &&entry) override
         {
-            _looper->push(AsyncEntry{LogMsg(), std::string(data, len)});
+            _looper->push(std::move(entry));
         }
 
         /// @brief 消费者回调：批量取出 AsyncEntry，逐条分发给各 sink
@@ -225,12 +318,7 @@ namespace Xulog
             if (_sinks.empty())
                 return;
             for (auto &entry : entries)
-            {
-                for (auto &sink : _sinks)
-                {
-                    sink->log(entry.formatted.c_str(), entry.formatted.size(), entry.msg);
-                }
-            }
+                dispatch(entry);
         }
 
     private:
@@ -334,6 +422,28 @@ namespace Xulog
             LogSink::ptr psink = SinkFactory::create<SinkType>(std::forward<Args>(args)...);
             _sinks.push_back(psink);
         }
+        /**
+         * @brief 为最近一次 buildSink 添加的接收器设置独立的日志格式
+         *
+         * @param pattern 日志输出的格式，格式说明同 buildFormatter
+         * @note 不设置则沿用日志器格式；日志器对每条消息的每种不同格式只渲染一次
+         */
+        void buildSinkFormatter(const std::string &pattern)
+        {
+            assert(!_sinks.empty());
+            _sinks.back()->setFormatter(std::make_shared<Formatter>(pattern));
+        }
+        /**
+         * @brief 为最近一次 buildSink 添加的接收器设置最低输出等级
+         *
+         * @param level 日志级别，低于该等级的日志不会交给此接收器
+         * @note 所有接收器都不接收的等级直接跳过格式化
+         */
+        void buildSinkLevel(LogLevel::value level)
+        {
+            assert(!_sinks.empty());
+            _sinks.back()->setLevel(level);
+        }
         /**
          * @brief 建造日志器
          *
@@ -8,6 +8,7 @@
 
 #include "mpsc_queue.hpp"
 #include "message.hpp"
+#include "format.hpp"
 #include <mutex>
 #include <condition_variable>
 #include <thread>
@@ -21,8 +22,9 @@ namespace Xulog
     /// @brief 异步队列元素：携带结构化 LogMsg + 预格式化字符串
     struct AsyncEntry
     {
-        LogMsg msg;             ///< 结构化字段（DataBaseSink 用）
-        std::string formatted;  ///< 预格式化字符串（Stdout/File 用，生产者线程完成格式化）
+        LogMsg msg;                       ///< 结构化字段（DataBaseSink 用）
+        std::string formatted;            ///< 日志器格式的预格式化字符串（Stdout/File 用，生产者线程完成格式化）
+        std::vector<FormattedLine> extra; ///< sink 独立格式的渲染结果，下标为格式序号 - 1；无独立格式时为空
     };
 
     /// @brief 消费者回调类型：一次处理一批 AsyncEntry
@@ -115,9 +117,11 @@ namespace Xulog
         AsyncType _looper_type;          ///< 异步类型
         BatchCallback _callBack;         ///< 消费者回调
         std::atomic<bool> _stop;         ///< 停止标志
-        std::thread _thread;             ///< 消费者线程
         std::mutex _sleep_mutex;         ///< 休眠锁（仅消费者侧）
         std::condition_variable _sleep_cv; ///< 休眠条件变量（仅消费者侧）
+        // 线程必须最后声明：成员按声明顺序初始化，线程启动时锁和条件变量须已构造完毕，
+        // 否则条件变量在消费者已等待后才被构造（重置内部状态），析构时 notify 可能永久阻塞
+        std::thread _thread;             ///< 消费者线程
     };
 
 } // namespace Xulog
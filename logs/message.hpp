@@ -23,12 +23,15 @@ namespace Xulog
     struct LogMsg
     {
         time_t _ctime;          ///< 日志产生的时间戳
+        long _usec = 0;         ///< 时间戳秒内的微秒数
         size_t _line;           ///< 行号
         std::thread::id _tid;   ///< 线程ID
         LogLevel::value _level; ///< 日志等级
         std::string _file;      ///< 源文件名称
         std::string _logger;    ///< 日志器
         std::string _payload;   ///< 有效载荷数据
+        size_t _level_pos = std::string::npos; ///< 格式化输出中 %p 的起始偏移（由 Formatter 填写，未知为 npos）
+        size_t _level_len = 0;                 ///< 格式化输出中 %p 的字节长度
         LogMsg() {}
 
         /**
@@ -46,14 +49,14 @@ namespace Xulog
                size_t line,
                const std::string file,
                const std::string logger,
-               const std::string msg) : _ctime(Util::Date::getTime()),
-                                        _line(line),
+               const std::string msg) : _line(line),
                                         _tid(std::this_thread::get_id()),
                                         _level(level),
                                         _file(file),
                                         _logger(logger),
                                         _payload(msg)
         {
+            _ctime = Util::Date::getTime(&_usec); // 秒与微秒取自同一时刻
         }
     };
 }
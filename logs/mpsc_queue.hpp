@@ -40,45 +40,35 @@ namespace Xulog
         /// @brief 尝试入队：成功返回 true；SAFE 模式满时返回 false（调用方应重试）
         bool tryPush(const T &item)
         {
-            if (_safe_mode && _count.load(std::memory_order_relaxed) >= _max_size)
+            if (full())
                 return false;
+            link(new Node(T(item))); // 拷贝一份，成功后移动进节点
+            return true;
+        }
 
-            auto *node = new Node(T(item)); // 拷贝一份，成功后移动进节点
-
-            Node *old_head = _head.load(std::memory_order_relaxed);
-            do
-            {
-                node->next.store(old_head, std::memory_order_relaxed);
-            } while (!_head.compare_exchange_weak(old_head, node,
-                                                   std::memory_order_release,
-                                                   std::memory_order_relaxed));
-
-            _count.fetch_add(1, std::memory_order_relaxed);
-            _has_data.store(true, std::memory_order_release);
+        /// @brief 尝试入队（移动）：只有成功时才移走 item
+        bool tryPush(T &&item)
+        {
+            if (full())
+                return false;
+            link(new Node(std::move(item)));
             return true;
         }
 
         /// @brief 推入队列，SAFE 模式下阻塞直到成功；UNSAFE 直接入队
         void push(const T &item)
         {
-            if (_safe_mode)
-            {
-                while (!tryPush(item))
-                    std::this_thread::yield();
-            }
-            else
-            {
-                auto *node = new Node(T(item));
-                Node *old_head = _head.load(std::memory_order_relaxed);
-                do
-                {
-                    node->next.store(old_head, std::memory_order_relaxed);
-                } while (!_head.compare_exchange_weak(old_head, node,
-                                                       std::memory_order_release,
-                                                       std::memory_order_relaxed));
-                _count.fetch_add(1, std::memory_order_relaxed);
-                _has_data.store(true, std::memory_order_release);
-            }
+            while (full())
+                std::this_thread::yield();
+            link(new Node(T(item)));
+        }
+
+        /// @brief 推入队列（移动），大对象入队时免去一次拷贝
+        void push(T &&item)
+        {
+            while (full())
+                std::this_thread::yield();
+            link(new Node(std::move(item)));
         }
 
         /// @brief 消费者：一次取出全部元素（FIFO 顺序）
@@ -134,6 +124,26 @@ namespace Xulog
         }
 
     private:
+        /// @brief SAFE 模式下队列是否已满
+        bool full() const
+        {
+            return _safe_mode && _count.load(std::memory_order_relaxed) >= _max_size;
+        }
+        /// @brief CAS 把节点挂到头部
+        void link(Node *node)
+        {
+            Node *old_head = _head.load(std::memory_order_relaxed);
+            do
+            {
+                node->next.store(old_head, std::memory_order_relaxed);
+            } while (!_head.compare_exchange_weak(old_head, node,
+                                                   std::memory_order_release,
+                                                   std::memory_order_relaxed));
+
+            _count.fetch_add(1, std::memory_order_relaxed);
+            _has_data.store(true, std::memory_order_release);
+        }
+
         std::atomic<Node *> _head{nullptr};
         std::atomic<size_t> _count{0};
         std::atomic<bool> _has_data{false};
@@ -8,6 +8,7 @@
 #pragma once
 #include "util.hpp"
 #include "message.hpp"
+#include "format.hpp"
 #include <memory>
 #include <fstream>
 #include <cassert>
@@ -15,6 +16,11 @@
 #include <cstring>
 #include <vector>
 #include <utility>
+#include <mutex>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
 
 namespace Xulog
 {
@@ -41,12 +47,36 @@ namespace Xulog
         virtual void log(const char *data, size_t len) = 0;
         /// @brief 结构化落地重载，默认转发到字节版本；结构化 sink 可覆盖以获取 LogMsg
         virtual void log(const char *data, size_t len, const LogMsg &msg) { log(data, len); }
+        /// @brief sink 自身能否被多线程并发调用；返回 true 时同步日志器不再为其加锁
+        virtual bool threadSafe() const { return false; }
+        /// @brief 每个 sink 独立的互斥锁，同步日志器按 sink 加锁，互不相关的 sink 可并行写
+        std::mutex &mutex() { return _mutex; }
+
+        /// @brief 设置该 sink 独立的格式化器，为空则沿用日志器的格式化器
+        /// @note 需在构建日志器之前设置
+        void setFormatter(const Formatter::ptr &formatter) { _formatter = formatter; }
+        /// @brief 获取该 sink 独立的格式化器，未设置返回空指针
+        Formatter::ptr getFormatter() const { return _formatter; }
+        /// @brief 设置该 sink 的最低输出等级，低于此等级的日志不会交给该 sink
+        /// @note 需在构建日志器之前设置
+        void setLevel(LogLevel::value level) { _level = level; }
+        /// @brief 获取该 sink 的最低输出等级
+        LogLevel::value getLevel() const { return _level; }
+        /// @brief 该 sink 是否接收指定等级的日志
+        bool shouldLog(LogLevel::value level) const { return level >= _level; }
+
+    private:
+        std::mutex _mutex;                              ///< sink 级互斥锁
+        Formatter::ptr _formatter;                      ///< 独立格式化器，空表示沿用日志器格式
+        LogLevel::value _level = LogLevel::value::UNKNOW; ///< 最低输出等级，默认全部接收
     };
     /**
      * @class StdoutSink
      * @brief 标准输出日志落地实现
      *
      * 该类实现了将日志输出到标准输出的功能，并支持日志级别的颜色显示。
+     * 彩色模式下依据 LogMsg 中由 Formatter 记录的 %p 区间直接拼接颜色码，一次 writev 输出，
+     * 不拷贝日志内容，也不会误染正文中出现的等级单词。
      */
     class StdoutSink : public LogSink
     {
@@ -75,64 +105,165 @@ namespace Xulog
          * @param data 日志数据
          * @param len 数据长度
          *
-         * 根据设置输出带颜色的日志。
+         * 无结构化信息时，彩色模式仅为首个出现的等级单词着色。
          */
-        void log(const char *data, size_t len)
+        void log(const char *data, size_t len) override
         {
-            // 设置日志等级颜色并输出
             if (_enable_color == Color::Enable)
             {
-                std::string msg = setColorBasedOnLogLevel(data, len);
-                std::cout << msg;
+                size_t pos = 0, n = 0;
+                LogLevel::value level = findLevel(data, len, &pos, &n);
+                writeColored(data, len, level, pos, n);
                 return;
             }
             std::cout.write(data, len);
         }
+        /**
+         * @brief 结构化日志写入到标准输出
+         *
+         * @param data 日志数据
+         * @param len 数据长度
+         * @param msg 结构化日志消息，_level_pos/_level_len 给出等级在 data 中的位置
+         */
+        void log(const char *data, size_t len, const LogMsg &msg) override
+        {
+            if (_enable_color == Color::Unenable)
+            {
+                std::cout.write(data, len);
+                return;
+            }
+            if (msg._level_pos == std::string::npos || msg._level_pos + msg._level_len > len)
+            {
+                log(data, len);
+                return;
+            }
+            writeColored(data, len, msg._level, msg._level_pos, msg._level_len);
+        }
 
     private:
         /**
-         * @brief 根据日志级别设置颜色
+         * @brief 获取日志等级对应的颜色码
          *
-         * @param message 日志消息
-         * @param len 消息长度
-         * @return std::string 带颜色的日志消息
+         * @param level 日志等级
+         * @return const char* 颜色码，无对应颜色返回 nullptr
          */
-        std::string setColorBasedOnLogLevel(const char *message, size_t len)
+        static const char *colorOf(LogLevel::value level)
         {
-            std::string logMessage(message, len);
-
-            // 存储日志级别和对应颜色
-            std::vector<std::pair<std::string, std::string>> logLevels = {
-                {"DEBUG", COLOR_DEBUG + "DEBUG" + COLOR_RESET},
-                {"INFO", COLOR_INFO + "INFO" + COLOR_RESET},
-                {"WARN", COLOR_WARN + "WARN" + COLOR_RESET},
-                {"ERROR", COLOR_ERROR + "ERROR" + COLOR_RESET},
-                {"FATAL", COLOR_FATAL + "FATAL" + COLOR_RESET}};
-
-            for (auto &level : logLevels)
+            switch (level)
             {
-                size_t pos = 0;
-                while (pos < logMessage.size())
+            case LogLevel::value::DEBUG:
+                return COLOR_DEBUG;
+            case LogLevel::value::INFO:
+                return COLOR_INFO;
+            case LogLevel::value::WARN:
+                return COLOR_WARN;
+            case LogLevel::value::ERROR:
+                return COLOR_ERROR;
+            case LogLevel::value::FATAL:
+                return COLOR_FATAL;
+            default:
+                return nullptr;
+            }
+        }
+        /**
+         * @brief 在无结构化信息的日志中查找首个等级单词（单遍扫描）
+         *
+         * @param data 日志数据
+         * @param len 数据长度
+         * @param pos 输出：等级单词起始偏移
+         * @param n 输出：等级单词长度
+         * @return LogLevel::value 找到的等级，未找到返回 UNKNOW
+         */
+        static LogLevel::value findLevel(const char *data, size_t len, size_t *pos, size_t *n)
+        {
+            static const LogLevel::value levels[] = {LogLevel::value::DEBUG, LogLevel::value::INFO,
+                                                     LogLevel::value::WARN, LogLevel::value::ERROR,
+                                                     LogLevel::value::FATAL};
+            for (size_t i = 0; i < len; i++)
+            {
+                for (auto level : levels)
                 {
-                    size_t found = logMessage.find(level.first, pos);
-                    if (found == std::string::npos)
-                        break;
-                    logMessage.replace(found, level.first.size(), level.second);
-                    pos = found + level.second.size();
+                    const char *name = LogLevel::toString(level);
+                    size_t nlen = strlen(name);
+                    if (data[i] == name[0] && i + nlen <= len && memcmp(data + i, name, nlen) == 0)
+                    {
+                        *pos = i;
+                        *n = nlen;
+                        return level;
+                    }
+                }
+            }
+            return LogLevel::value::UNKNOW;
+        }
+        /**
+         * @brief 将 [pos, pos+n) 区间包上颜色码后一次性写出
+         *
+         * @param data 日志数据
+         * @param len 数据长度
+         * @param level 日志等级
+         * @param pos 等级起始偏移
+         * @param n 等级长度
+         */
+        void writeColored(const char *data, size_t len, LogLevel::value level, size_t pos, size_t n)
+        {
+            const char *color = colorOf(level);
+            if (color == nullptr || n == 0)
+            {
+                std::cout.write(data, len);
+                return;
+            }
+            struct iovec iov[5];
+            iov[0].iov_base = const_cast<char *>(data);
+            iov[0].iov_len = pos;
+            iov[1].iov_base = const_cast<char *>(color);
+            iov[1].iov_len = strlen(color);
+            iov[2].iov_base = const_cast<char *>(data + pos);
+            iov[2].iov_len = n;
+            iov[3].iov_base = const_cast<char *>(COLOR_RESET);
+            iov[3].iov_len = strlen(COLOR_RESET);
+            iov[4].iov_base = const_cast<char *>(data + pos + n);
+            iov[4].iov_len = len - pos - n;
+            // 先冲刷 cout 中已缓冲的内容，保证与其他 stdout 输出的先后顺序
+            std::cout.flush();
+            writevAll(STDOUT_FILENO, iov, 5);
+        }
+        /**
+         * @brief writev 直到全部写完（处理 EINTR 与部分写）
+         */
+        static void writevAll(int fd, struct iovec *iov, int cnt)
+        {
+            while (cnt > 0)
+            {
+                ssize_t ret = ::writev(fd, iov, cnt);
+                if (ret < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    return;
+                }
+                size_t done = (size_t)ret;
+                while (cnt > 0 && done >= iov->iov_len)
+                {
+                    done -= iov->iov_len;
+                    iov++;
+                    cnt--;
+                }
+                if (cnt > 0)
+                {
+                    iov->iov_base = static_cast<char *>(iov->iov_base) + done;
+                    iov->iov_len -= done;
                 }
             }
-
-            return logMessage;
         }
 
     private:
-        const std::string COLOR_DEBUG = "\033[36m"; /**< DEBUG 颜色 */
-        const std::string COLOR_INFO = "\033[32m";  /**< INFO 颜色 */
-        const std::string COLOR_WARN = "\033[33m";  /**< WARN 颜色 */
-        const std::string COLOR_ERROR = "\033[31m"; /**< ERROR 颜色 */
-        const std::string COLOR_FATAL = "\033[35m"; /**< FATAL 颜色 */
-        const std::string COLOR_RESET = "\033[0m";  /**< 颜色重置 */
-        Color _enable_color;                        /**< 颜色启用状态 */
+        static constexpr const char *COLOR_DEBUG = "\033[36m"; /**< DEBUG 颜色 */
+        static constexpr const char *COLOR_INFO = "\033[32m";  /**< INFO 颜色 */
+        static constexpr const char *COLOR_WARN = "\033[33m";  /**< WARN 颜色 */
+        static constexpr const char *COLOR_ERROR = "\033[31m"; /**< ERROR 颜色 */
+        static constexpr const char *COLOR_FATAL = "\033[35m"; /**< FATAL 颜色 */
+        static constexpr const char *COLOR_RESET = "\033[0m";  /**< 颜色重置 */
+        Color _enable_color;                                   /**< 颜色启用状态 */
     };
 
     /**
@@ -140,6 +271,7 @@ namespace Xulog
      * @brief 文件日志落地实现
      *
      * 该类实现了将日志写入到指定文件的功能。
+     * 文件以 O_APPEND 打开，每条预格式化日志一次 write(2) 原子追加，多线程可无锁并发写入。
      */
     class FileSink : public LogSink
     {
@@ -154,9 +286,14 @@ namespace Xulog
         FileSink(const std::string &pathname)
             : _pathname(pathname)
         {
-            Util::File::createDirectory(Util::File::path(_pathname)); // 创建目录
-            _ofs.open(_pathname, std::ios::binary | std::ios::app);   // 打开文件
-            assert(_ofs.is_open());
+            Util::File::createDirectory(Util::File::path(_pathname));                  // 创建目录
+            _fd = ::open(_pathname.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644); // 打开文件
+            assert(_fd >= 0);
+        }
+        ~FileSink()
+        {
+            if (_fd >= 0)
+                ::close(_fd);
         }
         /**
          * @brief 日志写入到文件
@@ -164,17 +301,30 @@ namespace Xulog
          * @param data 日志数据
          * @param len 数据长度
          *
-         * 将日志数据写入文件。
+         * 将日志数据一次性追加写入文件。
          */
-        void log(const char *data, size_t len)
+        void log(const char *data, size_t len) override
         {
-            _ofs.write(data, len);
-            assert(_ofs.good());
+            while (len > 0)
+            {
+                ssize_t ret = ::write(_fd, data, len);
+                if (ret < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    assert(false);
+                    return;
+                }
+                data += ret;
+                len -= ret;
+            }
         }
+        /// @brief O_APPEND 单次 write 追加是原子的，无需同步日志器加锁
+        bool threadSafe() const override { return true; }
 
     private:
         std::string _pathname; /**< 文件路径 */
-        std::ofstream _ofs;    /**< 文件输出流 */
+        int _fd = -1;          /**< 以 O_APPEND 打开的文件描述符 */
     };
     /**
      * @class RollSinkBySize
@@ -33,6 +33,19 @@ namespace Xulog
             {
                 return (size_t)time(nullptr); // 获取当前时间戳
             }
+            /**
+             * @brief 获取当前时间戳（微秒精度）
+             *
+             * @param usec 输出秒内的微秒数
+             * @return time_t 当前时间戳（秒）
+             */
+            static time_t getTime(long *usec)
+            {
+                struct timespec ts;
+                clock_gettime(CLOCK_REALTIME, &ts);
+                *usec = ts.tv_nsec / 1000;
+                return ts.tv_sec;
+            }
         };
         /**
          * @class File
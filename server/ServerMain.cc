@@ -4,6 +4,9 @@
 #include "codec.hpp"
 #include "server.hpp"
 #include "serverlog.hpp"
+#include "udpserver.hpp"
+#include <csignal>
+#include <pthread.h>
 
 int main(int argc, char *argv[])
 {
@@ -14,7 +17,37 @@ int main(int argc, char *argv[])
     }
     XuServer::Config::ptr config = XuServer::Config::getInstance(argv[1]);
     int port = std::stoi(config->get("Server", "port"));
-    std::shared_ptr<XuServer::TcpServer> tps = std::make_shared<XuServer::TcpServer>(port, XuServer::ServerLog::logMsg, 1);
+    // 落地在启动时构造一次；收到 SIGHUP 时重新读取配置并替换落地
+    // 先在主线程屏蔽 SIGHUP，之后创建的线程都继承该屏蔽，由专门的线程同步等待
+    sigset_t hup;
+    sigemptyset(&hup);
+    sigaddset(&hup, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &hup, nullptr);
+    XuServer::ServerLog::ptr log = XuServer::ServerLog::getInstance();
+    std::thread reloader([hup, log]()
+                         {
+                             int sig;
+                             while (sigwait(&hup, &sig) == 0)
+                                 log->reload(); });
+    reloader.detach();
+    // 配置 udp_port 时另开一个线程接收 UDP 日志，帧处理与 TCP 相同
+    std::string udp_port = config->get("Server", "udp_port");
+    if (!udp_port.empty())
+    {
+        std::shared_ptr<XuServer::UdpServer> udp = std::make_shared<XuServer::UdpServer>(
+            std::stoi(udp_port), [log](const char *data, size_t len)
+            { (*log)(data, len); });
+        std::thread([udp]()
+                    { udp->Loop(); })
+            .detach();
+    }
+    // 配置 workers 大于 1 时分片接收：每个事件循环各自监听同一端口并在循环线程上直接处理
+    int shards = std::atoi(config->get("Server", "workers").c_str());
+    std::shared_ptr<XuServer::TcpServer> tps;
+    if (shards > 1)
+        tps = std::make_shared<XuServer::TcpServer>(port, XuServer::ServerLog::logSession, 0, shards, true);
+    else
+        tps = std::make_shared<XuServer::TcpServer>(port, XuServer::ServerLog::logSession, 1);
     tps->Loop();
     return 0;
 }
\ No newline at end of file
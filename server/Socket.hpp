@@ -11,6 +11,9 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <sys/time.h>
 #include "../logs/Xulog.h"
 
 #define Convert(addr_ptr) ((struct sockaddr *)addr_ptr)
@@ -65,22 +68,98 @@ namespace XuServer
         /// @return 返回接收的数据字节数。
         ssize_t RecvFrom(std::vector<char> *buffer, size_t size, std::string *src_ip, uint16_t *src_port)
         {
-            std::vector<char> inbuffer(size);
+            // 直接收进调用方的缓冲，反复使用同一个缓冲时不再分配
+            buffer->resize(size);
             struct sockaddr_in peer;
             socklen_t len = sizeof(peer);
-            ssize_t n = recvfrom(_sockfd, inbuffer.data(), size, 0, Convert(&peer), &len);
+            ssize_t n = recvfrom(_sockfd, buffer->data(), size, 0, Convert(&peer), &len);
             if (n < 0)
                 throw std::runtime_error("recvfrom 失败: " + std::string(strerror(errno)));
+            buffer->resize(n);
             if (n > 0)
             {
-                inbuffer.resize(n);
-                buffer->swap(inbuffer);
                 *src_ip = inet_ntoa(peer.sin_addr);
                 *src_port = ntohs(peer.sin_port);
             }
 
             return n;
         }
+        /// @brief 一次系统调用接收多个数据报（recvmmsg），不阻塞。
+        /// @param msgs 预先指向接收缓冲的消息数组，msg_len 返回各数据报长度。
+        /// @param count 消息数组长度。
+        /// @return 收到的数据报数，没有数据时为 0，出错时为 -1。
+        int RecvMany(struct mmsghdr *msgs, unsigned int count)
+        {
+            while (true)
+            {
+                int n = ::recvmmsg(_sockfd, msgs, count, MSG_DONTWAIT, nullptr);
+                if (n >= 0)
+                    return n;
+                if (errno == EINTR)
+                    continue;
+                return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+            }
+        }
+        /// @brief 一次系统调用发送多个数据报（sendmmsg），发往 BuildConnectSockedMethod 连接的地址。
+        /// @param msgs 消息数组。
+        /// @param count 消息数组长度。
+        /// @return 发出的数据报数，出错时为 -1。
+        int SendMany(struct mmsghdr *msgs, unsigned int count)
+        {
+            while (true)
+            {
+                int n = ::sendmmsg(_sockfd, msgs, count, MSG_NOSIGNAL);
+                if (n >= 0 || errno != EINTR)
+                    return n;
+            }
+        }
+        /// @brief 创建UDP客户端Socket并固定对端地址，之后可直接 SendMany。
+        /// @param serverip 服务器的IP地址。
+        /// @param serverport 服务器的端口号。
+        /// @return 地址非法时返回 false。
+        bool BuildConnectSockedMethod(const std::string &serverip, uint16_t serverport)
+        {
+            CreateSocketOrDie();
+            struct sockaddr_in server;
+            memset(&server, 0, sizeof(server));
+            server.sin_family = AF_INET;
+            server.sin_port = htons(serverport);
+            if (inet_pton(AF_INET, serverip.c_str(), &server.sin_addr) != 1)
+                return false;
+            return ::connect(_sockfd, Convert(&server), sizeof(server)) == 0;
+        }
+        /// @brief 设置内核接收缓冲大小，突发流量时减少丢包。
+        void SetRecvBuffer(int bytes)
+        {
+            ::setsockopt(_sockfd, SOL_SOCKET, SO_RCVBUF, &bytes, sizeof(bytes));
+        }
+        /// @brief 设置Socket为非阻塞模式。
+        void SetNonBlock()
+        {
+            int flags = ::fcntl(_sockfd, F_GETFL, 0);
+            if (flags < 0 || ::fcntl(_sockfd, F_SETFL, flags | O_NONBLOCK) < 0)
+                throw std::runtime_error("fcntl 失败: " + std::string(strerror(errno)));
+        }
+        /// @brief 获取本端绑定的端口号，绑定端口 0 时用于取得系统分配的端口。
+        /// @return 本端端口号，失败返回 0。
+        uint16_t GetLocalPort()
+        {
+            struct sockaddr_in local;
+            socklen_t len = sizeof(local);
+            if (::getsockname(_sockfd, Convert(&local), &len) < 0)
+                return 0;
+            return ntohs(local.sin_port);
+        }
+        /// @brief 获取当前Socket描述符。
+        /// @return 返回当前的Socket描述符。
+        int GetSockFd() { return _sockfd; }
+        /// @brief 关闭当前Socket。
+        void CloseSockFd()
+        {
+            if (_sockfd > DEFAULT_SOCKFD)
+                ::close(_sockfd);
+            _sockfd = DEFAULT_SOCKFD;
+        }
 
     private:
         /// @brief 创建UDP Socket，若创建失败则终止程序。
@@ -130,9 +209,14 @@ namespace XuServer
         /// @brief 创建、绑定并监听Socket。
         /// @param port 要绑定的端口号。
         /// @param backlog 监听队列长度，默认值为DEFAULT_BACKLOG。
-        void BuildListenSocketMethod(uint16_t port, int backlog = DEFAULT_BACKLOG)
+        /// @param reuse_port 是否设置 SO_REUSEPORT，多个 socket 监听同一端口，由内核把新连接分给它们。
+        void BuildListenSocketMethod(uint16_t port, int backlog = DEFAULT_BACKLOG, bool reuse_port = false)
         {
             CreateSocketOrDie();
+            int on = 1;
+            ::setsockopt(_sockfd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)); // 重启时不必等 TIME_WAIT 结束
+            if (reuse_port && ::setsockopt(_sockfd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) < 0)
+                throw std::runtime_error("SO_REUSEPORT 设置失败: " + std::string(strerror(errno)));
             BindSocketOrDie(port);
             ListenSocketOrDie(backlog);
         }
@@ -145,6 +229,20 @@ namespace XuServer
             CreateSocketOrDie();
             return ConnectServer(serverip, serverport);
         }
+        /// @brief 建立TCP客户端连接，连接与之后的每次发送都有超时。
+        /// @param serverip 服务器的IP地址。
+        /// @param serverport 服务器的端口号。
+        /// @param timeout_ms 超时（毫秒）。
+        /// @return 若连接成功，返回true；否则返回false。
+        bool BuildConnectSockedMethod(std::string &serverip, uint16_t serverport, int timeout_ms)
+        {
+            CreateSocketOrDie();
+            struct timeval tv;
+            tv.tv_sec = timeout_ms / 1000;
+            tv.tv_usec = (timeout_ms % 1000) * 1000;
+            ::setsockopt(_sockfd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)); // Linux 下同时限制 connect
+            return ConnectServer(serverip, serverport);
+        }
         /// @brief 设置已建立连接的Socket。
         /// @param sockfd 已建立连接的Socket描述符。
         void BuildNormalSockMethod(int sockfd)
@@ -158,11 +256,35 @@ namespace XuServer
         /// @brief 设置Socket描述符。
         /// @param sockfd 要设置的Socket描述符。
         void SetSockFd(int sockfd) { _sockfd = sockfd; }
+        /// @brief 设为非阻塞模式。
+        void SetNonBlock()
+        {
+            int flags = ::fcntl(_sockfd, F_GETFL, 0);
+            if (flags < 0 || ::fcntl(_sockfd, F_SETFL, flags | O_NONBLOCK) < 0)
+                throw std::runtime_error("fcntl 失败: " + std::string(strerror(errno)));
+        }
+        /// @brief 获取本端绑定的端口号，绑定端口 0 时用于取得系统分配的端口。
+        /// @return 本端端口号，失败返回 0。
+        uint16_t GetLocalPort()
+        {
+            struct sockaddr_in local;
+            socklen_t len = sizeof(local);
+            if (::getsockname(_sockfd, Convert(&local), &len) < 0)
+                return 0;
+            return ntohs(local.sin_port);
+        }
+        /// @brief 关闭 Nagle 算法，由调用方自行攒批。
+        void SetNoDelay()
+        {
+            int on = 1;
+            ::setsockopt(_sockfd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        }
         /// @brief 关闭当前Socket。
         void CloseSockFd()
         {
             if (_sockfd > DEFAULT_SOCKFD)
                 ::close(_sockfd);
+            _sockfd = DEFAULT_SOCKFD;
         }
         /// @brief 接收来自对端的数据。
         /// @param buffer 存储接收到的数据的缓冲区。
@@ -170,9 +292,9 @@ namespace XuServer
         /// @return 接收成功返回true，否则返回false。
         bool Recv(std::vector<char> *buffer, int size = 1024 * 10)
         {
-            std::vector<char> inbuffer(size);
-            ssize_t n = recv(_sockfd, inbuffer.data(), size, 0);
-            std::string str(inbuffer.begin(), inbuffer.end());
+            buffer->resize(size);
+            ssize_t n = recv(_sockfd, buffer->data(), size, 0);
+            buffer->resize(n > 0 ? n : 0);
             if (n == 0)
             {
                 INFO("客户端连接已断开！");
@@ -183,22 +305,41 @@ namespace XuServer
                 ERROR("revc失败！");
                 return false;
             }
-            if (n > 0)
-            {
-                inbuffer.resize(n);
-                buffer->swap(inbuffer);
-                return true;
-            }
-            return false;
+            return true;
         }
         /// @brief 向对端发送数据。
         /// @param send_data 要发送的数据。
         void Send(const std::vector<char> &send_data)
         {
-            ssize_t ret = send(_sockfd, send_data.data(), send_data.size(), 0);
+            Send(send_data.data(), send_data.size());
+        }
+        /// @brief 向对端发送数据。
+        /// @param data 数据起始地址。
+        /// @param len 数据长度。
+        void Send(const char *data, size_t len)
+        {
+            ssize_t ret = send(_sockfd, data, len, 0);
             if (ret < 0)
                 throw std::runtime_error("send 失败: " + std::string(strerror(errno)));
         }
+        /// @brief 发送全部数据，对端关闭时不产生 SIGPIPE。
+        /// @param data 数据起始地址。
+        /// @param len 数据长度。
+        /// @return 出错前已发送的字节数，等于 len 表示全部发送成功。
+        size_t SendAll(const char *data, size_t len)
+        {
+            size_t sent = 0;
+            while (sent < len)
+            {
+                ssize_t n = ::send(_sockfd, data + sent, len - sent, MSG_NOSIGNAL);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0)
+                    break;
+                sent += n;
+            }
+            return sent;
+        }
         /// @brief 接收新的TCP连接。
         /// @param peerip 存储对端的IP地址。
         /// @param peerport 存储对端的端口号。
@@ -0,0 +1,149 @@
+/// @file buffer.hpp
+/// @brief 连接读缓冲与长度前缀帧解码
+///
+/// 缓冲区是一段连续内存加读写下标：数据从 socket 直接读进缓冲尾部，
+/// 解码时在原地取出完整帧，不完整的帧留在缓冲中与后续数据拼接，
+/// 空间不足时先把剩余数据挪回头部，仍不够再扩容，因此帧长度不受单次读取大小限制。
+#pragma once
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include <sys/uio.h>
+
+namespace XuServer
+{
+    /// @class Buffer
+    /// @brief 可增长的连续字节缓冲：[0, _read) 已消费，[_read, _write) 待处理，[_write, size) 可写
+    class Buffer
+    {
+    public:
+        /// @brief 构造函数
+        /// @param initial 初始容量
+        explicit Buffer(size_t initial = 4096) : _buf(initial) {}
+
+        /// @brief 待处理的字节数
+        size_t readable() const { return _write - _read; }
+        /// @brief 待处理数据的起始地址
+        const char *peek() const { return _buf.data() + _read; }
+        /// @brief 消费头部 n 个字节
+        void retrieve(size_t n)
+        {
+            if (n >= readable())
+                _read = _write = 0;
+            else
+                _read += n;
+        }
+        /// @brief 追加数据
+        void append(const char *data, size_t len)
+        {
+            ensureWritable(len);
+            memcpy(_buf.data() + _write, data, len);
+            _write += len;
+        }
+        /// @brief 保证尾部至少有 n 字节可写：先回收头部已消费的空间，不够再扩容
+        void ensureWritable(size_t n)
+        {
+            if (_buf.size() - _write >= n)
+                return;
+            if (_buf.size() - readable() >= n)
+            {
+                size_t len = readable();
+                memmove(_buf.data(), _buf.data() + _read, len);
+                _read = 0;
+                _write = len;
+                return;
+            }
+            _buf.resize(_write + n);
+        }
+        /// @brief 从描述符读一次，尾部空间不足时借用栈上的临时空间，读完再拷回
+        /// @param fd 非阻塞描述符
+        /// @param saved_errno 出错时的 errno
+        /// @return read 的返回值
+        ssize_t readFd(int fd, int *saved_errno)
+        {
+            char extra[65536];
+            struct iovec vec[2];
+            size_t writable = _buf.size() - _write;
+            vec[0].iov_base = _buf.data() + _write;
+            vec[0].iov_len = writable;
+            vec[1].iov_base = extra;
+            vec[1].iov_len = sizeof(extra);
+            ssize_t n = ::readv(fd, vec, writable < sizeof(extra) ? 2 : 1);
+            if (n < 0)
+                *saved_errno = errno;
+            else if ((size_t)n <= writable)
+                _write += n;
+            else
+            {
+                _write = _buf.size();
+                append(extra, n - writable);
+            }
+            return n;
+        }
+        /// @brief 当前占用的内存大小
+        size_t capacity() const { return _buf.size(); }
+
+    private:
+        std::vector<char> _buf; ///< 底层存储
+        size_t _read = 0;       ///< 读下标
+        size_t _write = 0;      ///< 写下标
+    };
+
+    /// @class FrameDecoder
+    /// @brief 长度前缀帧：4 字节网络序长度 + 正文
+    class FrameDecoder
+    {
+    public:
+        static constexpr uint32_t MAX_FRAME = 4 * 1024 * 1024; ///< 默认单帧上限，超出视为协议错误；客户端一批约 64KB
+
+        /// @brief 依次取出缓冲中的完整帧交给 fn(data, len)，data 直接指向缓冲内部；不完整的帧留在缓冲中
+        /// 不按声明的帧长预留空间：长度来自对端，只随实际读到的数据扩容，声明大帧却不发的连接占不了内存
+        /// @param max_frame 单帧上限
+        /// @return 遇到超长帧返回 false，调用方应关闭连接
+        template <typename Fn>
+        static bool decode(Buffer &in, Fn fn, uint32_t max_frame = MAX_FRAME)
+        {
+            while (in.readable() >= sizeof(uint32_t))
+            {
+                uint32_t sz_net;
+                ::memcpy(&sz_net, in.peek(), sizeof(uint32_t));
+                uint32_t sz = ntohl(sz_net);
+                if (sz > max_frame)
+                    return false;
+                if (in.readable() < sizeof(uint32_t) + sz)
+                    break;
+                fn(in.peek() + sizeof(uint32_t), (size_t)sz);
+                in.retrieve(sizeof(uint32_t) + sz);
+            }
+            return true;
+        }
+        /// @brief 依次取出一段连续内存中的完整帧交给 fn(data, len)，用于数据报和解压后的批
+        /// @return 末尾有不完整的帧时返回 false，之前的完整帧已交付
+        template <typename Fn>
+        static bool decode(const char *data, size_t len, Fn fn)
+        {
+            size_t pos = 0;
+            while (pos + sizeof(uint32_t) <= len)
+            {
+                uint32_t sz;
+                ::memcpy(&sz, data + pos, sizeof(uint32_t));
+                sz = ntohl(sz);
+                pos += sizeof(uint32_t);
+                if (sz > len - pos)
+                    return false;
+                fn(data + pos, (size_t)sz);
+                pos += sz;
+            }
+            return pos == len;
+        }
+        /// @brief 给正文加上长度前缀
+        static void encode(const char *data, size_t len, std::string *out)
+        {
+            uint32_t sz = htonl(static_cast<uint32_t>(len));
+            out->append(reinterpret_cast<const char *>(&sz), sizeof(uint32_t));
+            out->append(data, len);
+        }
+    };
+}
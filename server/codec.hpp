@@ -2,7 +2,10 @@
 /// @brief 对日志信息进行序列化和反序列化
 #pragma once
 #include <jsoncpp/json/json.h>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <thread>
 #include <string>
 #include <vector>
@@ -19,6 +22,34 @@ namespace Xulog
         std::string unformatted_msg; ///< 非结构化消息
         LogMsg format_msg;           ///< 结构化信息
     };
+    /// @brief 线上编码格式，由帧的首字节区分，服务端两种都接收
+    enum class WireFormat
+    {
+        JSON,  ///< Json 文本，首字节为 '{' 或空白
+        BINARY ///< 二进制，首字节为版本号（最高位为 1）
+    };
+    /// @struct BytesRef
+    /// @brief 指向接收缓冲中的一段字节，解码时不拷贝
+    struct BytesRef
+    {
+        const char *data = nullptr; ///< 起始地址
+        size_t len = 0;             ///< 长度
+        /// @brief 拷贝为字符串
+        std::string str() const { return std::string(data, len); }
+    };
+    /// @struct WireMsg
+    /// @brief 二进制帧的解码结果，字符串字段直接指向帧内，帧所在的缓冲被消费前有效
+    struct WireMsg
+    {
+        bool formatted = false;                       ///< 是否结构化消息
+        LogLevel::value level = LogLevel::value::UNKNOW; ///< 日志等级
+        uint64_t time_ns = 0;                         ///< 产生时间（纪元纳秒）
+        uint64_t line = 0;                            ///< 行号
+        uint64_t tid = 0;                             ///< 线程 id 的哈希
+        BytesRef file;                                ///< 源文件名称
+        BytesRef logger;                              ///< 日志器
+        BytesRef payload;                             ///< 有效载荷，非结构化消息时为整条消息
+    };
     /// @classCodec
     /// @brief 序列化与反序列化类
     class Codec
@@ -60,7 +91,186 @@ namespace Xulog
             return dmsg;
         }
 
+        /// 二进制编码 v1：
+        ///   u8 版本(0x81) | u8 标志(bit0 结构化)
+        ///   结构化：  u8 等级 | varint 纳秒时间 | varint 行号 | varint 线程哈希 | 文件 | 日志器 | 正文
+        ///   非结构化：正文
+        /// 字符串均为 varint 长度 + 原始字节；解码忽略末尾多余字节，后续版本可在末尾追加字段
+        static constexpr uint8_t BINARY_V1 = 0x81; ///< 二进制 v1 的首字节，Json 文本的首字节不会大于 0x7F
+
+        /// 控制帧：u8 0x90 | u8 类型 | varint 参数...
+        ///   HELLO（客户端 → 服务端）：会话 id、本连接第一条日志的序号，之后每个数据帧的序号依次加一
+        ///   ACK  （服务端 → 客户端）：累计确认，序号不大于它的日志均已被服务端落地接收
+        ///   SYNC （客户端 → 服务端）：只剩待确认的帧时请求确认，服务端按确认策略决定何时回复，参数为 0；旧服务端忽略
+        static constexpr uint8_t CONTROL = 0x90; ///< 控制帧的首字节
+
+        /// @brief 控制帧类型
+        enum class Control : uint8_t
+        {
+            HELLO = 1, ///< 建立会话
+            ACK = 2,   ///< 累计确认
+            SYNC = 3   ///< 请求确认
+        };
+        /// @brief 判断帧是否为控制帧
+        static bool isControl(const char *data, size_t len)
+        {
+            return len > 0 && static_cast<uint8_t>(data[0]) == CONTROL;
+        }
+        /// @brief 将控制帧追加到 out
+        static void toControl(Control type, uint64_t a, uint64_t b, std::string *out)
+        {
+            out->push_back(static_cast<char>(CONTROL));
+            out->push_back(static_cast<char>(type));
+            putVarint(a, out);
+            if (type == Control::HELLO)
+                putVarint(b, out);
+        }
+        /// @brief 解码控制帧
+        /// @param type 类型
+        /// @param a 第一个参数（HELLO 为会话 id，ACK 为确认序号，SYNC 为 0）
+        /// @param b 第二个参数（HELLO 为第一条日志的序号）
+        /// @return 类型不识别或帧被截断时返回 false
+        static bool parseControl(const char *data, size_t len, Control *type, uint64_t *a, uint64_t *b)
+        {
+            const char *p = data, *end = data + len;
+            if (end - p < 2 || static_cast<uint8_t>(*p++) != CONTROL)
+                return false;
+            *type = static_cast<Control>(*p++);
+            if (*type == Control::ACK || *type == Control::SYNC)
+                return getVarint(&p, end, a);
+            return *type == Control::HELLO && getVarint(&p, end, a) && getVarint(&p, end, b);
+        }
+        /// @brief 判断帧是否为二进制编码
+        static bool isBinary(const char *data, size_t len)
+        {
+            return len > 0 && static_cast<uint8_t>(data[0]) == BINARY_V1;
+        }
+        /// @brief 将结构化信息以二进制编码追加到 out
+        /// @param msg 结构化信息
+        /// @param out 输出缓冲，调用方可复用以避免反复分配
+        static void toBinary(const LogMsg &msg, std::string *out)
+        {
+            out->push_back(static_cast<char>(BINARY_V1));
+            out->push_back(1);
+            out->push_back(static_cast<char>(msg._level));
+            putVarint((uint64_t)msg._ctime * 1000000000ULL + (uint64_t)msg._usec * 1000ULL, out);
+            putVarint(msg._line, out);
+            putVarint(std::hash<std::thread::id>()(msg._tid), out);
+            putBytes(msg._file.data(), msg._file.size(), out);
+            putBytes(msg._logger.data(), msg._logger.size(), out);
+            putBytes(msg._payload.data(), msg._payload.size(), out);
+        }
+        /// @brief 将非结构化信息以二进制编码追加到 out
+        static void toBinary(const char *data, size_t len, std::string *out)
+        {
+            out->push_back(static_cast<char>(BINARY_V1));
+            out->push_back(0);
+            putBytes(data, len, out);
+        }
+        /// @brief 原地解码二进制帧，不分配内存
+        /// @param data 帧起始地址
+        /// @param len 帧长度
+        /// @param out 解码结果，字符串字段指向 data 内部
+        /// @return 版本不识别或帧被截断时返回 false
+        static bool parseBinary(const char *data, size_t len, WireMsg *out)
+        {
+            const char *p = data, *end = data + len;
+            if (end - p < 2 || static_cast<uint8_t>(*p++) != BINARY_V1)
+                return false;
+            out->formatted = (*p++ & 1) != 0;
+            if (!out->formatted)
+                return getBytes(&p, end, &out->payload);
+            if (p == end || static_cast<uint8_t>(*p) > static_cast<uint8_t>(LogLevel::value::OFF))
+                return false;
+            out->level = static_cast<LogLevel::value>(*p++);
+            return getVarint(&p, end, &out->time_ns) && getVarint(&p, end, &out->line) &&
+                   getVarint(&p, end, &out->tid) && getBytes(&p, end, &out->file) &&
+                   getBytes(&p, end, &out->logger) && getBytes(&p, end, &out->payload);
+        }
+        /// @brief 由二进制解码结果构造结构化信息
+        static LogMsg msgFromWire(const WireMsg &wire)
+        {
+            LogMsg msg;
+            msg._ctime = static_cast<time_t>(wire.time_ns / 1000000000ULL);
+            msg._usec = static_cast<long>(wire.time_ns % 1000000000ULL / 1000ULL);
+            msg._line = static_cast<size_t>(wire.line);
+            msg._level = wire.level;
+            msg._file.assign(wire.file.data, wire.file.len);
+            msg._logger.assign(wire.logger.data, wire.logger.len);
+            msg._payload.assign(wire.payload.data, wire.payload.len);
+            return msg;
+        }
+        /// @brief 解码一帧，按首字节选择二进制或 Json
+        /// @param data 帧起始地址
+        /// @param len 帧长度
+        /// @param dmsg 传递消息
+        /// @return 帧无法解析时返回 false
+        static bool fromFrame(const char *data, size_t len, DeliverMsg *dmsg)
+        {
+            if (isBinary(data, len))
+            {
+                WireMsg wire;
+                if (!parseBinary(data, len, &wire))
+                    return false;
+                if (wire.formatted)
+                {
+                    dmsg->msg_mod = "format";
+                    dmsg->format_msg = msgFromWire(wire);
+                }
+                else
+                {
+                    dmsg->msg_mod = "unformatted";
+                    dmsg->unformatted_msg = wire.payload.str();
+                }
+                return true;
+            }
+            // 每个线程一个解析器，直接解析缓冲中的字节，不再拷贝成字符串
+            thread_local std::unique_ptr<Json::CharReader> reader(Json::CharReaderBuilder().newCharReader());
+            Json::Value root;
+            if (!reader->parse(data, data + len, &root, nullptr))
+                return false;
+            *dmsg = fromJson(root);
+            return true;
+        }
+
     private:
+        static void putVarint(uint64_t v, std::string *out)
+        {
+            while (v >= 0x80)
+            {
+                out->push_back(static_cast<char>(v | 0x80));
+                v >>= 7;
+            }
+            out->push_back(static_cast<char>(v));
+        }
+        static void putBytes(const char *data, size_t len, std::string *out)
+        {
+            putVarint(len, out);
+            out->append(data, len);
+        }
+        static bool getVarint(const char **p, const char *end, uint64_t *v)
+        {
+            *v = 0;
+            for (int shift = 0; shift < 64 && *p < end; shift += 7)
+            {
+                uint8_t b = static_cast<uint8_t>(*(*p)++);
+                *v |= static_cast<uint64_t>(b & 0x7F) << shift;
+                if ((b & 0x80) == 0)
+                    return true;
+            }
+            return false;
+        }
+        static bool getBytes(const char **p, const char *end, BytesRef *ref)
+        {
+            uint64_t len;
+            if (!getVarint(p, end, &len) || len > static_cast<uint64_t>(end - *p))
+                return false;
+            ref->data = *p;
+            ref->len = static_cast<size_t>(len);
+            *p += len;
+            return true;
+        }
+
         /// @brief 将结构化信息序列化为Json格式
         /// @param msg 结构化信息
         /// @return Json格式
@@ -68,6 +278,7 @@ namespace Xulog
         {
             Json::Value json;
             json["ctime"] = static_cast<Json::Int64>(msg._ctime);
+            json["usec"] = static_cast<Json::Int64>(msg._usec);
             json["line"] = (Json::UInt64)msg._line;
             std::ostringstream tid_ss;
             tid_ss << msg._tid;
@@ -85,6 +296,7 @@ namespace Xulog
         {
             LogMsg msg;
             msg._ctime = json["ctime"].asInt64();
+            msg._usec = json.get("usec", 0).asInt64(); // 旧客户端不带微秒
             msg._line = json["line"].asUInt();
             // thread::id 无法从外部值构造，保留字符串形式存于 _file 临时字段或扩展 LogMsg
             // 此处反序列化只用于服务端落地，_tid 字段保留默认值（空 id）即可
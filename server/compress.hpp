@@ -0,0 +1,253 @@
+/// @file compress.hpp
+/// @brief 批量压缩：把一批长度前缀帧压成一个压缩帧，可选用客户端与服务端共享的字典
+///
+/// 压缩帧正文 = u8 0x82 | u32 字典 id（网络序，0 表示不用字典）| u32 原始长度（网络序）| deflate 原始流
+///
+/// 解压后的内容仍是一串长度前缀帧，服务端逐帧交给原有的解码路径。
+/// 日志批量之间高度重复，但单个小批内部可供匹配的历史很少，预置字典把常见的文件名、日志器名、
+/// 正文模板提前放进压缩窗口，小批也能压出接近大批的比例。字典 id 是字典内容的 adler32，
+/// 服务端按 id 查找字典，未配置对应字典的压缩帧被丢弃。
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <arpa/inet.h>
+#include <zlib.h>
+
+namespace Xulog
+{
+    /// @class Compression
+    /// @brief 压缩帧格式与字典
+    class Compression
+    {
+    public:
+        static constexpr uint8_t DEFLATE = 0x82;                   ///< 压缩帧首字节
+        static constexpr size_t HEADER = 1 + 2 * sizeof(uint32_t); ///< 压缩帧头长度
+        static constexpr size_t WINDOW = 32 * 1024;                ///< deflate 窗口，字典超出部分无效
+        static constexpr size_t MAX_RATIO = 1032;                  ///< deflate 的最大压缩比，原始长度超出 正文 × 该值 的帧不可能合法
+        static constexpr size_t MAX_RAW = 1024 * 1024;             ///< 客户端只压缩不超过该长度的批，服务端默认单帧上限不小于它
+
+        /// @brief 帧正文是否为压缩帧
+        static bool isCompressed(const char *data, size_t len)
+        {
+            return len > 0 && static_cast<uint8_t>(data[0]) == DEFLATE;
+        }
+        /// @brief 字典 id，空字典为 0
+        static uint32_t dictionaryId(const std::string &dict)
+        {
+            if (dict.empty())
+                return 0;
+            return adler32(adler32(0L, Z_NULL, 0), reinterpret_cast<const Bytef *>(dict.data()), dict.size());
+        }
+        /// @brief 读取字典文件
+        /// @return 文件不存在或为空时返回空串
+        static std::string loadDictionary(const std::string &path)
+        {
+            std::ifstream in(path, std::ios::binary);
+            std::ostringstream ss;
+            ss << in.rdbuf();
+            std::string dict = ss.str();
+            if (dict.size() > WINDOW)
+                dict.erase(0, dict.size() - WINDOW);
+            return dict;
+        }
+        /// @brief 从样本训练字典
+        ///
+        /// 统计 8 字节片段出现在多少条样本中，每次挑出尚未被字典覆盖的高频片段最多的样本加入字典，
+        /// 最有用的样本放在字典末尾，离被压缩的数据最近。
+        /// @param samples 样本，应为线上实际发送的帧（如 Codec::toBinary 的输出）
+        /// @param max_bytes 字典大小上限，不超过 WINDOW；每批压缩都要重新载入字典，8KB 左右收益与开销较均衡
+        static std::string trainDictionary(const std::vector<std::string> &samples, size_t max_bytes = 8 * 1024)
+        {
+            if (max_bytes > WINDOW)
+                max_bytes = WINDOW;
+            std::vector<std::vector<uint64_t>> shingles(samples.size());
+            std::unordered_map<uint64_t, size_t> freq;
+            for (size_t i = 0; i < samples.size(); i++)
+            {
+                std::unordered_set<uint64_t> seen;
+                for (size_t pos = 0; pos + sizeof(uint64_t) <= samples[i].size(); pos++)
+                {
+                    uint64_t key;
+                    ::memcpy(&key, samples[i].data() + pos, sizeof(key));
+                    if (seen.insert(key).second)
+                    {
+                        shingles[i].push_back(key);
+                        freq[key]++;
+                    }
+                }
+            }
+            std::unordered_set<uint64_t> covered;
+            std::vector<bool> used(samples.size(), false);
+            std::vector<size_t> chosen;
+            size_t total = 0;
+            while (total < max_bytes)
+            {
+                size_t best = samples.size(), best_score = 0;
+                for (size_t i = 0; i < samples.size(); i++)
+                {
+                    if (used[i])
+                        continue;
+                    size_t score = 0;
+                    for (uint64_t key : shingles[i])
+                        if (freq[key] > 1 && covered.count(key) == 0)
+                            score += freq[key] - 1;
+                    if (score > best_score)
+                    {
+                        best = i;
+                        best_score = score;
+                    }
+                }
+                if (best == samples.size())
+                    break;
+                used[best] = true;
+                chosen.push_back(best);
+                covered.insert(shingles[best].begin(), shingles[best].end());
+                total += samples[best].size();
+            }
+            std::string dict;
+            for (auto it = chosen.rbegin(); it != chosen.rend(); ++it)
+                dict += samples[*it];
+            if (dict.size() > max_bytes)
+                dict.erase(0, dict.size() - max_bytes);
+            return dict;
+        }
+    };
+
+    /// @class Deflater
+    /// @brief 压缩器，复用同一个 z_stream，不是线程安全的
+    class Deflater
+    {
+    public:
+        /// @brief 构造函数
+        /// @param level 压缩级别 1~9，1 最快
+        /// @param dict 共享字典，为空时不用字典
+        Deflater(int level, const std::string &dict = std::string())
+            : _dict(dict), _dict_id(Compression::dictionaryId(dict))
+        {
+            ::memset(&_zs, 0, sizeof(_zs));
+            _ok = deflateInit2(&_zs, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+        }
+        ~Deflater()
+        {
+            if (_ok)
+                deflateEnd(&_zs);
+        }
+        Deflater(const Deflater &) = delete;
+        Deflater &operator=(const Deflater &) = delete;
+
+        /// @brief 把 [data, data + len) 压成一个压缩帧正文，追加到 out
+        /// @return 压缩失败返回 false，out 不变
+        bool compress(const char *data, size_t len, std::string *out)
+        {
+            if (!_ok || deflateReset(&_zs) != Z_OK)
+                return false;
+            if (!_dict.empty() &&
+                deflateSetDictionary(&_zs, reinterpret_cast<const Bytef *>(_dict.data()), _dict.size()) != Z_OK)
+                return false;
+            size_t start = out->size();
+            out->resize(start + Compression::HEADER + deflateBound(&_zs, len));
+            char *head = &(*out)[start];
+            head[0] = static_cast<char>(Compression::DEFLATE);
+            uint32_t id = htonl(_dict_id), raw = htonl(static_cast<uint32_t>(len));
+            ::memcpy(head + 1, &id, sizeof(id));
+            ::memcpy(head + 1 + sizeof(id), &raw, sizeof(raw));
+            _zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+            _zs.avail_in = len;
+            _zs.next_out = reinterpret_cast<Bytef *>(head + Compression::HEADER);
+            _zs.avail_out = out->size() - start - Compression::HEADER;
+            if (deflate(&_zs, Z_FINISH) != Z_STREAM_END)
+            {
+                out->resize(start);
+                return false;
+            }
+            out->resize(out->size() - _zs.avail_out);
+            return true;
+        }
+
+    private:
+        z_stream _zs;      ///< 复用的压缩流
+        bool _ok;          ///< 初始化是否成功
+        std::string _dict; ///< 共享字典
+        uint32_t _dict_id; ///< 字典 id
+    };
+
+    /// @class Inflater
+    /// @brief 解压器，复用同一个 z_stream，不是线程安全的
+    class Inflater
+    {
+    public:
+        using Dictionaries = std::unordered_map<uint32_t, std::string>; ///< 字典 id 到字典
+
+        Inflater()
+        {
+            ::memset(&_zs, 0, sizeof(_zs));
+            _ok = inflateInit2(&_zs, -15) == Z_OK;
+        }
+        ~Inflater()
+        {
+            if (_ok)
+                inflateEnd(&_zs);
+        }
+        Inflater(const Inflater &) = delete;
+        Inflater &operator=(const Inflater &) = delete;
+
+        /// @brief 解压一个压缩帧正文
+        /// @param data 压缩帧正文
+        /// @param len 正文长度
+        /// @param dicts 可用的字典
+        /// 帧头中的原始长度来自对端，只用来校验：超过压缩比上限的直接拒绝，输出缓冲随实际解出的数据倍增，
+        /// 声明很大、实际很小的帧占不了内存
+        /// @param max_len 允许的最大原始长度，防止解压炸弹
+        /// @param out 输出，被覆盖
+        /// @return 格式错误、字典未知或长度不符时返回 false
+        bool decompress(const char *data, size_t len, const Dictionaries &dicts, size_t max_len, std::string *out)
+        {
+            if (!_ok || len < Compression::HEADER || !Compression::isCompressed(data, len))
+                return false;
+            uint32_t id, raw;
+            ::memcpy(&id, data + 1, sizeof(id));
+            ::memcpy(&raw, data + 1 + sizeof(id), sizeof(raw));
+            id = ntohl(id);
+            raw = ntohl(raw);
+            if (raw > max_len || raw > (len - Compression::HEADER) * Compression::MAX_RATIO || inflateReset(&_zs) != Z_OK)
+                return false;
+            if (id != 0)
+            {
+                auto it = dicts.find(id);
+                if (it == dicts.end() ||
+                    inflateSetDictionary(&_zs, reinterpret_cast<const Bytef *>(it->second.data()), it->second.size()) != Z_OK)
+                    return false;
+            }
+            out->resize(raw < INITIAL_OUT ? raw : INITIAL_OUT);
+            _zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data + Compression::HEADER));
+            _zs.avail_in = len - Compression::HEADER;
+            size_t produced = 0;
+            while (true)
+            {
+                _zs.next_out = reinterpret_cast<Bytef *>(&(*out)[0] + produced);
+                _zs.avail_out = out->size() - produced;
+                int rc = inflate(&_zs, Z_FINISH);
+                produced = out->size() - _zs.avail_out;
+                // 输出恰好为 raw 且流结束才算完整；raw 为 0 时 next_out 无可写空间，同样要求流结束
+                if (rc == Z_STREAM_END)
+                    return produced == raw;
+                if ((rc != Z_OK && rc != Z_BUF_ERROR) || _zs.avail_out != 0 || out->size() == raw)
+                    return false; // 流损坏、输入已耗尽（截断），或解出的数据多于声明
+                out->resize(std::min<size_t>(raw, out->size() * 2));
+            }
+        }
+
+    private:
+        static constexpr size_t INITIAL_OUT = 64 * 1024; ///< 输出缓冲的初始大小，客户端一批约 64KB
+
+        z_stream _zs; ///< 复用的解压流
+        bool _ok;     ///< 初始化是否成功
+    };
+}
@@ -3,6 +3,7 @@
 #pragma once
 #include "../config/INIReader.h"
 #include "../logs/Xulog.h"
+#include <mutex>
 #include <unordered_map>
 #include <string>
 namespace XuServer
@@ -14,14 +15,14 @@ namespace XuServer
     public:
         /// @brief 构造函数
         /// @param filename 配置文件路径
-        Config(const std::string &filename)
+        Config(const std::string &filename) : _filename(filename)
         {
             INIReader reader(filename);
             if (reader.ParseError() < 0)
             {
                 ERROR("配置解析失败！");
             }
-            init(reader);
+            init(reader, _config_data);
         }
         using ptr = std::shared_ptr<Config>;                                                              ///< 配置管理句柄
         using config_map = std::unordered_map<std::string, std::unordered_map<std::string, std::string>>; ///< 从section和name获取value的映射表
@@ -49,6 +50,7 @@ namespace XuServer
         /// @return 字段值
         std::string get(const std::string &section, const std::string &name)
         {
+            std::unique_lock<std::mutex> lock(_mutex);
             auto sec_it = _config_data.find(section);
             if (sec_it != _config_data.end())
             {
@@ -60,50 +62,110 @@ namespace XuServer
             }
             return "";
         }
+        /// @brief 重新读取配置文件，解析失败时保留原有配置
+        /// @return 是否成功
+        bool reload()
+        {
+            INIReader reader(_filename);
+            if (reader.ParseError() < 0)
+            {
+                ERROR("配置解析失败，保留原有配置！");
+                return false;
+            }
+            config_map data;
+            init(reader, data);
+            std::unique_lock<std::mutex> lock(_mutex);
+            _config_data.swap(data);
+            return true;
+        }
 
     private:
         /// @brief 读取配置文件并写入到映射表中
         /// @param reader ini读取器
-        void init(INIReader &reader)
+        /// @param config_data 写入的映射表
+        static void init(INIReader &reader, config_map &config_data)
         {
             std::string ret = reader.Get("Server", "port", "8888");
-            _config_data["Server"]["port"] = ret;
+            config_data["Server"]["port"] = ret;
+            ret = reader.Get("Server", "udp_port", "");
+            if (!ret.empty())
+            {
+                config_data["Server"]["udp_port"] = ret;
+            }
+            ret = reader.Get("Server", "workers", "");
+            if (!ret.empty())
+            {
+                config_data["Server"]["workers"] = ret;
+            }
+            ret = reader.Get("Server", "max_frame", "");
+            if (!ret.empty())
+            {
+                config_data["Server"]["max_frame"] = ret;
+            }
+            ret = reader.Get("Server", "ack_frames", "");
+            if (!ret.empty())
+            {
+                config_data["Server"]["ack_frames"] = ret;
+            }
+            ret = reader.Get("Server", "ack_ms", "");
+            if (!ret.empty())
+            {
+                config_data["Server"]["ack_ms"] = ret;
+            }
+            ret = reader.Get("Server", "dictionary", "");
+            if (!ret.empty())
+            {
+                config_data["Server"]["dictionary"] = ret;
+            }
             ret = reader.Get("StdoutSink", "color", "");
             if (!ret.empty())
             {
-                _config_data["StdoutSink"]["color"] = ret;
+                config_data["StdoutSink"]["color"] = ret;
             }
 
             ret = reader.Get("FileSink", "path", "");
             if (!ret.empty())
             {
-                _config_data["FileSink"]["path"] = ret;
+                config_data["FileSink"]["path"] = ret;
             }
 
             ret = reader.Get("RollBySize", "path", "");
             if (!ret.empty())
             {
                 std::string r = reader.Get("RollBySize", "size", "1024");
-                _config_data["RollBySize"]["path"] = ret;
-                _config_data["RollBySize"]["size"] = r;
+                config_data["RollBySize"]["path"] = ret;
+                config_data["RollBySize"]["size"] = r;
             }
 
             ret = reader.Get("RollByTime", "path", "");
             if (!ret.empty())
             {
                 std::string r = reader.Get("RollByTime", "type", "GAP_SECOND");
-                _config_data["RollByTime"]["path"] = ret;
-                _config_data["RollByTime"]["type"] = r;
+                config_data["RollByTime"]["path"] = ret;
+                config_data["RollByTime"]["type"] = r;
             }
 
             ret = reader.Get("DataBaseSink", "path", "");
             if (!ret.empty())
             {
-                _config_data["DataBaseSink"]["path"] = ret;
+                config_data["DataBaseSink"]["path"] = ret;
+                // 存储参数与组提交参数，缺省时由 DataBaseSink 使用内置默认值
+                static const char *DB_KEYS[] = {"journal_mode", "synchronous", "page_size", "cache_size",
+                                                "mmap_size", "wal_autocheckpoint", "journal_size_limit",
+                                                "batch_rows", "batch_ms", "full_text", "partition", "max_partitions",
+                                                "queue_rows"};
+                for (auto key : DB_KEYS)
+                {
+                    std::string r = reader.Get("DataBaseSink", key, "");
+                    if (!r.empty())
+                        config_data["DataBaseSink"][key] = r;
+                }
             }
         }
 
     private:
+        std::string _filename;   ///< 配置文件路径，重新加载时使用
+        std::mutex _mutex;       ///< 保护映射表，重新加载与读取可能并发
         config_map _config_data; ///< 从section和name获取value的映射表
         static ptr _instance;    ///< 配置文件操作句柄
     };
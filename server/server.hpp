@@ -1,32 +1,201 @@
 /// @file server.hpp
 /// @brief TCP服务器
+///
+/// 边沿触发的 epoll reactor：一个或多个事件循环线程负责 accept 和分发就绪事件，
+/// 连接可读时交给工作线程池，由工作线程把数据直接读进该连接的读缓冲并调用回调处理。
+/// 同一连接同一时刻至多一个工作线程在处理，保证按到达顺序处理；连接之间互不阻塞。
+///
+/// 分片模式（reuse_port）：每个事件循环各自用 SO_REUSEPORT 监听同一端口，由内核把新连接分给各个循环，
+/// 不再经过 0 号循环 accept；工作线程数为 0 时连接直接在所属循环线程上读取和处理，
+/// 各分片之间不共享监听队列、连接表与线程，多核机器上接收能力可随分片数扩展。
 #pragma once
 #include "Socket.hpp"
+#include "buffer.hpp"
 #include "threadpool.hpp"
 #include "nocopy.hpp"
 #include <iostream>
+#include <algorithm>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 
 namespace XuServer
 {
     /// @brief 服务器回调函数
-    using CallBack = std::function<std::string(std::vector<char> &, bool *error_code)>;
+    /// @details 参数为连接的读缓冲，回调用 retrieve() 取走已处理的部分，剩余字节留待下次数据到达时一起处理；
+    /// 返回值非空时发回客户端，error_code 置为 false 时关闭连接
+    using CallBack = std::function<std::string(Buffer &, bool *error_code)>;
+    /// @brief 带连接上下文的服务器回调
+    /// @details 与 CallBack 相同，另外传入该连接的上下文，回调可在其中保存跨多次读取的连接级状态（如会话），
+    /// 连接关闭时随连接释放
+    using ContextCallBack = std::function<std::string(Buffer &, bool *error_code, std::shared_ptr<void> *context)>;
 
-    class TcpServer;
-    /// @class ThreadData
-    /// @brief 线程信息
-    class ThreadData
+    /// @class Connection
+    /// @brief 一个客户端连接：非阻塞 socket 及其读写缓冲
+    class Connection : public nocopy
     {
     public:
+        using ptr = std::shared_ptr<Connection>; ///< 连接句柄
+
         /// @brief 构造函数
-        /// @param tcp_this  服务器指针
-        /// @param sockp socket指针
-        ThreadData(TcpServer *tcp_this, TcpSocket *sockp)
-            : _this(tcp_this), _sockp(sockp) {}
+        /// @param fd 已设为非阻塞的连接描述符
+        explicit Connection(int fd) : _fd(fd) {}
+
+    public:
+        Buffer _in;                     ///< 读缓冲，只由持有 _busy 的工作线程访问
+        std::shared_ptr<void> _context; ///< 回调保存的连接级状态，只由持有 _busy 的工作线程访问
+        std::mutex _mutex;              ///< 保护以下全部字段
+        int _fd;                        ///< 连接描述符，关闭后为 DEFAULT_SOCKFD
+        std::string _out;               ///< 未能立即发出的回复，等可写事件再发
+        bool _busy = false;             ///< 是否已有工作线程在处理该连接
+        bool _pending = false;          ///< 工作线程处理期间又有事件到达，处理完需再读一轮
+        bool _eof = false;              ///< 对端已关闭或出错，处理完已读到的数据后关闭
+    };
 
+    /// @class EventLoop
+    /// @brief 一个 epoll 事件循环及其管理的连接
+    class EventLoop : public nocopy
+    {
     public:
-        TcpServer *_this;  ///< 服务器指针
-        TcpSocket *_sockp; ///< socket指针
+        /// @brief 构造函数
+        EventLoop()
+            : _epfd(::epoll_create1(EPOLL_CLOEXEC)), _wakefd(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+        {
+            if (_epfd < 0 || _wakefd < 0)
+                throw std::runtime_error("epoll 创建失败: " + std::string(strerror(errno)));
+            watch(_wakefd, EPOLLIN);
+        }
+        ~EventLoop()
+        {
+            ::close(_wakefd);
+            ::close(_epfd);
+        }
+        /// @brief 监听描述符上的事件
+        void watch(int fd, uint32_t events)
+        {
+            struct epoll_event ev;
+            memset(&ev, 0, sizeof(ev));
+            ev.events = events;
+            ev.data.fd = fd;
+            ::epoll_ctl(_epfd, EPOLL_CTL_ADD, fd, &ev);
+        }
+        /// @brief 接管一个新连接
+        void attach(const Connection::ptr &conn)
+        {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _conns[conn->_fd] = conn;
+            }
+            // 读写一次注册：边沿触发下可写事件只在发送缓冲由满转为可写时到达
+            watch(conn->_fd, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET);
+        }
+        /// @brief 移除连接，调用方持有连接锁并负责关闭描述符
+        void detach(int fd, const Connection *conn)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            auto it = _conns.find(fd);
+            if (it != _conns.end() && it->second.get() == conn)
+                _conns.erase(it);
+            ::epoll_ctl(_epfd, EPOLL_CTL_DEL, fd, nullptr);
+        }
+        /// @brief 查找描述符对应的连接
+        Connection::ptr find(int fd)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            auto it = _conns.find(fd);
+            return it == _conns.end() ? nullptr : it->second;
+        }
+        /// @brief 当前管理的连接数
+        size_t size()
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            return _conns.size();
+        }
+        /// @brief 取出全部连接，停止时用于关闭
+        std::vector<Connection::ptr> drain()
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            std::vector<Connection::ptr> conns;
+            for (auto &kv : _conns)
+                conns.push_back(kv.second);
+            _conns.clear();
+            return conns;
+        }
+        /// @brief 连接读满一轮预算后仍有数据：边沿触发不会再通知，登记下来在本批事件之后当作可读再派发一次，
+        /// 可在任意线程调用
+        void defer(const Connection::ptr &conn, int fd)
+        {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _deferred.emplace_back(fd, conn);
+            }
+            uint64_t one = 1;
+            ssize_t n = ::write(_wakefd, &one, sizeof(one));
+            (void)n;
+        }
+        /// @brief 运行事件循环直到 stop()
+        /// @param handler 就绪事件处理函数 handler(fd, events)
+        void run(const std::function<void(int, uint32_t)> &handler)
+        {
+            struct epoll_event events[MAX_EVENTS];
+            while (!_stop)
+            {
+                int timeout = -1;
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    if (!_deferred.empty())
+                        timeout = 0; // 有待续读的连接时不阻塞，先收一遍其他连接的事件
+                }
+                int n = ::epoll_wait(_epfd, events, MAX_EVENTS, timeout);
+                if (n < 0 && errno != EINTR)
+                    break;
+                for (int i = 0; i < n; i++)
+                {
+                    if (events[i].data.fd == _wakefd)
+                    {
+                        uint64_t v;
+                        while (::read(_wakefd, &v, sizeof(v)) > 0)
+                            ;
+                        continue;
+                    }
+                    handler(events[i].data.fd, events[i].events);
+                }
+                std::vector<std::pair<int, Connection::ptr>> deferred;
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    deferred.swap(_deferred);
+                }
+                for (auto &d : deferred)
+                    if (find(d.first) == d.second) // 期间已关闭（描述符可能已被新连接复用）的不再派发
+                        handler(d.first, EPOLLIN);
+            }
+        }
+        /// @brief 让 run() 返回，可在任意线程调用
+        void stop()
+        {
+            _stop = true;
+            uint64_t one = 1;
+            ssize_t n = ::write(_wakefd, &one, sizeof(one));
+            (void)n;
+        }
+
+    private:
+        static constexpr int MAX_EVENTS = 256; ///< 每次 epoll_wait 取回的最大事件数
+
+        int _epfd;                                         ///< epoll 描述符
+        int _wakefd;                                       ///< 唤醒 epoll_wait 的 eventfd
+        std::atomic<bool> _stop{false};                    ///< 停止标志
+        std::mutex _mutex;                                      ///< 保护连接表和待续读列表
+        std::unordered_map<int, Connection::ptr> _conns;        ///< 描述符到连接的映射
+        std::vector<std::pair<int, Connection::ptr>> _deferred; ///< 读满预算、等下一轮续读的连接
     };
 
     /// @class TcpServer
@@ -35,63 +204,265 @@ namespace XuServer
     {
     public:
         /// @brief 构造函数
-        /// @param port 监听端口号
+        /// @param port 监听端口号，0 表示由系统分配
         /// @param call_back 处理获取数据的回调函数
-        /// @param thread_count 线程数量
-        TcpServer(uint16_t port, CallBack call_back, int thread_count = 5)
-            : _port(port), _listen_socket(new TcpSocket()),
-              _call_back(call_back), _thread_pool(std::make_unique<threadpool>(thread_count))
+        /// @param thread_count 工作线程数量，0 表示在事件循环线程上直接处理
+        /// @param loop_count 事件循环线程数量，新连接轮流分给各个循环
+        /// @param reuse_port 分片模式：每个循环各自监听同一端口，新连接由内核分配
+        TcpServer(uint16_t port, CallBack call_back, int thread_count = 5, int loop_count = 1, bool reuse_port = false)
+            : TcpServer(port, ContextCallBack([call_back](Buffer &in, bool *error_code, std::shared_ptr<void> *)
+                                              { return call_back(in, error_code); }),
+                        thread_count, loop_count, reuse_port)
+        {
+        }
+        /// @brief 构造函数
+        /// @param port 监听端口号，0 表示由系统分配
+        /// @param call_back 处理获取数据的回调函数，可使用连接上下文
+        /// @param thread_count 工作线程数量，0 表示在事件循环线程上直接处理
+        /// @param loop_count 事件循环线程数量，新连接轮流分给各个循环
+        /// @param reuse_port 分片模式：每个循环各自监听同一端口，新连接由内核分配
+        TcpServer(uint16_t port, ContextCallBack call_back, int thread_count = 5, int loop_count = 1, bool reuse_port = false)
+            : _port(port), _call_back(call_back)
+        {
+            if (thread_count > 0)
+                _thread_pool = std::make_unique<threadpool>(thread_count);
+            for (int i = 0; i < std::max(1, loop_count); i++)
+            {
+                _loops.emplace_back(new EventLoop());
+                if (i > 0 && !reuse_port)
+                    continue;
+                // 大量客户端同时重连时 accept 队列不至于溢出（溢出的 SYN 要等 1 秒重传）
+                // 端口为 0 时第一个分片取得系统分配的端口，其余分片绑定同一端口
+                std::unique_ptr<TcpSocket> listener(new TcpSocket());
+                listener->BuildListenSocketMethod(_port, SOMAXCONN, reuse_port);
+                listener->SetNonBlock();
+                _port = listener->GetLocalPort();
+                _loops[i]->watch(listener->GetSockFd(), EPOLLIN | EPOLLET);
+                _listeners.push_back(std::move(listener));
+            }
+        }
+        ~TcpServer()
+        {
+            Stop();
+            if (_thread_pool)
+                _thread_pool->stop();
+            for (auto &loop : _loops)
+                for (auto &conn : loop->drain())
+                {
+                    std::unique_lock<std::mutex> lock(conn->_mutex);
+                    if (conn->_fd != DEFAULT_SOCKFD)
+                        ::close(conn->_fd);
+                    conn->_fd = DEFAULT_SOCKFD;
+                }
+            for (auto &listener : _listeners)
+                listener->CloseSockFd();
+        }
+        /// @brief 启动事件循环，阻塞到 Stop() 被调用
+        void Loop()
+        {
+            std::vector<std::thread> threads;
+            for (size_t i = 1; i < _loops.size(); i++)
+                threads.emplace_back([this, i]()
+                                     { runLoop(i); });
+            runLoop(0);
+            for (auto &t : threads)
+                t.join();
+        }
+        /// @brief 停止全部事件循环，可在任意线程调用
+        void Stop()
+        {
+            for (auto &loop : _loops)
+                loop->stop();
+        }
+        /// @brief 实际监听的端口号
+        uint16_t Port() const { return _port; }
+        /// @brief 当前保持的连接数
+        size_t ConnectionCount()
         {
-            _listen_socket->BuildListenSocketMethod(port);
+            size_t n = 0;
+            for (auto &loop : _loops)
+                n += loop->size();
+            return n;
         }
-        /// @brief 启动线程
-        static void *ThreadRun(void *args)
+
+    private:
+        static constexpr size_t MAX_IDLE_BUFFER = 1024 * 1024; ///< 空闲连接保留的读缓冲上限
+        static constexpr size_t READ_BUDGET = 512 * 1024;      ///< 每轮最多读取的字节数，读满后让出线程
+
+        void runLoop(size_t i)
+        {
+            EventLoop *loop = _loops[i].get();
+            loop->run([this, loop, i](int fd, uint32_t events)
+                      {
+                          if (i < _listeners.size() && fd == _listeners[i]->GetSockFd())
+                          {
+                              acceptAll(i);
+                              return;
+                          }
+                          Connection::ptr conn = loop->find(fd);
+                          if (conn == nullptr)
+                              return;
+                          if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+                              onReadable(loop, conn);
+                          if (events & EPOLLOUT)
+                              onWritable(loop, conn); });
+        }
+        /// @brief 边沿触发：一次取完所有等待中的连接；分片模式下连接留在接受它的循环
+        void acceptAll(size_t i)
         {
-            std::vector<char> in_buf_stream(1024 * 10 + sizeof(uint32_t));
-            ThreadData *td = static_cast<ThreadData *>(args);
             while (true)
             {
-                bool ok = true;
-                if (!td->_sockp->Recv(&in_buf_stream))
-                    break;
+                int fd = ::accept4(_listeners[i]->GetSockFd(), nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fd < 0)
+                {
+                    if (errno == EINTR || errno == ECONNABORTED)
+                        continue;
+                    return; // EAGAIN，或描述符耗尽时等下一次可读
+                }
+                if (_listeners.size() > 1)
+                    _loops[i]->attach(std::make_shared<Connection>(fd));
+                else
+                    _loops[_next_loop++ % _loops.size()]->attach(std::make_shared<Connection>(fd));
+            }
+        }
+        /// @brief 可读：交给工作线程读取；已有工作线程在处理时只做标记，由它读完后再读一轮
+        void onReadable(EventLoop *loop, const Connection::ptr &conn)
+        {
+            std::unique_lock<std::mutex> lock(conn->_mutex);
+            schedule(loop, conn, lock);
+        }
+        /// @brief 发送缓冲恢复可写时发出积压的回复
+        void onWritable(EventLoop *loop, const Connection::ptr &conn)
+        {
+            std::unique_lock<std::mutex> lock(conn->_mutex);
+            if (conn->_fd == DEFAULT_SOCKFD || conn->_out.empty() || flushLocked(conn.get()))
+                return;
+            conn->_eof = true; // 关闭交给工作线程，保证只有持有连接的线程关闭描述符
+            schedule(loop, conn, lock);
+        }
+        /// @brief 保证连接上有且只有一个工作线程在处理；调用方持有连接锁
+        void schedule(EventLoop *loop, const Connection::ptr &conn, std::unique_lock<std::mutex> &lock)
+        {
+            if (conn->_fd == DEFAULT_SOCKFD)
+                return;
+            if (conn->_busy)
+            {
+                conn->_pending = true;
+                return;
+            }
+            conn->_busy = true;
+            lock.unlock();
+            if (!_thread_pool)
+                return process(loop, conn); // 连接只属于当前循环，在循环线程上处理不会与其他线程竞争
+            _thread_pool->push([this, loop, conn]()
+                               { process(loop, conn); });
+        }
+        /// @brief 工作线程：边沿触发下读到 EAGAIN 为止，数据直接读进连接缓冲交给回调，
+        /// 回调在原地取走完整的部分，剩余字节留在缓冲中与下一轮读到的数据拼接；
+        /// 每轮最多读 READ_BUDGET 字节，读满时处理完这一段就交回事件循环排到其他连接之后续读，
+        /// 发得快的客户端既撑不大读缓冲，也不会独占循环线程（内联模式）或工作线程
+        void process(EventLoop *loop, const Connection::ptr &conn)
+        {
+            std::unique_lock<std::mutex> lock(conn->_mutex);
+            while (conn->_fd != DEFAULT_SOCKFD)
+            {
+                int fd = conn->_fd;
+                bool eof = conn->_eof;
+                conn->_pending = false;
+                lock.unlock();
 
-                std::string send_string = td->_this->_call_back(in_buf_stream, &ok);
-                if (ok)
-                    if (!send_string.empty())
+                // 描述符只由持有 _busy 的工作线程关闭，读取时无需加锁
+                size_t budget = READ_BUDGET;
+                bool more = false;
+                while (!eof)
+                {
+                    if (budget == 0)
                     {
-                        std::vector<char> sd(send_string.begin(), send_string.end());
-                        td->_sockp->Send(sd);
-                    }
-                    else
+                        more = true;
                         break;
+                    }
+                    int err = 0;
+                    ssize_t n = conn->_in.readFd(fd, &err);
+                    if (n > 0)
+                    {
+                        budget -= std::min(budget, (size_t)n);
+                        continue;
+                    }
+                    if (n < 0 && err == EINTR)
+                        continue;
+                    eof = n == 0 || (err != EAGAIN && err != EWOULDBLOCK);
+                    break;
+                }
+                bool ok = true;
+                std::string reply;
+                if (conn->_in.readable() > 0)
+                    reply = _call_back(conn->_in, &ok, &conn->_context);
+                if (conn->_in.readable() == 0 && conn->_in.capacity() > MAX_IDLE_BUFFER)
+                    conn->_in = Buffer(); // 大帧处理完后归还内存
+
+                lock.lock();
+                if (eof)
+                    conn->_eof = true;
+                if (ok && !reply.empty())
+                {
+                    conn->_out += reply;
+                    ok = flushLocked(conn.get());
+                }
+                if (!ok || conn->_eof)
+                {
+                    closeLocked(loop, conn.get());
+                    break;
+                }
+                if (more)
+                {
+                    conn->_busy = false;
+                    lock.unlock();
+                    loop->defer(conn, fd);
+                    return;
+                }
+                if (!conn->_pending)
+                    break;
             }
-            td->_sockp->CloseSockFd();
-            delete td->_sockp;
-            delete td;
-            return nullptr;
+            conn->_busy = false;
         }
-        /// @brief 启动监听
-        void Loop()
+        /// @brief 尽量发出写缓冲，出错返回 false；调用方持有连接锁
+        bool flushLocked(Connection *conn)
         {
-            while (true)
+            size_t sent = 0;
+            while (sent < conn->_out.size())
             {
-                std::string peer_ip;
-                uint16_t peer_port;
-                TcpSocket *newsock = _listen_socket->AcceptConnection(&peer_ip, &peer_port);
-                if (newsock == nullptr)
+                ssize_t n = ::send(conn->_fd, conn->_out.data() + sent, conn->_out.size() - sent, MSG_NOSIGNAL);
+                if (n > 0)
+                    sent += n;
+                else if (n < 0 && errno == EINTR)
                     continue;
-                // std::cout << "get a new connection,sockfd:" << newsock->GetSockFd() << "client info:" << peer_ip << ":" << peer_port << std::endl;
-                ThreadData *td = new ThreadData(this, newsock);
-                _thread_pool->push(ThreadRun, td);
+                else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                    break;
+                else
+                    return false;
             }
+            conn->_out.erase(0, sent);
+            return true;
+        }
+        /// @brief 关闭连接；调用方持有连接锁
+        void closeLocked(EventLoop *loop, Connection *conn)
+        {
+            if (conn->_fd == DEFAULT_SOCKFD)
+                return;
+            loop->detach(conn->_fd, conn);
+            ::close(conn->_fd);
+            conn->_fd = DEFAULT_SOCKFD;
+            conn->_out.clear();
         }
 
     private:
-        int _port;                                ///< 端口号
-        TcpSocket *_listen_socket;                ///< 监听socket
-        std::unique_ptr<threadpool> _thread_pool; ///< 线程池
+        uint16_t _port;                                     ///< 端口号
+        std::vector<std::unique_ptr<TcpSocket>> _listeners; ///< 监听socket，分片模式下每个循环一个，否则只有 0 号循环一个
+        std::vector<std::unique_ptr<EventLoop>> _loops;     ///< 事件循环，持有监听socket的循环同时负责 accept
+        std::atomic<size_t> _next_loop{0};                  ///< 非分片模式下轮流分配新连接
+        std::unique_ptr<threadpool> _thread_pool;           ///< 线程池，为空时在循环线程上直接处理
 
     public:
-        CallBack _call_back; ///< 回调函数
+        ContextCallBack _call_back; ///< 回调函数
     };
-}
\ No newline at end of file
+}
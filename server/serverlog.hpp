@@ -3,16 +3,29 @@
 #pragma once
 #include "../extend/DataBaseSink.hpp"
 #include "codec.hpp"
+#include "compress.hpp"
 #include "server.hpp"
+#include "session.hpp"
+#include "shardwriter.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
 namespace XuServer
 {
     /// @class ServerLog
     /// @brief 服务器实际执行落地的类
+    ///
+    /// 落地对象在启动时按配置构造一次，之后每条消息只做写入；
+    /// 配置变化时 reload() 构造一组新的落地并原子替换，
+    /// 正在写入的消息仍持有旧的一组，写完后旧落地随最后一个引用释放（析构时提交剩余数据）。
+    ///
+    /// 配置 [Server] workers 大于 1 时服务器分片接收，解码与格式化在各分片线程上并行完成；
+    /// 线程安全的落地由分片线程直接写入，文件与数据库落地经各分片的无锁队列交给该组落地唯一的写线程。
     class ServerLog
     {
     public:
         using ptr = std::shared_ptr<ServerLog>; ///< 服务器实际落地操作句柄
-        
+
         /// @brief 获取服务器落地操作句柄
         /// @return 服务器落地操作句柄
         static ptr getInstance()
@@ -33,77 +46,220 @@ namespace XuServer
                 _builder->buildLoggerType();
                 _builder->build();
             }
+            _formatter = Xulog::getLogger("server")->getFormatter();
+            std::atomic_store(&_sinks, build());
         }
         /// @brief 仿函数
-        /// @param msg JsonData字符串
-        void operator()(std::string &msg)
-        {
-            _logger = Xulog::getLogger("server");
-            // std::cout << _sinks.size() << std::endl;
-            Json::CharReaderBuilder reader;
-            Json::Value root;
-            std::istringstream(msg) >> root;
-            Xulog::DeliverMsg dmsg = Xulog::Codec::fromJson(root);
-            std::string str;
+        /// @param data 帧起始地址，直接指向连接读缓冲；首字节区分二进制、Json 与压缩帧
+        /// @param len 帧长度
+        void operator()(const char *data, size_t len)
+        {
+            std::shared_ptr<const SinkSet> set = std::atomic_load(&_sinks);
+            deliver(*set, data, len, 0);
+        }
+        /// @brief 重新读取配置文件，构造新的落地并原子替换当前落地
+        /// @return 配置是否读取成功，失败时沿用原有落地
+        bool reload()
+        {
+            if (!Config::getInstance()->reload())
+                return false;
+            std::atomic_store(&_sinks, build());
+            return true;
+        }
+        /// @brief 当前落地数量
+        size_t sinkCount() const
+        {
+            std::shared_ptr<const SinkSet> set = std::atomic_load(&_sinks);
+            return set->sinks.size() + set->dbs.size();
+        }
+        /// @brief 服务器收到消息的处理回调函数
+        /// @param msg 连接读缓冲，取走其中的完整帧，跨读取边界的半帧留给下一次
+        /// @param error_code 错误码，遇到超长帧时置为 false 关闭连接
+        /// @return 需要返回给客户端的信息
+        static std::string logMsg(Buffer &msg, bool *error_code)
+        {
+            XuServer::ServerLog::ptr log = XuServer::ServerLog::getInstance();
+            *error_code = FrameDecoder::decode(msg, [&log](const char *data, size_t len)
+                                               { (*log)(data, len); },
+                                               log->maxFrame());
+            return std::string();
+        }
+        /// @brief 服务器收到消息的处理回调函数（带会话）：按会话序号去重，按 [Server] ack_frames / ack_ms 攒够后
+        /// 提交一次落地并回复累计确认，不是每次读到数据都提交
+        /// @param msg 连接读缓冲
+        /// @param error_code 错误码，遇到超长帧时置为 false 关闭连接
+        /// @param context 连接上下文，保存连接所属的会话
+        /// @return 累计确认帧，旧客户端或暂不确认时为空
+        static std::string logSession(Buffer &msg, bool *error_code, std::shared_ptr<void> *context)
+        {
+            XuServer::ServerLog::ptr log = XuServer::ServerLog::getInstance();
+            std::shared_ptr<const SinkSet> set = std::atomic_load(&log->_sinks);
+            return log->_session_table.decode(
+                msg, error_code, context, [&log](const char *data, size_t len)
+                { (*log)(data, len); },
+                [&log]()
+                { log->commit(); },
+                set->max_frame, set->ack);
+        }
+        /// @brief 当前配置的单帧上限
+        uint32_t maxFrame() const
+        {
+            return std::atomic_load(&_sinks)->max_frame;
+        }
+        /// @brief 让数据库落地提交已接收的日志，回复确认之前调用
+        void commit()
+        {
+            std::shared_ptr<const SinkSet> set = std::atomic_load(&_sinks);
+            if (set->writer)
+                set->writer->sync();
+            for (auto &db : set->dbs)
+                db->flush();
+        }
+
+    private:
+        /// @brief 一组落地：文本落地写格式化后的字符串，数据库落地写结构化消息；压缩字典随落地一起重新加载
+        struct SinkSet
+        {
+            std::vector<Xulog::LogSink::ptr> sinks;       ///< 文本落地
+            std::vector<DataBaseSink::DBptr> dbs;         ///< 数据库落地
+            Xulog::Inflater::Dictionaries dictionaries;   ///< 压缩帧可用的字典
+            uint32_t max_frame = FrameDecoder::MAX_FRAME; ///< 单帧上限
+            AckPolicy ack;                                ///< 确认策略
+            std::unique_ptr<ShardWriter> writer;          ///< 分片模式下的写线程，为空时在调用线程直接写；最后声明，先于落地析构并写完队列
+        };
+        /// @brief 按帧首字节解码并落地
+        /// @param depth 压缩帧嵌套层数：客户端补发暂存时压缩帧可能再被压缩一次，更深的嵌套视为非法
+        void deliver(const SinkSet &set, const char *data, size_t len, int depth)
+        {
+            if (Xulog::Compression::isCompressed(data, len))
+            {
+                thread_local Xulog::Inflater inflater;
+                std::string batch;
+                if (depth > 1 || !inflater.decompress(data, len, set.dictionaries, set.max_frame, &batch))
+                    return;
+                FrameDecoder::decode(batch.data(), batch.size(), [&](const char *frame, size_t n)
+                                     { deliver(set, frame, n, depth + 1); });
+                return;
+            }
+            if (Xulog::Codec::isBinary(data, len))
+            {
+                Xulog::WireMsg wire;
+                if (!Xulog::Codec::parseBinary(data, len, &wire))
+                    return;
+                // 非结构化消息直接从读缓冲写出，不经过任何中间对象
+                if (!wire.formatted)
+                    return write(set, wire.payload.data, wire.payload.len);
+                Xulog::LogMsg msg = Xulog::Codec::msgFromWire(wire);
+                return write(set, msg);
+            }
+            Xulog::DeliverMsg dmsg;
+            if (!Xulog::Codec::fromFrame(data, len, &dmsg))
+                return;
             if (dmsg.msg_mod == "format")
+                write(set, dmsg.format_msg);
+            else
+                write(set, dmsg.unformatted_msg.data(), dmsg.unformatted_msg.size());
+        }
+        /// @brief 结构化消息：格式化后写文本落地，原样写数据库落地
+        void write(const SinkSet &set, Xulog::LogMsg &msg)
+        {
+            std::string str = _formatter->Format(msg);
+            if (set.writer)
             {
-                if (_logger == nullptr)
-                    std::cout << "_logger 空指针！！" << std::endl;
-                else
+                writeThreadSafe(set, str.data(), str.size());
+                ShardRecord record;
+                record.text.swap(str);
+                record.msg = std::move(msg);
+                record.structured = true;
+                return set.writer->push(std::move(record));
+            }
+            write(set, str.data(), str.size());
+            for (auto &db : set.dbs)
+                db->log(msg);
+        }
+        /// @brief 文本写入文本落地；非结构化消息没有时间、等级等字段，不写数据库
+        void write(const SinkSet &set, const char *data, size_t len)
+        {
+            if (set.writer)
+            {
+                writeThreadSafe(set, data, len);
+                ShardRecord record;
+                record.text.assign(data, len);
+                return set.writer->push(std::move(record));
+            }
+            for (auto &sink : set.sinks)
+            {
+                if (sink->threadSafe())
                 {
-                    if (_logger->getFormatter() == nullptr)
-                        std::cout << "getFormatter 空指针！！" << std::endl;
-                    else
-                        str = _logger->getFormatter()->Format(dmsg.format_msg);
+                    sink->log(data, len);
+                    continue;
                 }
+                std::unique_lock<std::mutex> lock(sink->mutex());
+                sink->log(data, len);
             }
-            else
-                str = dmsg.unformatted_msg;
-            std::vector<Xulog::LogSink::ptr> _sinks;
-            init(_sinks);
-            for (auto sink : _sinks)
+        }
+        /// @brief 分片模式：线程安全的文本落地由分片线程直接写入
+        static void writeThreadSafe(const SinkSet &set, const char *data, size_t len)
+        {
+            for (auto &sink : set.sinks)
+                if (sink->threadSafe())
+                    sink->log(data, len);
+        }
+        /// @brief 分片模式的写线程：其余文本落地与数据库落地只由写线程访问，无需加锁
+        static void writeBatch(const SinkSet &set, std::vector<ShardRecord> &batch)
+        {
+            for (auto &record : batch)
+            {
+                for (auto &sink : set.sinks)
+                    if (!sink->threadSafe())
+                        sink->log(record.text.data(), record.text.size());
+                if (!record.structured)
+                    continue;
+                for (auto &db : set.dbs)
+                    db->log(record.msg);
+            }
+        }
+        /// @brief 按当前配置构造一组落地
+        std::shared_ptr<const SinkSet> build()
+        {
+            std::shared_ptr<SinkSet> set = std::make_shared<SinkSet>();
+            std::vector<Xulog::LogSink::ptr> sinks;
+            init(sinks);
+            for (auto &sink : sinks)
             {
                 DataBaseSink::DBptr dbptr = std::dynamic_pointer_cast<DataBaseSink>(sink);
                 if (dbptr == nullptr)
-                    sink->log(str.c_str(), str.size());
+                    set->sinks.push_back(sink);
                 else
-                    dbptr->log(dmsg.format_msg);
+                    set->dbs.push_back(dbptr);
             }
-        }
-        /// @brief 服务器收到消息的处理回调函数
-        /// @param msg 服务器接收的信息
-        /// @param error_code 错误码
-        /// @return 需要返回给客户端的信息
-        static std::string logMsg(std::vector<char> &msg, bool *error_code)
-        {
-            XuServer::ServerLog::ptr log = XuServer::ServerLog::getInstance();
-            size_t offset = 0;
-            while (offset < msg.size())
+            // 多个字典以逗号分隔，更换字典期间新旧客户端可以同时接入
+            std::stringstream paths(Config::getInstance()->get("Server", "dictionary"));
+            std::string path;
+            while (std::getline(paths, path, ','))
             {
-
-                if (msg.size() < sizeof(uint32_t))
-                {
-                    break; // 检查消息大小
-                }
-
-                uint32_t sz_net;
-                ::memcpy(&sz_net, msg.data() + offset, sizeof(uint32_t)); // 从正确的位置复制
-                uint32_t sz = ntohl(sz_net);
-
-                if (offset + sizeof(uint32_t) + sz > msg.size())
-                {
-                    break;
-                }
-
-                std::string jsonData(msg.begin() + offset + sizeof(uint32_t), msg.begin() + offset + sizeof(uint32_t) + sz);
-                (*log)(jsonData);
-                offset += (sizeof(uint32_t) + sz);
+                std::string dict = Xulog::Compression::loadDictionary(path);
+                if (!dict.empty())
+                    set->dictionaries[Xulog::Compression::dictionaryId(dict)] = dict;
             }
-            msg.clear();
-            return std::string();
+            long max_frame = std::atol(Config::getInstance()->get("Server", "max_frame").c_str());
+            if (max_frame > 0)
+                set->max_frame = (uint32_t)std::min<long>(max_frame, UINT32_MAX);
+            std::string ack_frames = Config::getInstance()->get("Server", "ack_frames");
+            if (!ack_frames.empty())
+                set->ack.frames = std::max(1L, std::atol(ack_frames.c_str()));
+            std::string ack_ms = Config::getInstance()->get("Server", "ack_ms");
+            if (!ack_ms.empty())
+                set->ack.ms = std::max(0L, std::atol(ack_ms.c_str()));
+            int workers = std::atoi(Config::getInstance()->get("Server", "workers").c_str());
+            if (workers > 1)
+            {
+                const SinkSet *raw = set.get();
+                set->writer.reset(new ShardWriter(workers, [raw](std::vector<ShardRecord> &batch)
+                                                  { writeBatch(*raw, batch); }));
+            }
+            return set;
         }
-
-    private:
         /// @brief 初始化落地方式
         /// @param sinks
         void init(std::vector<Xulog::LogSink::ptr> &sinks)
@@ -167,16 +323,49 @@ namespace XuServer
             }
             cfg = config->get("DataBaseSink", "path");
             if (cfg == "default")
-                sinks.push_back(std::make_shared<DataBaseSink>("./log/log.db", "server"));
-            else if (!cfg.empty())
-                sinks.push_back(std::make_shared<DataBaseSink>(cfg, "server"));
+                cfg = "./log/log.db";
+            if (!cfg.empty())
+            {
+                size_t batch_rows = std::stoul(dbValue(config, "batch_rows", "1000"));
+                size_t batch_ms = std::stoul(dbValue(config, "batch_ms", "200"));
+                bool full_text = dbValue(config, "full_text", "false") == "true";
+                std::string part = dbValue(config, "partition", "NONE");
+                DBPartition partition = part == "HOUR"  ? DBPartition::HOUR
+                                        : part == "DAY" ? DBPartition::DAY
+                                                        : DBPartition::NONE;
+                size_t max_partitions = std::stoul(dbValue(config, "max_partitions", "0"));
+                size_t queue_rows = std::stoul(dbValue(config, "queue_rows", "0"));
+                sinks.push_back(std::make_shared<DataBaseSink>(cfg, "server", batch_rows, batch_ms, dbProfile(config),
+                                                               full_text, partition, max_partitions, queue_rows));
+            }
+        }
+        /// @brief 读取 [DataBaseSink] 中的一项，未配置或为 default 时返回缺省值
+        static std::string dbValue(Config::ptr &config, const std::string &name, const std::string &def)
+        {
+            std::string v = config->get("DataBaseSink", name);
+            return (v.empty() || v == "default") ? def : v;
+        }
+        /// @brief 由 [DataBaseSink] 配置生成 SQLite 存储参数
+        static SqliteProfile dbProfile(Config::ptr &config)
+        {
+            SqliteProfile p;
+            p.journal_mode = dbValue(config, "journal_mode", p.journal_mode);
+            p.synchronous = dbValue(config, "synchronous", p.synchronous);
+            p.page_size = std::stoi(dbValue(config, "page_size", std::to_string(p.page_size)));
+            p.cache_size = std::stoi(dbValue(config, "cache_size", std::to_string(p.cache_size)));
+            p.mmap_size = std::stoll(dbValue(config, "mmap_size", std::to_string(p.mmap_size)));
+            p.wal_autocheckpoint = std::stoi(dbValue(config, "wal_autocheckpoint", std::to_string(p.wal_autocheckpoint)));
+            p.journal_size_limit = std::stoll(dbValue(config, "journal_size_limit", std::to_string(p.journal_size_limit)));
+            return p;
         }
 
     private:
         static std::shared_ptr<Xulog::LoggerBuilder> _builder; ///< 日志构造器
         static ptr _log;                                       ///< 服务器实际落地操作句柄
 
-        Xulog::Logger::ptr _logger; ///< 日志器句柄
+        Xulog::Formatter::ptr _formatter;       ///< 结构化消息的格式化器
+        std::shared_ptr<const SinkSet> _sinks; ///< 当前落地，读写都经由 atomic_load / atomic_store
+        SessionTable _session_table;            ///< 客户端会话，用于去重与确认
     };
     ServerLog::ptr ServerLog::_log = nullptr;                            ///< 服务器实际落地操作句柄
     std::shared_ptr<Xulog::LoggerBuilder> ServerLog::_builder = nullptr; ///< 日志器初始化
@@ -0,0 +1,182 @@
+/// @file session.hpp
+/// @brief 客户端会话：按序号去重并批量回复累计确认
+///
+/// 客户端连接后先发 HELLO（会话 id + 本连接第一条日志的序号），之后每个数据帧的序号依次加一，
+/// 序号不随帧传输。服务端按会话记录已接收的最大序号：重连后重传的、序号不大于它的帧直接丢弃。
+/// 确认是累计的，且只在落地提交之后回复：未确认的帧攒到一定数量或等待一定时间才提交一次并确认，
+/// 其他连接触发的提交若已覆盖本连接的帧则直接确认；客户端只剩待确认的帧时定期发 SYNC，
+/// 让服务端在没有新数据时也能按同样的条件确认。
+/// 不发 HELLO 的旧客户端不受影响，帧照常落地，也不会收到确认。
+#pragma once
+#include "buffer.hpp"
+#include "codec.hpp"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace XuServer
+{
+    /// @brief 确认策略：未确认的帧满足任一条件时提交并确认
+    struct AckPolicy
+    {
+        size_t frames = 4096; ///< 未确认的帧达到该数量
+        int64_t ms = 50;      ///< 最早的未确认帧等待超过该毫秒数
+    };
+
+    /// @class SessionTable
+    /// @brief 会话表：会话 id 到已接收最大序号的映射，跨连接共享
+    class SessionTable
+    {
+    public:
+        static constexpr size_t MAX_SESSIONS = 65536; ///< 会话数上限，超出时淘汰最久未连接的会话
+
+        /// @brief 解出缓冲中的完整帧，数据帧去重后交给 fn(data, len)
+        /// @param in 连接读缓冲
+        /// @param ok 遇到超长帧时置为 false
+        /// @param context 连接上下文，保存本连接所属的会话与下一帧的序号
+        /// @param fn 落地一帧
+        /// @param commit 让落地提交已接收的数据，只在需要确认且此前的提交没有覆盖本连接的帧时调用
+        /// @param max_frame 单帧上限
+        /// @param policy 确认策略
+        /// @return 需要发回客户端的确认帧，可能为空
+        template <typename Fn, typename Commit>
+        std::string decode(Buffer &in, bool *ok, std::shared_ptr<void> *context, Fn fn, Commit commit,
+                           uint32_t max_frame = FrameDecoder::MAX_FRAME, const AckPolicy &policy = AckPolicy())
+        {
+            std::string reply;
+            Conn *conn = static_cast<Conn *>(context->get());
+            *ok = FrameDecoder::decode(in, [&](const char *data, size_t len)
+                                       {
+                                           if (Xulog::Codec::isControl(data, len))
+                                           {
+                                               // SYNC 只是让服务端在客户端空闲时也有机会按策略确认
+                                               if (!isSync(data, len))
+                                                   conn = hello(data, len, context, &reply);
+                                               return;
+                                           }
+                                           if (conn == nullptr)
+                                               return fn(data, len);
+                                           uint64_t seq = conn->next_seq++;
+                                           std::unique_lock<std::mutex> lock(conn->session->mutex);
+                                           if (seq <= conn->session->last_seq)
+                                               return; // 重连后重传的、已经接收过的帧
+                                           fn(data, len);
+                                           conn->session->last_seq = seq;
+                                           // 落地之后读取：此后开始的提交一定包含这一帧
+                                           conn->epoch = _commit_started.load();
+                                           conn->unacked++; },
+                                       max_frame);
+            if (conn == nullptr || conn->unacked == 0)
+                return reply;
+            int64_t now = nowMs();
+            if (conn->since == 0)
+                conn->since = now;
+            if (_commit_done.load() <= conn->epoch)
+            {
+                if (conn->unacked < policy.frames && now - conn->since < policy.ms)
+                    return reply;
+                uint64_t started = ++_commit_started;
+                commit();
+                uint64_t done = _commit_done.load();
+                while (done < started && !_commit_done.compare_exchange_weak(done, started))
+                    ;
+            }
+            conn->unacked = 0;
+            conn->since = 0;
+            std::string ack;
+            Xulog::Codec::toControl(Xulog::Codec::Control::ACK, lastSeq(conn), 0, &ack);
+            FrameDecoder::encode(ack.data(), ack.size(), &reply);
+            return reply;
+        }
+        /// @brief 当前会话数
+        size_t size()
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            return _sessions.size();
+        }
+
+    private:
+        /// @brief 一个客户端会话
+        struct Session
+        {
+            std::mutex mutex;      ///< 同一会话的新旧连接可能同时在处理
+            uint64_t last_seq = 0; ///< 已接收的最大序号
+            int64_t touched = 0;   ///< 最近一次 HELLO 的时间，用于淘汰
+        };
+        /// @brief 连接所属的会话
+        struct Conn
+        {
+            std::shared_ptr<Session> session; ///< 会话
+            uint64_t next_seq = 0;            ///< 下一个数据帧的序号
+            size_t unacked = 0;               ///< 已落地、尚未确认的帧数
+            int64_t since = 0;                ///< 最早的未确认帧到达的时间（毫秒），0 表示没有
+            uint64_t epoch = 0;               ///< 最后一个未确认帧落地时已开始的提交数，之后开始的提交覆盖它
+        };
+
+        static int64_t nowMs()
+        {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+        static bool isSync(const char *data, size_t len)
+        {
+            Xulog::Codec::Control type;
+            uint64_t unused;
+            return Xulog::Codec::parseControl(data, len, &type, &unused, &unused) && type == Xulog::Codec::Control::SYNC;
+        }
+        static uint64_t lastSeq(Conn *conn)
+        {
+            std::unique_lock<std::mutex> lock(conn->session->mutex);
+            return conn->session->last_seq;
+        }
+        /// @brief 处理 HELLO：绑定会话并立即回复一次确认，客户端据此丢弃已被接收的待重传帧
+        Conn *hello(const char *data, size_t len, std::shared_ptr<void> *context, std::string *reply)
+        {
+            Xulog::Codec::Control type;
+            uint64_t id, first_seq;
+            if (!Xulog::Codec::parseControl(data, len, &type, &id, &first_seq) || type != Xulog::Codec::Control::HELLO)
+                return static_cast<Conn *>(context->get());
+            std::shared_ptr<Conn> conn = std::make_shared<Conn>();
+            conn->session = session(id);
+            conn->next_seq = first_seq;
+            *context = conn;
+            std::string ack;
+            Xulog::Codec::toControl(Xulog::Codec::Control::ACK, lastSeq(conn.get()), 0, &ack);
+            FrameDecoder::encode(ack.data(), ack.size(), reply);
+            return conn.get();
+        }
+        /// @brief 查找或创建会话
+        std::shared_ptr<Session> session(uint64_t id)
+        {
+            int64_t now = nowMs();
+            std::unique_lock<std::mutex> lock(_mutex);
+            auto it = _sessions.find(id);
+            if (it == _sessions.end())
+            {
+                if (_sessions.size() >= MAX_SESSIONS)
+                    evictOldest();
+                it = _sessions.emplace(id, std::make_shared<Session>()).first;
+            }
+            it->second->touched = now;
+            return it->second;
+        }
+        void evictOldest()
+        {
+            auto oldest = _sessions.begin();
+            for (auto it = _sessions.begin(); it != _sessions.end(); ++it)
+                if (it->second->touched < oldest->second->touched)
+                    oldest = it;
+            _sessions.erase(oldest);
+        }
+
+    private:
+        std::mutex _mutex;                                                ///< 保护会话表
+        std::unordered_map<uint64_t, std::shared_ptr<Session>> _sessions; ///< 会话 id 到会话
+        std::atomic<uint64_t> _commit_started{0};                         ///< 已开始的提交数
+        std::atomic<uint64_t> _commit_done{0};                            ///< 已完成的提交中编号最大的一个
+    };
+}
@@ -0,0 +1,129 @@
+/// @file shardwriter.hpp
+/// @brief 分片写入器：多个接收分片经各自的无锁队列把日志交给唯一的写线程
+///
+/// 分片模式下每个事件循环线程各自解码、格式化，只有不能并发写的落地（文件、数据库）需要汇合。
+/// 每个分片线程固定使用一个 MPSC 队列，入队只有一次 CAS，分片之间不争同一个队头；
+/// 写线程轮流取空各个队列，一批批交给写入回调，落地对象只被写线程访问，无需加锁。
+#pragma once
+#include "../logs/message.hpp"
+#include "../logs/mpsc_queue.hpp"
+#include "nocopy.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace XuServer
+{
+    /// @brief 交给写线程的一条日志
+    struct ShardRecord
+    {
+        std::string text;        ///< 写文本落地的字符串（结构化消息为格式化结果）
+        Xulog::LogMsg msg;       ///< 结构化消息，写数据库落地
+        bool structured = false; ///< 是否为结构化消息，非结构化消息不写数据库
+    };
+
+    /// @class ShardWriter
+    /// @brief 每个分片一个 MPSC 队列，单一写线程汇合写入
+    class ShardWriter : public nocopy
+    {
+    public:
+        using Writer = std::function<void(std::vector<ShardRecord> &)>; ///< 写入一批日志，只在写线程调用
+
+        static constexpr size_t DEFAULT_QUEUE = 64 * 1024; ///< 每个分片队列的默认容量（条）
+
+        /// @brief 构造函数
+        /// @param shards 分片数，即队列数
+        /// @param writer 写入回调
+        /// @param max_queue 每个队列的容量，写线程跟不上时分片线程在入队处等待（背压）
+        ShardWriter(size_t shards, Writer writer, size_t max_queue = DEFAULT_QUEUE) : _writer(writer)
+        {
+            for (size_t i = 0; i < std::max<size_t>(1, shards); i++)
+                _queues.emplace_back(new Xulog::MpscQueue<ShardRecord>(max_queue));
+            _thread = std::thread(&ShardWriter::run, this);
+        }
+        /// @brief 写完全部队列后退出写线程
+        ~ShardWriter()
+        {
+            _stop.store(true, std::memory_order_release);
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+            }
+            _wake.notify_one();
+            _thread.join();
+        }
+        /// @brief 入队，可在任意线程调用；同一线程总是使用同一个队列，保持该线程内的先后顺序
+        void push(ShardRecord &&record)
+        {
+            static std::atomic<size_t> next_slot{0};
+            thread_local size_t slot = next_slot.fetch_add(1, std::memory_order_relaxed);
+            _queues[slot % _queues.size()]->push(std::move(record));
+        }
+        /// @brief 屏障：返回时调用前已入队的日志都已交给写入回调
+        void sync()
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            uint64_t target = ++_requested;
+            _wake.notify_one();
+            _synced_cv.wait(lock, [&]()
+                            { return _synced >= target; });
+        }
+        /// @brief 分片数
+        size_t shards() const { return _queues.size(); }
+
+    private:
+        /// @brief 写线程：每轮取空全部队列；某轮开始前请求的屏障在该轮结束时完成
+        void run()
+        {
+            while (true)
+            {
+                bool stopping = _stop.load(std::memory_order_acquire);
+                uint64_t requested;
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    requested = _requested;
+                }
+                bool wrote = false;
+                for (auto &queue : _queues)
+                {
+                    std::vector<ShardRecord> batch = queue->popAll();
+                    if (batch.empty())
+                        continue;
+                    _writer(batch);
+                    wrote = true;
+                }
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    if (_synced < requested)
+                    {
+                        _synced = requested;
+                        _synced_cv.notify_all();
+                    }
+                    if (wrote)
+                        continue;
+                    if (stopping)
+                        break;
+                    // 队列空：短休眠，期间有屏障请求或退出时立即醒来
+                    _wake.wait_for(lock, std::chrono::milliseconds(1), [this]()
+                                   { return _requested > _synced || _stop.load(std::memory_order_acquire); });
+                }
+            }
+        }
+
+        Writer _writer;                                                      ///< 写入回调
+        std::vector<std::unique_ptr<Xulog::MpscQueue<ShardRecord>>> _queues; ///< 每个分片一个队列
+        std::atomic<bool> _stop{false};                                      ///< 退出标志
+        std::mutex _mutex;                                                   ///< 保护屏障计数
+        std::condition_variable _wake;                                       ///< 唤醒写线程
+        std::condition_variable _synced_cv;                                  ///< 通知屏障完成
+        uint64_t _requested = 0;                                             ///< 已请求的屏障数
+        uint64_t _synced = 0;                                                ///< 已完成的屏障数
+        std::thread _thread;                                                 ///< 写线程，最后声明，启动时其余成员已构造
+    };
+}
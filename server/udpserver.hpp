@@ -0,0 +1,124 @@
+/// @file udpserver.hpp
+/// @brief UDP 接收服务器
+///
+/// 每个数据报装有若干条完整的长度前缀帧（与 TCP 相同的帧格式），由 UdpSink 打包发送。
+/// 接收线程用 recvmmsg 一次收下多个数据报，直接收进预先分配好的一整块缓冲（每个数据报一格），
+/// 原地逐帧交给回调，收包路径上没有任何内存分配。
+/// UDP 不保证送达与顺序，适合可以容忍丢失的调试类日志；需要可靠送达时使用 TCP。
+#pragma once
+#include "Socket.hpp"
+#include "buffer.hpp"
+#include "nocopy.hpp"
+#include <atomic>
+#include <cerrno>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <poll.h>
+#include <sys/eventfd.h>
+
+namespace XuServer
+{
+    /// @class UdpServer
+    /// @brief 单线程 UDP 接收服务器
+    class UdpServer : public nocopy
+    {
+    public:
+        using Handler = std::function<void(const char *data, size_t len)>; ///< 处理一帧，data 指向接收缓冲内部
+
+        static constexpr size_t MAX_DATAGRAM = 65507;       ///< IPv4 UDP 数据报的最大正文
+        static constexpr int RECV_BUFFER = 8 * 1024 * 1024; ///< 内核接收缓冲，吸收突发流量
+
+        /// @brief 构造函数，绑定端口
+        /// @param port 端口号，0 表示由系统分配
+        /// @param handler 处理一帧的回调，与 TCP 服务器的帧处理相同
+        /// @param batch 每次 recvmmsg 最多接收的数据报数
+        /// @param max_datagram 单个数据报的接收缓冲大小，超出的数据报被截断并丢弃
+        UdpServer(uint16_t port, Handler handler, size_t batch = 64, size_t max_datagram = MAX_DATAGRAM)
+            : _socket(new UdpSocket()), _handler(handler), _max_datagram(max_datagram),
+              _slab(batch * max_datagram), _iovs(batch), _msgs(batch)
+        {
+            _socket->CreateBuildSocketMethod(port);
+            _socket->SetRecvBuffer(RECV_BUFFER);
+            _socket->SetNonBlock();
+            _port = _socket->GetLocalPort();
+            _wakeup = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            for (size_t i = 0; i < batch; i++)
+            {
+                _iovs[i].iov_base = &_slab[i * max_datagram];
+                _iovs[i].iov_len = max_datagram;
+                ::memset(&_msgs[i], 0, sizeof(_msgs[i]));
+                _msgs[i].msg_hdr.msg_iov = &_iovs[i];
+                _msgs[i].msg_hdr.msg_iovlen = 1;
+            }
+        }
+        ~UdpServer()
+        {
+            _socket->CloseSockFd();
+            if (_wakeup >= 0)
+                ::close(_wakeup);
+        }
+        /// @brief 接收循环，阻塞到 Stop() 被调用
+        void Loop()
+        {
+            struct pollfd fds[2] = {{_socket->GetSockFd(), POLLIN, 0}, {_wakeup, POLLIN, 0}};
+            while (!_stop.load(std::memory_order_acquire))
+            {
+                if (::poll(fds, 2, -1) < 0 && errno != EINTR)
+                    break;
+                if (fds[0].revents & POLLIN)
+                    drain();
+            }
+        }
+        /// @brief 通知接收循环退出，可在任意线程调用
+        void Stop()
+        {
+            _stop.store(true, std::memory_order_release);
+            uint64_t one = 1;
+            ssize_t n = ::write(_wakeup, &one, sizeof(one));
+            (void)n;
+        }
+        /// @brief 实际绑定的端口号
+        uint16_t Port() const { return _port; }
+        /// @brief 收到的数据报数
+        size_t datagrams() const { return _datagrams.load(std::memory_order_relaxed); }
+        /// @brief 截断或帧不完整、被整体或部分丢弃的数据报数
+        size_t malformed() const { return _malformed.load(std::memory_order_relaxed); }
+
+    private:
+        /// @brief 收完内核中排队的数据报
+        void drain()
+        {
+            while (true)
+            {
+                int n = _socket->RecvMany(_msgs.data(), _msgs.size());
+                if (n <= 0)
+                    return;
+                for (int i = 0; i < n; i++)
+                {
+                    const char *data = &_slab[i * _max_datagram];
+                    if ((_msgs[i].msg_hdr.msg_flags & MSG_TRUNC) ||
+                        !FrameDecoder::decode(data, _msgs[i].msg_len, [this](const char *frame, size_t len)
+                                              { _handler(frame, len); }))
+                        _malformed.fetch_add(1, std::memory_order_relaxed);
+                }
+                _datagrams.fetch_add(n, std::memory_order_relaxed);
+                if ((size_t)n < _msgs.size())
+                    return;
+            }
+        }
+
+    private:
+        std::unique_ptr<UdpSocket> _socket; ///< 监听 socket
+        Handler _handler;                   ///< 帧处理回调
+        uint16_t _port = 0;                 ///< 实际绑定的端口
+        int _wakeup = -1;                   ///< Stop() 唤醒 poll 的 eventfd
+        size_t _max_datagram;               ///< 每格缓冲大小
+        std::vector<char> _slab;            ///< 预分配的接收缓冲，每个数据报一格
+        std::vector<struct iovec> _iovs;    ///< 指向各格缓冲
+        std::vector<struct mmsghdr> _msgs;  ///< recvmmsg 的消息数组
+        std::atomic<bool> _stop{false};     ///< 退出标志
+        std::atomic<size_t> _datagrams{0};  ///< 收到的数据报数
+        std::atomic<size_t> _malformed{0};  ///< 异常的数据报数
+    };
+}
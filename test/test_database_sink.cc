@@ -0,0 +1,538 @@
+// test_database_sink.cc —— DataBaseSink 落库：组提交按条数/等级/空闲超时/flush/析构提交，分区交错写入与迟到日志
+#include <gtest/gtest.h>
+#include "../extend/DataBaseSink.hpp"
+#include <sqlite3.h>
+#include <unistd.h>
+#include <thread>
+
+// 另开一个连接统计已提交的行数（未提交的事务对其不可见）
+static int committedRows(const std::string &dbfile)
+{
+    sqlite3 *db = nullptr;
+    sqlite3_open(dbfile.c_str(), &db);
+    sqlite3_busy_timeout(db, 1000);
+    sqlite3_stmt *stmt = nullptr;
+    int n = -1;
+    if (sqlite3_prepare_v2(db, "SELECT COUNT(*) FROM logs", -1, &stmt, nullptr) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW)
+        n = sqlite3_column_int(stmt, 0);
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    return n;
+}
+
+static Xulog::LogMsg makeMsg(Xulog::LogLevel::value level, const std::string &payload)
+{
+    return Xulog::LogMsg(level, 42, "test_database_sink.cc", "dbtest", payload);
+}
+
+class DataBaseSinkTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        _dbfile = "./test_data/db_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()) + ".db";
+        unlink(_dbfile.c_str());
+        unlink((_dbfile + "-wal").c_str());
+        unlink((_dbfile + "-shm").c_str());
+    }
+    std::string _dbfile;
+};
+
+// 攒满 batch_rows 条才提交
+TEST_F(DataBaseSinkTest, CommitsWhenBatchFull)
+{
+    auto sink = std::make_shared<DataBaseSink>(_dbfile, "dbtest", 10, 60000);
+    for (int i = 0; i < 9; i++)
+        sink->log(makeMsg(Xulog::LogLevel::value::INFO, "row"));
+    EXPECT_EQ(0, committedRows(_dbfile));
+    sink->log(makeMsg(Xulog::LogLevel::value::INFO, "row"));
+    EXPECT_EQ(10, committedRows(_dbfile));
+}
+
+// ERROR 及以上立即提交，连同之前攒下的行
+TEST_F(DataBaseSinkTest, ErrorCommitsImmediately)
+{
+    auto sink = std::make_shared<DataBaseSink>(_dbfile, "dbtest", 1000, 60000);
+    sink->log(makeMsg(Xulog::LogLevel::value::DEBUG, "d"));
+    sink->log(makeMsg(Xulog::LogLevel::value::WARN, "w"));
+    EXPECT_EQ(0, committedRows(_dbfile));
+    sink->log(makeMsg(Xulog::LogLevel::value::ERROR, "e"));
+    EXPECT_EQ(3, committedRows(_dbfile));
+}
+
+// 超过时间窗口后提交当前批次，之后的写入开启新事务
+TEST_F(DataBaseSinkTest, CommitsWhenWindowElapsed)
+{
+    auto sink = std::make_shared<DataBaseSink>(_dbfile, "dbtest", 1000, 20);
+    sink->log(makeMsg(Xulog::LogLevel::value::INFO, "a"));
+    usleep(60 * 1000);
+    EXPECT_EQ(1, committedRows(_dbfile));
+    sink->log(makeMsg(Xulog::LogLevel::value::INFO, "b"));
+    EXPECT_EQ(1, committedRows(_dbfile));
+    usleep(60 * 1000);
+    EXPECT_EQ(2, committedRows(_dbfile));
+}
+
+// 不启用写线程时，单条日志之后再无写入，尾批也在 batch_ms 后提交，另一个连接可见
+TEST_F(DataBaseSinkTest, IdleTailCommitsWithoutWriterThread)
+{
+    auto sink = std::make_shared<DataBaseSink>(_dbfile, "dbtest", 1000, 50);
+    sink->log(makeMsg(Xulog::LogLevel::value::INFO, "lonely"));
+    EXPECT_EQ(0, committedRows(_dbfile));
+    usleep(300 * 1000);
+    EXPECT_EQ(1, committedRows(_dbfile));
+}
+
+// flush 与析构提交尾批
+TEST_F(DataBaseSinkTest, FlushAndDestructorCommitTail)
+{
+    {
+        auto sink = std::make_shared<DataBaseSink>(_dbfile, "dbtest", 1000, 60000);
+        sink->log(makeMsg(Xulog::LogLevel::value::INFO, "a"));
+        sink->flush();
+        EXPECT_EQ(1, committedRows(_dbfile));
+        sink->log(makeMsg(Xulog::LogLevel::value::INFO, "b"));
+    }
+    EXPECT_EQ(2, committedRows(_dbfile));
+}
+
+// 经日志器写入：字段完整落库
+TEST_F(DataBaseSinkTest, LoggerPathStoresFields)
+{
+    {
+        auto sink = std::make_shared<DataBaseSink>(_dbfile, "dbtest");
+        auto formatter = std::make_shared<Xulog::Formatter>("%m");
+        std::vector<Xulog::LogSink::ptr> sinks{sink};
+        auto logger = std::make_shared<Xulog::SyncLogger>("dbtest", Xulog::LogLevel::value::DEBUG, formatter, sinks);
+        for (int i = 0; i < 500; i++)
+            info(logger, "it's row %d", i);
+    }
+    sqlite3 *db = nullptr;
+    sqlite3_open(_dbfile.c_str(), &db);
+    sqlite3_stmt *stmt = nullptr;
+    ASSERT_EQ(SQLITE_OK, sqlite3_prepare_v2(db, "SELECT COUNT(*), MAX(message), MIN(log_level) FROM logs", -1, &stmt, nullptr));
+    ASSERT_EQ(SQLITE_ROW, sqlite3_step(stmt));
+    EXPECT_EQ(500, sqlite3_column_int(stmt, 0));
+    EXPECT_STREQ("it's row 99", (const char *)sqlite3_column_text(stmt, 1));
+    EXPECT_STREQ("INFO", (const char *)sqlite3_column_text(stmt, 2));
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+}
+
+static std::string pragmaText(const std::string &dbfile, const std::string &pragma)
+{
+    sqlite3 *db = nullptr;
+    sqlite3_open(dbfile.c_str(), &db);
+    sqlite3_stmt *stmt = nullptr;
+    std::string v;
+    if (sqlite3_prepare_v2(db, ("PRAGMA " + pragma).c_str(), -1, &stmt, nullptr) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW)
+        v = (const char *)sqlite3_column_text(stmt, 0);
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    return v;
+}
+
+// 默认存储参数：WAL，页大小按设置建库
+TEST_F(DataBaseSinkTest, DefaultProfileUsesWal)
+{
+    SqliteProfile profile;
+    profile.page_size = 8192;
+    auto sink = std::make_shared<DataBaseSink>(_dbfile, "dbtest", 1, 0, profile);
+    sink->log(makeMsg(Xulog::LogLevel::value::INFO, "x"));
+    EXPECT_EQ("wal", pragmaText(_dbfile, "journal_mode"));
+    EXPECT_EQ("8192", pragmaText(_dbfile, "page_size"));
+}
+
+// legacy 与非法取值
+TEST_F(DataBaseSinkTest, LegacyAndInvalidProfile)
+{
+    EXPECT_TRUE(SqliteProfile::legacy().valid());
+    SqliteProfile bad;
+    bad.synchronous = "NORMAL; DROP TABLE logs";
+    EXPECT_FALSE(bad.valid());
+
+    auto sink = std::make_shared<DataBaseSink>(_dbfile, "dbtest", 1, 0, SqliteProfile::legacy());
+    sink->log(makeMsg(Xulog::LogLevel::value::INFO, "x"));
+    EXPECT_EQ("delete", pragmaText(_dbfile, "journal_mode"));
+}
+
+// WAL 下读者持有读事务时写者照常提交
+TEST_F(DataBaseSinkTest, ReaderDoesNotBlockWriterUnderWal)
+{
+    auto sink = std::make_shared<DataBaseSink>(_dbfile, "dbtest", 1, 0);
+    sink->log(makeMsg(Xulog::LogLevel::value::INFO, "before"));
+
+    sqlite3 *reader = nullptr;
+    ASSERT_EQ(SQLITE_OK, sqlite3_open_v2(_dbfile.c_str(), &reader, SQLITE_OPEN_READONLY, nullptr));
+    sqlite3_exec(reader, "BEGIN", nullptr, nullptr, nullptr);
+    sqlite3_stmt *stmt = nullptr;
+    ASSERT_EQ(SQLITE_OK, sqlite3_prepare_v2(reader, "SELECT COUNT(*) FROM logs", -1, &stmt, nullptr));
+    ASSERT_EQ(SQLITE_ROW, sqlite3_step(stmt));
+    EXPECT_EQ(1, sqlite3_column_int(stmt, 0));
+    sqlite3_finalize(stmt);
+
+    for (int i = 0; i < 10; i++)
+        sink->log(makeMsg(Xulog::LogLevel::value::INFO, "during"));
+    EXPECT_EQ(11, committedRows(_dbfile));
+
+    sqlite3_exec(reader, "COMMIT", nullptr, nullptr, nullptr);
+    sqlite3_close(reader);
+}
+
+static long long queryInt(const std::string &dbfile, const std::string &sql)
+{
+    sqlite3 *db = nullptr;
+    sqlite3_open(dbfile.c_str(), &db);
+    sqlite3_stmt *stmt = nullptr;
+    long long v = -1;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK &&
+        sqlite3_step(stmt) == SQLITE_ROW)
+        v = sqlite3_column_int64(stmt, 0);
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    return v;
+}
+
+// 新库直接建到当前版本：整数微秒时间 + 三个索引 + 字典编码 + 分钟汇总
+TEST_F(DataBaseSinkTest, NewDatabaseUsesCurrentSchema)
+{
+    auto sink = std::make_shared<DataBaseSink>(_dbfile, "dbtest", 1, 0);
+    auto msg = makeMsg(Xulog::LogLevel::value::INFO, "x");
+    sink->log(msg);
+    EXPECT_EQ(DataBaseSink::SCHEMA_VERSION, queryInt(_dbfile, "PRAGMA user_version"));
+    EXPECT_EQ(3, queryInt(_dbfile, "SELECT COUNT(*) FROM sqlite_master WHERE type='index' AND name LIKE 'idx_records_%'"));
+    EXPECT_EQ((long long)msg._ctime * 1000000 + msg._usec, queryInt(_dbfile, "SELECT log_time FROM logs"));
+}
+
+// 重复的字符串只在维度表中存一份，视图连接回原列
+TEST_F(DataBaseSinkTest, DictionaryEncodesRepeatedColumns)
+{
+    {
+        auto sink = std::make_shared<DataBaseSink>(_dbfile, "dbtest", 100, 60000);
+        for (int i = 0; i < 50; i++)
+        {
+            sink->log(Xulog::LogMsg(Xulog::LogLevel::value::INFO, i, "a.cc", "alpha", "m"));
+            sink->log(Xulog::LogMsg(Xulog::LogLevel::value::WARN, i, "b.cc", "beta", "m"));
+        }
+    }
+    EXPECT_EQ(100, queryInt(_dbfile, "SELECT COUNT(*) FROM log_records"));
+    EXPECT_EQ(2, queryInt(_dbfile, "SELECT COUNT(*) FROM log_loggers"));
+    EXPECT_EQ(2, queryInt(_dbfile, "SELECT COUNT(*) FROM log_files"));
+    EXPECT_EQ(2, queryInt(_dbfile, "SELECT COUNT(*) FROM log_levels"));
+    EXPECT_EQ(1, queryInt(_dbfile, "SELECT COUNT(*) FROM log_threads"));
+    EXPECT_EQ(50, queryInt(_dbfile, "SELECT COUNT(*) FROM logs WHERE logger_name='beta' AND log_level='WARN' AND source_file='b.cc'"));
+
+    // 再次打开时缓存为空，已有名称复用原 id
+    {
+        auto sink = std::make_shared<DataBaseSink>(_dbfile, "dbtest", 1, 0);
+        sink->log(Xulog::LogMsg(Xulog::LogLevel::value::INFO, 1, "a.cc", "alpha", "again"));
+    }
+    EXPECT_EQ(2, queryInt(_dbfile, "SELECT COUNT(*) FROM log_loggers"));
+    EXPECT_EQ(51, queryInt(_dbfile, "SELECT COUNT(*) FROM logs WHERE logger_name='alpha'"));
+}
+
+// 旧库（TEXT 时间，+8 小时）打开时原地迁移，时间换算回 UTC 纪元微秒
+TEST_F(DataBaseSinkTest, MigratesV1Database)
+{
+    {
+        Xulog::Util::File::createDirectory("./test_data");
+        sqlite3 *db = nullptr;
+        sqlite3_open(_dbfile.c_str(), &db);
+        sqlite3_exec(db,
+                     "CREATE TABLE logs (id INTEGER PRIMARY KEY AUTOINCREMENT, log_time TIMESTAMP NOT NULL,"
+                     "line_number INT, thread_id VARCHAR(255), log_level VARCHAR(10) NOT NULL,"
+                     "source_file VARCHAR(255), logger_name VARCHAR(255),message TEXT);"
+                     "INSERT INTO logs (log_time, line_number, thread_id, log_level, source_file, logger_name, message) "
+                     "VALUES (datetime(1719763200, 'unixepoch', '+8 hours'), 1, 't', 'WARN', 'a.cc', 'old', 'legacy row');",
+                     nullptr, nullptr, nullptr);
+        sqlite3_close(db);
+    }
+    auto sink = std::make_shared<DataBaseSink>(_dbfile, "dbtest", 1, 0);
+    sink->log(makeMsg(Xulog::LogLevel::value::INFO, "new row"));
+    EXPECT_EQ(DataBaseSink::SCHEMA_VERSION, queryInt(_dbfile, "PRAGMA user_version"));
+    EXPECT_EQ(1, queryInt(_dbfile, "SELECT COUNT(*) FROM logs WHERE logger_name='old' AND log_level='WARN' AND message='legacy row'"));
+    EXPECT_EQ(1719763200000000LL, queryInt(_dbfile, "SELECT log_time FROM logs WHERE id=1"));
+    EXPECT_EQ(2, queryInt(_dbfile, "SELECT COUNT(*) FROM logs"));
+    EXPECT_EQ(0, queryInt(_dbfile, "SELECT COUNT(*) FROM sqlite_master WHERE name IN ('logs_v1', 'logs_v2')"));
+    EXPECT_EQ(2, queryInt(_dbfile, "SELECT MAX(id) FROM logs"));
+}
+
+// 全文索引随主表同一事务提交；对已有数据的库首次启用时补建索引
+TEST_F(DataBaseSinkTest, FullTextIndexInSync)
+{
+    {
+        auto sink = std::make_shared<DataBaseSink>(_dbfile, "dbtest", 100, 60000);
+        sink->log(makeMsg(Xulog::LogLevel::value::INFO, "connection reset by peer"));
+    }
+    auto sink = std::make_shared<DataBaseSink>(_dbfile, "dbtest", 100, 60000, SqliteProfile(), true);
+    sink->log(makeMsg(Xulog::LogLevel::value::INFO, "connection refused"));
+    const std::string match = "SELECT COUNT(*) FROM logs_fts WHERE logs_fts MATCH 'connection'";
+    EXPECT_EQ(1, queryInt(_dbfile, match)); // 新行尚未提交
+    sink->flush();
+    EXPECT_EQ(2, queryInt(_dbfile, match));
+    EXPECT_EQ(1, queryInt(_dbfile, "SELECT COUNT(*) FROM logs_fts WHERE logs_fts MATCH 'refus*'"));
+}
+
+// v2 库（带全文索引）迁移到 v3 后，全文索引仍可用且继续同步
+TEST_F(DataBaseSinkTest, MigratesV2WithFullText)
+{
+    {
+        Xulog::Util::File::createDirectory("./test_data");
+        sqlite3 *db = nullptr;
+        sqlite3_open(_dbfile.c_str(), &db);
+        sqlite3_exec(db,
+                     "CREATE TABLE logs (id INTEGER PRIMARY KEY AUTOINCREMENT, log_time INTEGER NOT NULL,"
+                     "line_number INT, thread_id VARCHAR(255), log_level VARCHAR(10) NOT NULL,"
+                     "source_file VARCHAR(255), logger_name VARCHAR(255), message TEXT);"
+                     "CREATE VIRTUAL TABLE logs_fts USING fts5(message, content='logs', content_rowid='id');"
+                     "CREATE TRIGGER logs_fts_ai AFTER INSERT ON logs BEGIN "
+                     "INSERT INTO logs_fts(rowid, message) VALUES (new.id, new.message); END;"
+                     "INSERT INTO logs VALUES (7, 1719763200000000, 1, 't1', 'ERROR', 'a.cc', 'old', 'disk full');"
+                     "PRAGMA user_version=2;",
+                     nullptr, nullptr, nullptr);
+        sqlite3_close(db);
+    }
+    auto sink = std::make_shared<DataBaseSink>(_dbfile, "dbtest", 1, 0);
+    sink->log(makeMsg(Xulog::LogLevel::value::INFO, "disk almost full"));
+    EXPECT_EQ(DataBaseSink::SCHEMA_VERSION, queryInt(_dbfile, "PRAGMA user_version"));
+    EXPECT_EQ(7, queryInt(_dbfile, "SELECT id FROM logs WHERE logger_name='old'"));
+    EXPECT_EQ(2, queryInt(_dbfile, "SELECT COUNT(*) FROM logs_fts WHERE logs_fts MATCH 'disk'"));
+    EXPECT_EQ(8, queryInt(_dbfile, "SELECT MAX(id) FROM logs"));
+}
+
+// ---- 写线程 ---------------------------------------------------------
+// 同步日志器多线程写入只入队；flush() 返回时此前的日志已全部提交
+TEST_F(DataBaseSinkTest, WriterThreadFlushIsBarrier)
+{
+    auto sink = std::make_shared<DataBaseSink>(_dbfile, "dbtest", 100000, 60000, SqliteProfile(), false,
+                                               DBPartition::NONE, 0, 1024);
+    EXPECT_TRUE(sink->threadSafe());
+    auto formatter = std::make_shared<Xulog::Formatter>("%m");
+    std::vector<Xulog::LogSink::ptr> sinks{sink};
+    auto logger = std::make_shared<Xulog::SyncLogger>("dbtest", Xulog::LogLevel::value::DEBUG, formatter, sinks);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+        threads.emplace_back([&]()
+                             { for (int i = 0; i < 250; i++) info(logger, "row %d", i); });
+    for (auto &th : threads)
+        th.join();
+    sink->flush();
+    EXPECT_EQ(1000, committedRows(_dbfile));
+    sink->log(makeMsg(Xulog::LogLevel::value::INFO, "after"));
+    sink->flush();
+    EXPECT_EQ(1001, committedRows(_dbfile));
+}
+
+// 写线程空闲超过 batch_ms 时自行提交尾批，无需 flush
+TEST_F(DataBaseSinkTest, WriterThreadCommitsIdleTail)
+{
+    auto sink = std::make_shared<DataBaseSink>(_dbfile, "dbtest", 1000, 20, SqliteProfile(), false,
+                                               DBPartition::NONE, 0, 64);
+    for (int i = 0; i < 3; i++)
+        sink->log(makeMsg(Xulog::LogLevel::value::INFO, "tail"));
+    for (int i = 0; i < 100 && committedRows(_dbfile) < 3; i++)
+        usleep(10 * 1000);
+    EXPECT_EQ(3, committedRows(_dbfile));
+}
+
+// 队列很小时写入方等待写线程腾出空间，日志不丢
+TEST_F(DataBaseSinkTest, WriterThreadBoundedQueue)
+{
+    {
+        auto sink = std::make_shared<DataBaseSink>(_dbfile, "dbtest", 1000, 60000, SqliteProfile(), false,
+                                                   DBPartition::NONE, 0, 2);
+        for (int i = 0; i < 500; i++)
+            sink->log(makeMsg(Xulog::LogLevel::value::INFO, "row"));
+    }
+    EXPECT_EQ(500, committedRows(_dbfile));
+}
+
+// ---- 时间分区 -------------------------------------------------------
+class DataBaseSinkPartitionTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        setenv("TZ", "CST-8", 1);
+        tzset();
+        _dir = "./test_data/part_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()) + "/";
+        system(("rm -rf " + _dir).c_str());
+        _dbfile = _dir + "log.db";
+    }
+    // 2024-07-01 00:00 (+08:00) 之后 minutes 分钟的日志
+    static Xulog::LogMsg at(int minutes, const std::string &payload)
+    {
+        Xulog::LogMsg msg(Xulog::LogLevel::value::INFO, 1, "a.cc", "part", payload);
+        msg._ctime = 1719763200 + minutes * 60;
+        msg._usec = 0;
+        return msg;
+    }
+    std::string _dir;
+    std::string _dbfile;
+};
+
+// 按小时写入各自的分区文件，清单记录时间范围，id 从分区起始微秒开始
+TEST_F(DataBaseSinkPartitionTest, WritesHourlyFilesWithManifest)
+{
+    {
+        DataBaseSink sink(_dbfile, "dbtest", 100, 60000, SqliteProfile(), false, DBPartition::HOUR);
+        sink.log(at(10, "a"));
+        sink.log(at(50, "b"));
+        sink.log(at(65, "c"));
+        sink.log(at(30, "late")); // 迟到的日志回到所属分区
+        sink.log(at(180, "d"));
+    }
+    const long long h0 = 1719763200LL * 1000000;
+    EXPECT_EQ(3, queryInt(_dbfile, "SELECT COUNT(*) FROM log_partitions"));
+    EXPECT_EQ(h0, queryInt(_dbfile, "SELECT start_us FROM log_partitions WHERE file='log.2024070100.db'"));
+    EXPECT_EQ(h0 + 3600000000LL, queryInt(_dbfile, "SELECT end_us FROM log_partitions WHERE file='log.2024070100.db'"));
+    EXPECT_EQ(3, committedRows(_dir + "log.2024070100.db"));
+    EXPECT_EQ(1, committedRows(_dir + "log.2024070101.db"));
+    EXPECT_EQ(1, committedRows(_dir + "log.2024070103.db"));
+    EXPECT_EQ(h0 + 1, queryInt(_dir + "log.2024070100.db", "SELECT MIN(id) FROM logs"));
+    EXPECT_EQ(h0 + 3600000000LL + 1, queryInt(_dir + "log.2024070101.db", "SELECT id FROM logs"));
+}
+
+// 超过保留数量时删除最旧的分区文件；dropPartitionsBefore 按时间删除
+TEST_F(DataBaseSinkPartitionTest, RetentionUnlinksOldPartitions)
+{
+    DataBaseSink sink(_dbfile, "dbtest", 1, 0, SqliteProfile(), false, DBPartition::HOUR, 2);
+    sink.log(at(0, "a"));
+    sink.log(at(60, "b"));
+    sink.log(at(120, "c"));
+    EXPECT_FALSE(Xulog::Util::File::exists(_dir + "log.2024070100.db"));
+    EXPECT_TRUE(Xulog::Util::File::exists(_dir + "log.2024070101.db"));
+    EXPECT_EQ(2, queryInt(_dbfile, "SELECT COUNT(*) FROM log_partitions"));
+
+    // 当前分区即使已过期也保留
+    EXPECT_EQ(1u, sink.dropPartitionsBefore(1719763200 + 4 * 3600));
+    EXPECT_FALSE(Xulog::Util::File::exists(_dir + "log.2024070101.db"));
+    EXPECT_TRUE(Xulog::Util::File::exists(_dir + "log.2024070102.db"));
+    EXPECT_EQ(1, queryInt(_dbfile, "SELECT COUNT(*) FROM log_partitions"));
+}
+
+// 两个小时的日志交错到达：各分区保持打开、各自攒批，不因切换分区而逐行提交
+TEST_F(DataBaseSinkPartitionTest, InterleavedHoursKeepBatching)
+{
+    DataBaseSink sink(_dbfile, "dbtest", 1000, 60000, SqliteProfile(), false, DBPartition::HOUR);
+    for (int i = 0; i < 200; i++)
+        sink.log(at(i % 2 == 0 ? 30 : 90, "row " + std::to_string(i)));
+    // 批次未满、窗口未到：两个分区都还没有提交
+    EXPECT_EQ(0, committedRows(_dir + "log.2024070100.db"));
+    EXPECT_EQ(0, committedRows(_dir + "log.2024070101.db"));
+    sink.flush();
+    EXPECT_EQ(100, committedRows(_dir + "log.2024070100.db"));
+    EXPECT_EQ(100, committedRows(_dir + "log.2024070101.db"));
+    EXPECT_EQ(2, queryInt(_dbfile, "SELECT COUNT(*) FROM log_partitions"));
+    EXPECT_EQ(100, queryInt(_dir + "log.2024070101.db", "SELECT SUM(count) FROM log_rollup_minute"));
+}
+
+// 所属分区已被保留策略删除的迟到日志被丢弃，不重建分区文件与清单记录
+TEST_F(DataBaseSinkPartitionTest, LateRowsForDroppedPartitionsAreDiscarded)
+{
+    DataBaseSink sink(_dbfile, "dbtest", 1, 0, SqliteProfile(), false, DBPartition::HOUR, 2);
+    sink.log(at(0, "a"));
+    sink.log(at(60, "b"));
+    sink.log(at(120, "c"));
+    ASSERT_FALSE(Xulog::Util::File::exists(_dir + "log.2024070100.db"));
+
+    sink.log(at(30, "late"));          // 分区 00 已被删除
+    sink.log(at(-60, "older"));        // 比现存最旧的分区还旧，保留数已满
+    sink.log(at(70, "late but kept")); // 分区 01 仍在保留范围内
+    EXPECT_EQ(2u, sink.expiredRows());
+    EXPECT_FALSE(Xulog::Util::File::exists(_dir + "log.2024070100.db"));
+    EXPECT_FALSE(Xulog::Util::File::exists(_dir + "log.2024063023.db"));
+    EXPECT_EQ(2, queryInt(_dbfile, "SELECT COUNT(*) FROM log_partitions"));
+    EXPECT_EQ(2, committedRows(_dir + "log.2024070101.db"));
+}
+
+// 写线程插入、调用方线程同时删除分区：写线程等待时不遍历受 mutex() 保护的分区列表
+TEST_F(DataBaseSinkPartitionTest, WriterThreadWithConcurrentDrops)
+{
+    DataBaseSink sink(_dbfile, "dbtest", 50, 5, SqliteProfile(), false, DBPartition::HOUR, 0, 64);
+    std::thread producer([&sink]()
+                         {
+        for (int i = 0; i < 3000; i++)
+            sink.log(at((i / 500) * 60 + 1, "row")); });
+    for (int i = 0; i < 200; i++)
+    {
+        sink.dropPartitionsBefore(1719763200 + (i % 6) * 3600);
+        usleep(500);
+    }
+    producer.join();
+    sink.flush();
+    long long partitions = queryInt(_dbfile, "SELECT COUNT(*) FROM log_partitions");
+    EXPECT_GE(partitions, 1);
+    EXPECT_EQ(500, committedRows(_dir + "log.2024070105.db"));
+}
+
+// 按天分区
+TEST_F(DataBaseSinkPartitionTest, DailyPartition)
+{
+    {
+        DataBaseSink sink(_dbfile, "dbtest", 1, 0, SqliteProfile(), false, DBPartition::DAY);
+        sink.log(at(0, "a"));
+        sink.log(at(23 * 60 + 59, "b"));
+        sink.log(at(24 * 60, "c"));
+    }
+    EXPECT_EQ(2, committedRows(_dir + "log.20240701.db"));
+    EXPECT_EQ(1, committedRows(_dir + "log.20240702.db"));
+}
+
+// ---- 分钟汇总 -------------------------------------------------------
+static Xulog::LogMsg minuteMsg(Xulog::LogLevel::value level, const std::string &logger, int minute)
+{
+    Xulog::LogMsg msg(level, 1, "a.cc", logger, "m");
+    msg._ctime = 1719763200 + minute * 60 + 30;
+    msg._usec = 0;
+    return msg;
+}
+
+// 汇总与原始行在同一事务提交，计数一致；删除原始行时触发器扣减
+TEST_F(DataBaseSinkTest, RollupMatchesRows)
+{
+    for (size_t batch : {1, 7})
+    {
+        SetUp();
+        {
+            auto sink = std::make_shared<DataBaseSink>(_dbfile, "dbtest", batch, 60000);
+            for (int i = 0; i < 30; i++)
+                sink->log(minuteMsg(i % 3 ? Xulog::LogLevel::value::INFO : Xulog::LogLevel::value::WARN,
+                                    i % 2 ? "alpha" : "beta", i / 10));
+            EXPECT_EQ(30 / batch * batch, (size_t)queryInt(_dbfile, "SELECT COALESCE(SUM(count), 0) FROM log_rollup_minute"));
+        }
+        EXPECT_EQ(30, queryInt(_dbfile, "SELECT SUM(count) FROM log_rollup_minute"));
+        EXPECT_EQ(3, queryInt(_dbfile, "SELECT COUNT(DISTINCT minute) FROM log_rollup_minute"));
+        EXPECT_EQ(queryInt(_dbfile, "SELECT COUNT(*) FROM logs WHERE log_level='WARN' AND logger_name='beta'"),
+                  queryInt(_dbfile, "SELECT SUM(r.count) FROM log_rollup_minute r JOIN log_levels l ON l.id = r.level_ref "
+                                    "JOIN log_loggers g ON g.id = r.logger_ref WHERE l.name='WARN' AND g.name='beta'"));
+        EXPECT_EQ(28662720, queryInt(_dbfile, "SELECT MIN(minute) FROM log_rollup_minute"));
+    }
+    sqlite3 *db = nullptr;
+    sqlite3_open(_dbfile.c_str(), &db);
+    sqlite3_exec(db, "DELETE FROM log_records WHERE log_time < 1719763260000000", nullptr, nullptr, nullptr);
+    sqlite3_close(db);
+    EXPECT_EQ(20, queryInt(_dbfile, "SELECT SUM(count) FROM log_rollup_minute"));
+}
+
+// v3 库升级时由已有的行补齐汇总
+TEST_F(DataBaseSinkTest, MigratesV3BackfillsRollup)
+{
+    {
+        auto sink = std::make_shared<DataBaseSink>(_dbfile, "dbtest", 100, 60000);
+        for (int i = 0; i < 12; i++)
+            sink->log(minuteMsg(Xulog::LogLevel::value::INFO, "alpha", i / 4));
+    }
+    sqlite3 *db = nullptr;
+    sqlite3_open(_dbfile.c_str(), &db);
+    sqlite3_exec(db, "DROP TABLE log_rollup_minute; DROP TRIGGER log_rollup_ad; PRAGMA user_version=3;", nullptr, nullptr, nullptr);
+    sqlite3_close(db);
+
+    auto sink = std::make_shared<DataBaseSink>(_dbfile, "dbtest", 1, 0);
+    sink->log(minuteMsg(Xulog::LogLevel::value::INFO, "alpha", 2));
+    EXPECT_EQ(DataBaseSink::SCHEMA_VERSION, queryInt(_dbfile, "PRAGMA user_version"));
+    EXPECT_EQ(13, queryInt(_dbfile, "SELECT SUM(count) FROM log_rollup_minute"));
+    EXPECT_EQ(5, queryInt(_dbfile, "SELECT count FROM log_rollup_minute WHERE minute = 28662722"));
+}
@@ -128,6 +128,27 @@ TEST(FormatterTest, CombinedFormat)
     EXPECT_EQ("[WARN]\tbody\n", fmt.Format(msg));
 }
 
+// %p 区间 —— Format 记录等级在输出中的字节偏移，供彩色输出直接定位
+TEST(FormatterTest, LevelSpanRecorded)
+{
+    Formatter fmt("[%c][%p]%T%m%n");
+    auto msg = makeMsg(LogLevel::value::ERROR, "f.cc", 1, "lg", "ERROR in payload");
+    std::string out = fmt.Format(msg);
+    ASSERT_NE(std::string::npos, msg._level_pos);
+    EXPECT_EQ(5u, msg._level_pos);
+    EXPECT_EQ("ERROR", out.substr(msg._level_pos, msg._level_len));
+}
+
+// 无 %p 的格式串 —— 区间保持未知
+TEST(FormatterTest, LevelSpanAbsent)
+{
+    Formatter fmt("%m%n");
+    auto msg = makeMsg();
+    fmt.Format(msg);
+    EXPECT_EQ(std::string::npos, msg._level_pos);
+    EXPECT_EQ(0u, msg._level_len);
+}
+
 // getPattern 返回构造时传入的格式串
 TEST(FormatterTest, GetPattern)
 {
@@ -7,6 +7,8 @@
 #include <mutex>
 #include <sstream>
 #include <set>
+#include <fstream>
+#include <unistd.h>
 
 // ---- 收集型 Sink：线程安全地把每条 LogMsg 存起来 ----------------
 class CaptureSink : public Xulog::LogSink
@@ -145,3 +147,117 @@ TEST(SyncLoggerTest, ConcurrentMsgFieldsNotCorrupted)
             << "payload=" << msg._payload << " but line=" << msg._line;
     }
 }
+
+// 多线程：FileSink 走 O_APPEND 无锁写，验证行数完整且每行不被交叉截断
+TEST(SyncLoggerTest, ConcurrentFileSinkLockFreeAppend)
+{
+    constexpr int THREADS = 4;
+    constexpr int PER_THR = 1000;
+    const std::string path = "./test_log/concurrent_append.log";
+    ::unlink(path.c_str());
+
+    auto file_sink = std::make_shared<Xulog::FileSink>(path);
+    auto capture = std::make_shared<CaptureSink>();
+    EXPECT_TRUE(file_sink->threadSafe());
+    EXPECT_FALSE(capture->threadSafe());
+
+    auto formatter = std::make_shared<Xulog::Formatter>("%m%n");
+    std::vector<Xulog::LogSink::ptr> sinks{file_sink, capture};
+    auto logger = std::make_shared<Xulog::SyncLogger>("test_append", Xulog::LogLevel::value::DEBUG, formatter, sinks);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++)
+    {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < PER_THR; i++)
+                logger->info("f.cc", 1, "t%d-i%d-%s", t, i, std::string(64, 'x').c_str());
+        });
+    }
+    for (auto &th : threads) th.join();
+
+    ASSERT_EQ(THREADS * PER_THR, (int)capture->lines().size());
+
+    std::ifstream ifs(path);
+    std::set<std::string> seen;
+    std::string line;
+    int count = 0;
+    while (std::getline(ifs, line))
+    {
+        int t_val, i_val;
+        ASSERT_EQ(2, sscanf(line.c_str(), "t%d-i%d-", &t_val, &i_val)) << "corrupted: " << line;
+        EXPECT_EQ(std::string(64, 'x'), line.substr(line.rfind('-') + 1));
+        EXPECT_TRUE(seen.insert(line).second) << "duplicate: " << line;
+        count++;
+    }
+    EXPECT_EQ(THREADS * PER_THR, count);
+}
+
+// 每个 sink 独立格式：相同格式串共享渲染，不同格式串各自输出
+TEST(SyncLoggerTest, PerSinkFormatter)
+{
+    auto plain = std::make_shared<CaptureSink>();
+    auto same = std::make_shared<CaptureSink>();
+    auto compact = std::make_shared<CaptureSink>();
+    same->setFormatter(std::make_shared<Xulog::Formatter>("%p|%m"));
+    compact->setFormatter(std::make_shared<Xulog::Formatter>("%m"));
+
+    auto formatter = std::make_shared<Xulog::Formatter>("%p|%m");
+    std::vector<Xulog::LogSink::ptr> sinks{plain, same, compact};
+    Xulog::SyncLogger logger("test_per_sink_fmt", Xulog::LogLevel::value::DEBUG, formatter, sinks);
+
+    logger.warn("f.cc", 1, "hello");
+
+    ASSERT_EQ(1u, plain->lines().size());
+    ASSERT_EQ(1u, same->lines().size());
+    ASSERT_EQ(1u, compact->lines().size());
+    EXPECT_EQ("WARN|hello", plain->lines()[0]);
+    EXPECT_EQ("WARN|hello", same->lines()[0]);
+    EXPECT_EQ("hello", compact->lines()[0]);
+    // %p 区间跟随各自的格式
+    EXPECT_EQ(0u, plain->msgs()[0]._level_pos);
+    EXPECT_EQ(std::string::npos, compact->msgs()[0]._level_pos);
+}
+
+// 每个 sink 独立等级：低于 sink 门槛的日志不交给该 sink
+TEST(SyncLoggerTest, PerSinkLevel)
+{
+    auto all = std::make_shared<CaptureSink>();
+    auto errors = std::make_shared<CaptureSink>();
+    errors->setLevel(Xulog::LogLevel::value::ERROR);
+    errors->setFormatter(std::make_shared<Xulog::Formatter>("%m"));
+
+    auto formatter = std::make_shared<Xulog::Formatter>("%p|%m");
+    std::vector<Xulog::LogSink::ptr> sinks{all, errors};
+    Xulog::SyncLogger logger("test_per_sink_level", Xulog::LogLevel::value::DEBUG, formatter, sinks);
+
+    logger.info("f.cc", 1, "a");
+    logger.error("f.cc", 2, "b");
+
+    ASSERT_EQ(2u, all->lines().size());
+    ASSERT_EQ(1u, errors->lines().size());
+    EXPECT_EQ("b", errors->lines()[0]);
+}
+
+// 异步日志器：独立格式与等级同样生效
+TEST(AsyncLoggerTest, PerSinkFormatterAndLevel)
+{
+    auto plain = std::make_shared<CaptureSink>();
+    auto compact = std::make_shared<CaptureSink>();
+    compact->setFormatter(std::make_shared<Xulog::Formatter>("%m"));
+    compact->setLevel(Xulog::LogLevel::value::WARN);
+
+    auto formatter = std::make_shared<Xulog::Formatter>("%p|%m");
+    std::vector<Xulog::LogSink::ptr> sinks{plain, compact};
+    {
+        Xulog::AsyncLogger logger("test_async_per_sink", Xulog::LogLevel::value::DEBUG, formatter, sinks,
+                                  Xulog::AsyncType::ASYNC_SAFE);
+        logger.debug("f.cc", 1, "d");
+        logger.warn("f.cc", 2, "w");
+    } // 析构时消费者线程取完剩余日志
+
+    ASSERT_EQ(2u, plain->lines().size());
+    EXPECT_EQ("DEBUG|d", plain->lines()[0]);
+    EXPECT_EQ("WARN|w", plain->lines()[1]);
+    ASSERT_EQ(1u, compact->lines().size());
+    EXPECT_EQ("w", compact->lines()[0]);
+}
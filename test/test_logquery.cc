@@ -1,6 +1,7 @@
 // test_logquery.cc —— LogQuery 共享查询引擎测试（TDD）
 #include <gtest/gtest.h>
 #include "../tools/LogQuery.hpp"
+#include "../extend/DataBaseSink.hpp"
 #include <sqlite3.h>
 #include <jsoncpp/json/json.h>
 #include <set>
@@ -61,6 +62,41 @@ TEST_F(LogQueryTest, QueryFilterByTid)           { LogQuery::Params p; p.tid="0x
 
 TEST_F(LogQueryTest, QueryWithLimitAndOffset)    { LogQuery::Params p; p.limit=2; p.offset=1; auto r=LogQuery::queryLogs(_db,p); ASSERT_EQ(2u,r.size()); EXPECT_EQ(2,r[0]["id"].asInt()); EXPECT_EQ(3,r[1]["id"].asInt()); }
 
+// 游标翻页：向后沿 next_after_id 翻完全部行，只给 before_id 时取紧邻游标之前的行
+TEST_F(LogQueryTest, KeysetPagination)
+{
+    LogQuery::Params p;
+    p.limit = 2;
+    std::vector<int> seen;
+    for (int i = 0; i < 5; i++)
+    {
+        auto page = LogQuery::queryPage(_db, p);
+        for (auto &r : page["rows"])
+            seen.push_back(r["id"].asInt());
+        if (!page["has_more"].asBool())
+            break;
+        p.after_id = page["next_after_id"].asInt64();
+    }
+    EXPECT_EQ((std::vector<int>{1, 2, 3, 4, 5}), seen);
+
+    LogQuery::Params b;
+    b.limit = 2;
+    b.before_id = 4;
+    auto back = LogQuery::queryPage(_db, b);
+    ASSERT_EQ(2u, back["rows"].size());
+    EXPECT_EQ(2, back["rows"][0]["id"].asInt());
+    EXPECT_EQ(3, back["rows"][1]["id"].asInt());
+    EXPECT_TRUE(back["has_more"].asBool());
+    EXPECT_EQ(2, back["next_before_id"].asInt64());
+
+    b.level = "ERROR";
+    b.after_id = 1;
+    b.before_id = 5;
+    auto r = LogQuery::queryLogs(_db, b);
+    ASSERT_EQ(1u, r.size());
+    EXPECT_EQ(4, r[0]["id"].asInt());
+}
+
 TEST_F(LogQueryTest, QueryFilterByTimeRange)     { LogQuery::Params p; p.from_time="2024-07-01 00:01"; p.to_time="2024-07-01 00:05"; EXPECT_EQ(4u, LogQuery::queryLogs(_db,p).size()); }
 
 TEST_F(LogQueryTest, StatsByLevel)               { LogQuery::Params p; p.group_by="level"; auto r=LogQuery::logStats(_db,p); int t=0; for(auto& g:r["groups"]) t+=g["count"].asInt(); EXPECT_EQ(5,t); }
@@ -72,3 +108,378 @@ TEST_F(LogQueryTest, ListLoggers)                { auto r=LogQuery::listLoggers(
 TEST_F(LogQueryTest, EmptyDatabase)              { sqlite3* e; sqlite3_open(":memory:",&e); sqlite3_exec(e,"CREATE TABLE logs (id INTEGER PRIMARY KEY, log_time TIMESTAMP, line_number INT, thread_id VARCHAR, log_level VARCHAR, source_file VARCHAR, logger_name VARCHAR, message TEXT)",0,0,0); EXPECT_EQ(0u,LogQuery::queryLogs(e,{}).size()); sqlite3_close(e); }
 
 TEST_F(LogQueryTest, NoMatchingResults)          { LogQuery::Params p; p.level="FATAL"; EXPECT_EQ(0u, LogQuery::queryLogs(_db,p).size()); }
+
+// ---- v2 表结构：UTC 纪元微秒 + 索引 ------------------------------
+class LogQueryV2Test : public ::testing::Test
+{
+protected:
+    sqlite3 *_db = nullptr;
+
+    void SetUp() override
+    {
+        setenv("TZ", "CST-8", 1); // 固定 UTC+8，与 v1 夹具中的时间对应
+        tzset();
+        sqlite3_open(":memory:", &_db);
+        const char *sql =
+            "CREATE TABLE logs ("
+            "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+            "log_time INTEGER NOT NULL,"
+            "line_number INT,"
+            "thread_id VARCHAR(255),"
+            "log_level VARCHAR(10) NOT NULL,"
+            "source_file VARCHAR(255),"
+            "logger_name VARCHAR(255),"
+            "message TEXT);"
+            "CREATE INDEX idx_logs_time ON logs(log_time);"
+            "CREATE INDEX idx_logs_level_time ON logs(log_level, log_time);"
+            "CREATE INDEX idx_logs_logger_time ON logs(logger_name, log_time);"
+            "PRAGMA user_version=2;";
+        sqlite3_exec(_db, sql, nullptr, nullptr, nullptr);
+
+        const char *inserts[] = {
+            "INSERT INTO logs VALUES(1,1719763200123456,10,'0xAAA','ERROR','a.cc','root','timeout connecting to db')",
+            "INSERT INTO logs VALUES(2,1719763260000000,20,'0xBBB','WARN','b.cc','worker','slow query detected')",
+            "INSERT INTO logs VALUES(3,1719763320000000,30,'0xAAA','INFO','a.cc','root','request completed in 42ms')",
+            "INSERT INTO logs VALUES(4,1719763380000000,40,'0xCCC','ERROR','c.cc','server','connection timeout')",
+            "INSERT INTO logs VALUES(5,1719763500999999,50,'0xAAA','DEBUG','a.cc','root','entering function foo')",
+        };
+        for (auto &s : inserts)
+            sqlite3_exec(_db, s, nullptr, nullptr, nullptr);
+    }
+
+    void TearDown() override { sqlite3_close(_db); }
+};
+
+TEST_F(LogQueryV2Test, DetectsSchemaVersion)        { EXPECT_EQ(2, LogQuery::schemaVersion(_db)); }
+
+TEST_F(LogQueryV2Test, LogTimeRenderedLocalWithMillis)
+{
+    auto r = LogQuery::queryLogs(_db, {});
+    ASSERT_EQ(5u, r.size());
+    EXPECT_EQ("2024-07-01 00:00:00.123", r[0]["log_time"].asString());
+    EXPECT_EQ(1719763200123456LL, r[0]["log_time_us"].asInt64());
+}
+
+// 上界精确到秒时包含该秒内的全部记录
+TEST_F(LogQueryV2Test, TimeRangeInclusiveToSecond)
+{
+    LogQuery::Params p; p.from_time = "2024-07-01 00:01"; p.to_time = "2024-07-01 00:05";
+    auto r = LogQuery::queryLogs(_db, p);
+    ASSERT_EQ(4u, r.size());
+    EXPECT_EQ(2, r[0]["id"].asInt());
+    EXPECT_EQ(5, r[3]["id"].asInt());
+}
+
+TEST_F(LogQueryV2Test, LevelAndTimeCombined)
+{
+    LogQuery::Params p; p.level = "ERROR"; p.from_time = "2024-07-01 00:00:01";
+    auto r = LogQuery::queryLogs(_db, p);
+    ASSERT_EQ(1u, r.size());
+    EXPECT_EQ(4, r[0]["id"].asInt());
+}
+
+TEST_F(LogQueryV2Test, StatsByHourLocal)
+{
+    LogQuery::Params p; p.group_by = "hour";
+    auto r = LogQuery::logStats(_db, p);
+    ASSERT_EQ(1u, r["groups"].size());
+    EXPECT_EQ("2024-07-01 00:00", r["groups"][0]["group"].asString());
+    EXPECT_EQ(5, r["total"].asInt());
+}
+
+// 等级 + 时间过滤走复合索引而不是全表扫描
+TEST_F(LogQueryV2Test, LevelTimeFilterUsesIndex)
+{
+    sqlite3_stmt *stmt = nullptr;
+    ASSERT_EQ(SQLITE_OK, sqlite3_prepare_v2(_db,
+        "EXPLAIN QUERY PLAN SELECT id FROM logs WHERE log_level IN ('ERROR') AND log_time >= 1 AND log_time < 2",
+        -1, &stmt, nullptr));
+    std::string plan;
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+        plan += (const char *)sqlite3_column_text(stmt, 3);
+    sqlite3_finalize(stmt);
+    EXPECT_NE(std::string::npos, plan.find("idx_logs_level_time")) << plan;
+}
+
+// ---- FTS5 全文索引 -------------------------------------------------
+class LogQueryFtsTest : public LogQueryV2Test
+{
+protected:
+    void SetUp() override
+    {
+        LogQueryV2Test::SetUp();
+        sqlite3_exec(_db,
+                     "CREATE VIRTUAL TABLE logs_fts USING fts5(message, content='logs', content_rowid='id');"
+                     "CREATE TRIGGER logs_fts_ai AFTER INSERT ON logs BEGIN "
+                     "INSERT INTO logs_fts(rowid, message) VALUES (new.id, new.message); END;"
+                     "INSERT INTO logs_fts(logs_fts) VALUES ('rebuild');"
+                     "INSERT INTO logs VALUES(6,1719763560000000,60,'0xDDD','INFO','d.cc','test','it''s a test');"
+                     "INSERT INTO logs VALUES(7,1719763620000000,70,'0xDDD','WARN','d.cc','test','数据库连接超时');",
+                     nullptr, nullptr, nullptr);
+    }
+    std::vector<int> ids(const std::string &keyword)
+    {
+        LogQuery::Params p; p.keyword = keyword;
+        std::vector<int> v;
+        for (auto &r : LogQuery::queryLogs(_db, p))
+            v.push_back(r["id"].asInt());
+        return v;
+    }
+};
+
+TEST_F(LogQueryFtsTest, DetectsFullText)     { EXPECT_TRUE(LogQuery::hasFullText(_db)); }
+TEST_F(LogQueryFtsTest, WordMatch)           { EXPECT_EQ((std::vector<int>{1, 4}), ids("timeout")); }
+TEST_F(LogQueryFtsTest, WordsAreAnded)       { EXPECT_EQ((std::vector<int>{4}), ids("timeout connection")); }
+TEST_F(LogQueryFtsTest, PrefixMatch)         { EXPECT_EQ((std::vector<int>{1, 4}), ids("time*")); EXPECT_EQ((std::vector<int>{1}), ids("conn* db")); }
+TEST_F(LogQueryFtsTest, PhraseMatch)         { EXPECT_EQ((std::vector<int>{2}), ids("\"slow query\"")); EXPECT_TRUE(ids("\"query slow\"").empty()); }
+TEST_F(LogQueryFtsTest, ApostropheWord)      { EXPECT_EQ((std::vector<int>{6}), ids("it's")); }
+TEST_F(LogQueryFtsTest, SyntaxCharsAreLiteral){ EXPECT_TRUE(ids("timeout OR -foo:bar").empty()); }
+TEST_F(LogQueryFtsTest, NonAsciiFallsBackToLike) { EXPECT_EQ((std::vector<int>{7}), ids("连接")); }
+TEST_F(LogQueryFtsTest, NoTokensFallsBackToLike) { EXPECT_EQ((std::vector<int>{6}), ids("'")); }
+
+// ---- v3 字典编码：由 DataBaseSink 真实写入，查询经视图透明连接回名称 --------
+class LogQueryV3Test : public ::testing::Test
+{
+protected:
+    sqlite3 *_db = nullptr;
+    std::string _dbfile = "./test_data/logquery_v3.db";
+
+    void SetUp() override
+    {
+        Xulog::Util::File::createDirectory("./test_data");
+        for (const char *suffix : {"", "-wal", "-shm"})
+            unlink((_dbfile + suffix).c_str());
+        {
+            DataBaseSink sink(_dbfile, "v3", 100, 60000, SqliteProfile(), true);
+            sink.log(Xulog::LogMsg(Xulog::LogLevel::value::INFO, 10, "a.cc", "root", "request completed"));
+            sink.log(Xulog::LogMsg(Xulog::LogLevel::value::WARN, 20, "b.cc", "worker", "slow query detected"));
+            sink.log(Xulog::LogMsg(Xulog::LogLevel::value::INFO, 30, "a.cc", "root", "connection timeout"));
+        }
+        sqlite3_open(_dbfile.c_str(), &_db);
+    }
+    void TearDown() override { sqlite3_close(_db); }
+};
+
+TEST_F(LogQueryV3Test, DetectsSchemaVersion) { EXPECT_EQ(DataBaseSink::SCHEMA_VERSION, LogQuery::schemaVersion(_db)); }
+
+TEST_F(LogQueryV3Test, FiltersResolveNames)
+{
+    LogQuery::Params p;
+    p.level = "INFO";
+    p.logger = "root";
+    auto r = LogQuery::queryLogs(_db, p);
+    ASSERT_EQ(2u, r.size());
+    EXPECT_EQ("a.cc", r[0]["source_file"].asString());
+    EXPECT_EQ("INFO", r[1]["log_level"].asString());
+    EXPECT_EQ(30, r[1]["line_number"].asInt());
+
+    LogQuery::Params k;
+    k.keyword = "timeout";
+    r = LogQuery::queryLogs(_db, k);
+    ASSERT_EQ(1u, r.size());
+    EXPECT_EQ(3, r[0]["id"].asInt());
+}
+
+TEST_F(LogQueryV3Test, StatsAndLoggers)
+{
+    LogQuery::Params p;
+    p.group_by = "logger";
+    EXPECT_EQ(3, LogQuery::logStats(_db, p)["total"].asInt());
+    auto loggers = LogQuery::listLoggers(_db);
+    ASSERT_EQ(2u, loggers.size());
+    EXPECT_EQ("root", loggers[0].asString());
+    EXPECT_EQ("worker", loggers[1].asString());
+}
+
+// 等级过滤先在维度表中找到 id，再走事实表的复合索引
+TEST_F(LogQueryV3Test, LevelFilterUsesIndex)
+{
+    sqlite3_stmt *stmt = nullptr;
+    ASSERT_EQ(SQLITE_OK, sqlite3_prepare_v2(_db,
+        "EXPLAIN QUERY PLAN SELECT id FROM logs WHERE log_level IN ('ERROR') AND log_time >= 1 AND log_time < 2",
+        -1, &stmt, nullptr));
+    std::string plan;
+    while (sqlite3_step(stmt) == SQLITE_ROW)
+        plan += (const char *)sqlite3_column_text(stmt, 3);
+    sqlite3_finalize(stmt);
+    EXPECT_NE(std::string::npos, plan.find("idx_records_level_time")) << plan;
+}
+
+// ---- 分区清单：裁剪分区后并行查询再按 id 合并 ------------------------
+class LogQueryPartitionTest : public ::testing::Test
+{
+protected:
+    sqlite3 *_db = nullptr;
+    std::string _dir = "./test_data/logquery_part/";
+
+    void SetUp() override
+    {
+        setenv("TZ", "CST-8", 1);
+        tzset();
+        system(("rm -rf " + _dir).c_str());
+        {
+            // 2024-07-01 00:00 (+08:00) 起的 4 个小时，每小时 3 条
+            DataBaseSink sink(_dir + "log.db", "part", 100, 60000, SqliteProfile(), false, DBPartition::HOUR);
+            const char *loggers[] = {"root", "worker", "root"};
+            for (int h = 0; h < 4; h++)
+                for (int i = 0; i < 3; i++)
+                {
+                    Xulog::LogMsg msg(i == 1 ? Xulog::LogLevel::value::ERROR : Xulog::LogLevel::value::INFO, i,
+                                      "a.cc", loggers[i], "hour " + std::to_string(h) + " row " + std::to_string(i));
+                    msg._ctime = 1719763200 + h * 3600 + i * 60;
+                    msg._usec = 0;
+                    sink.log(msg);
+                }
+        }
+        LogQuery::openReadOnly(_dir + "log.db", &_db);
+    }
+    void TearDown() override { sqlite3_close(_db); }
+};
+
+TEST_F(LogQueryPartitionTest, DetectsManifest)
+{
+    EXPECT_TRUE(LogQuery::isPartitioned(_db));
+    EXPECT_EQ(4u, LogQuery::partitions(_db).size());
+}
+
+TEST_F(LogQueryPartitionTest, MergesInIdOrderWithLimitOffset)
+{
+    LogQuery::Params p;
+    auto all = LogQuery::queryLogs(_db, p);
+    ASSERT_EQ(12u, all.size());
+    for (Json::ArrayIndex i = 1; i < all.size(); i++)
+        EXPECT_LT(all[i - 1]["id"].asInt64(), all[i]["id"].asInt64());
+
+    p.limit = 4;
+    p.offset = 2;
+    auto page = LogQuery::queryLogs(_db, p);
+    ASSERT_EQ(4u, page.size());
+    EXPECT_EQ("hour 0 row 2", page[0]["message"].asString());
+    EXPECT_EQ("hour 1 row 2", page[3]["message"].asString());
+}
+
+// 游标跨分区翻页：每页与按 id 全量排序后的对应切片一致
+TEST_F(LogQueryPartitionTest, CursorPagesAcrossPartitions)
+{
+    auto all = LogQuery::queryLogs(_db, {});
+    ASSERT_EQ(12u, all.size());
+
+    LogQuery::Params p;
+    p.limit = 5;
+    std::vector<long long> forward;
+    for (int i = 0; i < 4; i++)
+    {
+        auto page = LogQuery::queryPage(_db, p);
+        for (auto &r : page["rows"])
+            forward.push_back(r["id"].asInt64());
+        if (!page["has_more"].asBool())
+            break;
+        p.after_id = page["next_after_id"].asInt64();
+    }
+    ASSERT_EQ(12u, forward.size());
+    for (Json::ArrayIndex i = 0; i < all.size(); i++)
+        EXPECT_EQ(all[i]["id"].asInt64(), forward[i]);
+
+    LogQuery::Params b;
+    b.limit = 4;
+    b.before_id = all[7]["id"].asInt64();
+    auto back = LogQuery::queryPage(_db, b);
+    ASSERT_EQ(4u, back["rows"].size());
+    EXPECT_EQ("hour 1 row 0", back["rows"][0]["message"].asString());
+    EXPECT_EQ("hour 2 row 0", back["rows"][3]["message"].asString());
+    EXPECT_TRUE(back["has_more"].asBool());
+}
+
+// 流式检索：逐行回调与一次性结果一致，回调返回 false 时立即停止
+TEST_F(LogQueryPartitionTest, StreamsRowsAcrossPartitions)
+{
+    auto all = LogQuery::queryLogs(_db, {});
+    ASSERT_EQ(12u, all.size());
+
+    std::vector<long long> ids;
+    LogQuery::Params p;
+    p.limit = -1;
+    EXPECT_EQ(12u, LogQuery::forEachLog(_db, p, [&](const Json::Value &row)
+                                        { ids.push_back(row["id"].asInt64()); return true; }));
+    ASSERT_EQ(12u, ids.size());
+    for (Json::ArrayIndex i = 0; i < all.size(); i++)
+        EXPECT_EQ(all[i]["id"].asInt64(), ids[i]);
+
+    size_t seen = 0;
+    EXPECT_EQ(3u, LogQuery::forEachLog(_db, p, [&](const Json::Value &)
+                                       { return ++seen < 3; }));
+
+    // 向前翻页跨分区跳过最靠近游标的 offset 行
+    ids.clear();
+    p.limit = 4;
+    p.offset = 2;
+    p.before_id = all[7]["id"].asInt64();
+    LogQuery::forEachLog(_db, p, [&](const Json::Value &row)
+                         { ids.push_back(row["id"].asInt64()); return true; });
+    ASSERT_EQ(4u, ids.size());
+    for (size_t i = 0; i < 4; i++)
+        EXPECT_EQ(all[(Json::ArrayIndex)(i + 1)]["id"].asInt64(), ids[i]);
+}
+
+// 时间范围裁剪：只查询相交的分区，结果与单库语义一致
+TEST_F(LogQueryPartitionTest, PrunesByTimeRange)
+{
+    LogQuery::Params p;
+    p.from_time = "2024-07-01 01:01";
+    p.to_time = "2024-07-01 02:00";
+    EXPECT_EQ(2u, LogQuery::partitions(_db, 1719766860LL * 1000000, 1719770401LL * 1000000).size());
+    auto r = LogQuery::queryLogs(_db, p);
+    ASSERT_EQ(3u, r.size());
+    EXPECT_EQ("hour 1 row 1", r[0]["message"].asString());
+    EXPECT_EQ("hour 2 row 0", r[2]["message"].asString());
+
+    p.level = "ERROR";
+    EXPECT_EQ(1u, LogQuery::queryLogs(_db, p).size());
+}
+
+TEST_F(LogQueryPartitionTest, StatsAndLoggersAcrossPartitions)
+{
+    LogQuery::Params p;
+    p.group_by = "level";
+    auto stats = LogQuery::logStats(_db, p);
+    EXPECT_EQ(12, stats["total"].asInt());
+    EXPECT_EQ("INFO", stats["groups"][0]["group"].asString());
+    EXPECT_EQ(8, stats["groups"][0]["count"].asInt());
+    auto loggers = LogQuery::listLoggers(_db);
+    ASSERT_EQ(2u, loggers.size());
+    EXPECT_EQ("root", loggers[0].asString());
+}
+
+TEST_F(LogQueryPartitionTest, TailCrossesPartitions)
+{
+    long long last = LogQuery::maxId(_db);
+    EXPECT_EQ(1719763200LL * 1000000 + 3 * 3600000000LL + 3, last);
+    auto all = LogQuery::queryLogs(_db, LogQuery::Params());
+    auto tail = LogQuery::tailLogs(_db, all[1]["id"].asInt64(), 5);
+    ASSERT_EQ(5u, tail.size());
+    EXPECT_EQ(all[2]["id"].asInt64(), tail[0]["id"].asInt64());
+    EXPECT_EQ("hour 2 row 0", tail[4]["message"].asString());
+    EXPECT_TRUE(LogQuery::tailLogs(_db, last, 5).empty());
+}
+
+// v4 统计读分钟汇总表，结果与扫描原始行一致
+TEST_F(LogQueryV3Test, StatsReadRollup)
+{
+    for (const char *group : {"level", "logger", "hour"})
+    {
+        LogQuery::Params p;
+        p.group_by = group;
+        EXPECT_EQ(3, LogQuery::logStats(_db, p)["total"].asInt()) << group;
+    }
+    LogQuery::Params p;
+    p.group_by = "level";
+    auto r = LogQuery::logStats(_db, p);
+    ASSERT_EQ(2u, r["groups"].size());
+    EXPECT_EQ("INFO", r["groups"][0]["group"].asString());
+    EXPECT_EQ(2, r["groups"][0]["count"].asInt());
+
+    // 只改汇总表，统计随之变化，说明没有扫描原始行
+    sqlite3_exec(_db, "UPDATE log_rollup_minute SET count = count + 100 "
+                      "WHERE level_ref = (SELECT id FROM log_levels WHERE name = 'WARN')", nullptr, nullptr, nullptr);
+    EXPECT_EQ(103, LogQuery::logStats(_db, p)["total"].asInt());
+}
@@ -0,0 +1,179 @@
+// test_ratelimit_sink.cc —— RateLimitSink 限流去重：突发上限、模板归一化、窗口汇总、定时汇总、汇总格式、调用点隔离
+#include <gtest/gtest.h>
+#include "../extend/RateLimitSink.hpp"
+#include <thread>
+#include <vector>
+#include <mutex>
+
+// ---- 收集型 Sink：记录转发内容 ----------------------------------
+class RateCapture : public Xulog::LogSink
+{
+public:
+    void log(const char *data, size_t len, const Xulog::LogMsg &msg) override
+    {
+        std::lock_guard<std::mutex> lk(_mu);
+        _payloads.push_back(msg._payload);
+        _lines.emplace_back(data, len);
+    }
+    void log(const char *data, size_t len) override {}
+    std::vector<std::string> payloads()
+    {
+        std::lock_guard<std::mutex> lk(_mu);
+        return _payloads;
+    }
+    std::vector<std::string> lines()
+    {
+        std::lock_guard<std::mutex> lk(_mu);
+        return _lines;
+    }
+
+private:
+    std::mutex _mu;
+    std::vector<std::string> _payloads;
+    std::vector<std::string> _lines;
+};
+
+static Xulog::Formatter::ptr g_formatter = std::make_shared<Xulog::Formatter>("%m");
+
+static Xulog::Logger::ptr makeLogger(const std::string &name, const Xulog::LogSink::ptr &sink,
+                                     Xulog::Formatter::ptr formatter = g_formatter)
+{
+    std::vector<Xulog::LogSink::ptr> sinks{sink};
+    return std::make_shared<Xulog::SyncLogger>(name, Xulog::LogLevel::value::DEBUG, formatter, sinks);
+}
+
+// 同一调用点超过突发上限后被抑制，flush 输出重复计数
+TEST(RateLimitSinkTest, SuppressesRepeatsAboveBurst)
+{
+    auto target = std::make_shared<RateCapture>();
+    auto limiter = std::make_shared<RateLimitSink>(target, g_formatter, 3, 60000);
+    auto logger = makeLogger("rate_burst", limiter);
+
+    for (int i = 0; i < 100; i++)
+        error(logger, "db down");
+    EXPECT_EQ(3u, target->payloads().size());
+
+    limiter->flush();
+    auto p = target->payloads();
+    ASSERT_EQ(4u, p.size());
+    EXPECT_EQ("last message repeated 97 times", p[3]);
+}
+
+// 只有数字不同的正文视为同一模板
+TEST(RateLimitSinkTest, NumbersNormalizedIntoSameKey)
+{
+    auto target = std::make_shared<RateCapture>();
+    auto limiter = std::make_shared<RateLimitSink>(target, g_formatter, 1, 60000);
+    auto logger = makeLogger("rate_template", limiter);
+
+    for (int i = 0; i < 10; i++)
+        warn(logger, "timeout after %d ms on fd %d", i * 7, i + 3);
+    auto p = target->payloads();
+    ASSERT_EQ(1u, p.size());
+    EXPECT_EQ("timeout after 0 ms on fd 3", p[0]);
+}
+
+// 不同调用点互不影响
+TEST(RateLimitSinkTest, DistinctCallSitesIndependent)
+{
+    auto target = std::make_shared<RateCapture>();
+    auto limiter = std::make_shared<RateLimitSink>(target, g_formatter, 2, 60000);
+    auto logger = makeLogger("rate_sites", limiter);
+
+    for (int i = 0; i < 5; i++)
+    {
+        info(logger, "same text");
+        info(logger, "same text");
+    }
+    EXPECT_EQ(4u, target->payloads().size());
+}
+
+// 窗口结束后先输出上一窗口的汇总，再放行新日志
+TEST(RateLimitSinkTest, WindowRolloverEmitsSummary)
+{
+    auto target = std::make_shared<RateCapture>();
+    auto limiter = std::make_shared<RateLimitSink>(target, g_formatter, 2, 50);
+    auto logger = makeLogger("rate_window", limiter);
+
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 10; j++)
+            error(logger, "flap");
+        std::this_thread::sleep_for(std::chrono::milliseconds(80));
+    }
+    limiter->flush();
+    auto p = target->payloads();
+    ASSERT_EQ(9u, p.size());
+    for (int i = 0; i < 3; i++)
+    {
+        EXPECT_EQ("flap", p[i * 3]);
+        EXPECT_EQ("flap", p[i * 3 + 1]);
+        EXPECT_EQ("last message repeated 8 times", p[i * 3 + 2]);
+    }
+}
+
+// 多线程同时刷同一调用点，放行数严格等于上限，汇总计数与抑制数一致
+TEST(RateLimitSinkTest, ConcurrentCountsExact)
+{
+    auto target = std::make_shared<RateCapture>();
+    auto limiter = std::make_shared<RateLimitSink>(target, g_formatter, 5, 60000);
+    auto logger = makeLogger("rate_concurrent", limiter);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+        threads.emplace_back([&logger]
+                             { for (int i = 0; i < 1000; i++) error(logger, "hot path"); });
+    for (auto &th : threads)
+        th.join();
+    EXPECT_EQ(5u, target->payloads().size());
+    limiter->flush();
+    auto p = target->payloads();
+    ASSERT_EQ(6u, p.size());
+    EXPECT_EQ("last message repeated 3995 times", p[5]);
+}
+
+// 重复风暴停止后不再有日志到来，汇总仍由后台线程按周期输出
+TEST(RateLimitSinkTest, SummaryEmittedAfterStormStops)
+{
+    auto target = std::make_shared<RateCapture>();
+    auto limiter = std::make_shared<RateLimitSink>(target, g_formatter, 2, 50);
+    auto logger = makeLogger("rate_quiet", limiter);
+
+    for (int i = 0; i < 10; i++)
+        error(logger, "upstream gone");
+    EXPECT_EQ(2u, target->payloads().size());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    auto p = target->payloads();
+    ASSERT_EQ(3u, p.size());
+    EXPECT_EQ("last message repeated 8 times", p[2]);
+}
+
+// 汇总行与被替代的日志同格式：默认用日志器格式，sink 设置独立格式时用独立格式
+TEST(RateLimitSinkTest, SummaryUsesLoggerFormat)
+{
+    auto formatter = std::make_shared<Xulog::Formatter>("[%p][%c] %m%n");
+    auto target = std::make_shared<RateCapture>();
+    auto limiter = std::make_shared<RateLimitSink>(target, formatter, 1, 60000);
+    auto logger = makeLogger("rate_format", limiter, formatter);
+
+    for (int i = 0; i < 5; i++)
+        error(logger, "disk full");
+    limiter->flush();
+    auto l = target->lines();
+    ASSERT_EQ(2u, l.size());
+    EXPECT_EQ("[ERROR][rate_format] disk full\n", l[0]);
+    EXPECT_EQ("[ERROR][rate_format] last message repeated 4 times\n", l[1]);
+
+    auto own = std::make_shared<RateCapture>();
+    auto own_limiter = std::make_shared<RateLimitSink>(own, formatter, 1, 60000);
+    own_limiter->setFormatter(std::make_shared<Xulog::Formatter>("%p|%m%n"));
+    auto own_logger = makeLogger("rate_own_format", own_limiter, formatter);
+    for (int i = 0; i < 3; i++)
+        warn(own_logger, "slow query");
+    own_limiter->flush();
+    l = own->lines();
+    ASSERT_EQ(2u, l.size());
+    EXPECT_EQ("WARN|slow query\n", l[0]);
+    EXPECT_EQ("WARN|last message repeated 2 times\n", l[1]);
+}
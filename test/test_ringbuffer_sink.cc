@@ -0,0 +1,170 @@
+// test_ringbuffer_sink.cc —— RingBufferSink 飞行记录仪：环形覆盖、触发导出、并发写入完整性、写入期间导出不漏记录
+#include <gtest/gtest.h>
+#include "../extend/RingBufferSink.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <mutex>
+#include <set>
+#include <csignal>
+
+// ---- 收集型 Sink：记录导出内容 ----------------------------------
+class DumpCapture : public Xulog::LogSink
+{
+public:
+    void log(const char *data, size_t len) override
+    {
+        std::lock_guard<std::mutex> lk(_mu);
+        _lines.emplace_back(data, len);
+    }
+    std::vector<std::string> lines()
+    {
+        std::lock_guard<std::mutex> lk(_mu);
+        return _lines;
+    }
+
+private:
+    std::mutex _mu;
+    std::vector<std::string> _lines;
+};
+
+static Xulog::Logger::ptr makeLogger(const std::string &name, const Xulog::LogSink::ptr &sink)
+{
+    auto formatter = std::make_shared<Xulog::Formatter>("%p|%m");
+    std::vector<Xulog::LogSink::ptr> sinks{sink};
+    return std::make_shared<Xulog::SyncLogger>(name, Xulog::LogLevel::value::DEBUG, formatter, sinks);
+}
+
+// 低于触发等级只进内存，ERROR 时连同之前的上下文一起按顺序导出
+TEST(RingBufferSinkTest, ErrorTriggersDumpWithContext)
+{
+    auto target = std::make_shared<DumpCapture>();
+    auto ring = std::make_shared<RingBufferSink>(64 * 1024, target);
+    auto logger = makeLogger("ring_trigger", ring);
+
+    debug(logger, "d1");
+    info(logger, "i2");
+    EXPECT_TRUE(target->lines().empty());
+
+    error(logger, "e3");
+    auto lines = target->lines();
+    ASSERT_EQ(3u, lines.size());
+    EXPECT_EQ("DEBUG|d1", lines[0]);
+    EXPECT_EQ("INFO|i2", lines[1]);
+    EXPECT_EQ("ERROR|e3", lines[2]);
+
+    // 已导出的记录不会重复导出
+    error(logger, "e4");
+    lines = target->lines();
+    ASSERT_EQ(4u, lines.size());
+    EXPECT_EQ("ERROR|e4", lines[3]);
+}
+
+// 写满后旧记录被覆盖，导出的是最近的一段且连续有序
+TEST(RingBufferSinkTest, OverwritesOldestKeepsNewest)
+{
+    auto target = std::make_shared<DumpCapture>();
+    auto ring = std::make_shared<RingBufferSink>(4096, target, Xulog::LogLevel::value::OFF);
+    auto logger = makeLogger("ring_wrap", ring);
+
+    for (int i = 0; i < 1000; i++)
+        debug(logger, "msg-%04d", i);
+    size_t n = ring->dump();
+
+    auto lines = target->lines();
+    ASSERT_EQ(n, lines.size());
+    ASSERT_GT(lines.size(), 10u);
+    ASSERT_LT(lines.size(), 1000u);
+    EXPECT_EQ("DEBUG|msg-0999", lines.back());
+    int first = std::stoi(lines.front().substr(lines.front().size() - 4));
+    for (size_t i = 0; i < lines.size(); i++)
+        EXPECT_EQ(first + (int)i, std::stoi(lines[i].substr(lines[i].size() - 4)));
+}
+
+// 多线程无锁并发写入：导出的每条记录都完整，且不重复
+TEST(RingBufferSinkTest, ConcurrentWritersRecordsIntact)
+{
+    constexpr int THREADS = 4;
+    constexpr int PER_THR = 2000;
+    auto target = std::make_shared<DumpCapture>();
+    auto ring = std::make_shared<RingBufferSink>(1024 * 1024, target, Xulog::LogLevel::value::OFF);
+    EXPECT_TRUE(ring->threadSafe());
+    auto logger = makeLogger("ring_concurrent", ring);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++)
+    {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < PER_THR; i++)
+                info(logger, "t%d-i%d-%s", t, i, std::string(40, 'x').c_str());
+        });
+    }
+    for (auto &th : threads) th.join();
+    ring->dump();
+
+    std::set<std::string> seen;
+    for (auto &line : target->lines())
+    {
+        int t_val, i_val;
+        ASSERT_EQ(2, sscanf(line.c_str(), "INFO|t%d-i%d-", &t_val, &i_val)) << "corrupted: " << line;
+        EXPECT_EQ(std::string(40, 'x'), line.substr(line.rfind('-') + 1));
+        EXPECT_TRUE(seen.insert(line).second) << "duplicate: " << line;
+    }
+    EXPECT_EQ(THREADS * PER_THR, (int)seen.size());
+}
+
+// 写入与导出并发：导出时正在写入的记录留给下一次导出，全部导出结束后每条恰好出现一次且各线程内有序
+TEST(RingBufferSinkTest, DumpDuringConcurrentWrites)
+{
+    constexpr int THREADS = 4;
+    constexpr int PER_THR = 5000;
+    auto target = std::make_shared<DumpCapture>();
+    auto ring = std::make_shared<RingBufferSink>(4 * 1024 * 1024, target, Xulog::LogLevel::value::OFF);
+    auto logger = makeLogger("ring_dump_concurrent", ring);
+
+    std::atomic<int> running{THREADS};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++)
+    {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < PER_THR; i++)
+                info(logger, "t%d-i%d", t, i);
+            running.fetch_sub(1);
+        });
+    }
+    while (running.load() > 0)
+        ring->dump();
+    for (auto &th : threads) th.join();
+    ring->dump();
+
+    std::set<std::string> seen;
+    std::vector<int> next(THREADS, 0);
+    for (auto &line : target->lines())
+    {
+        int t_val, i_val;
+        ASSERT_EQ(2, sscanf(line.c_str(), "INFO|t%d-i%d", &t_val, &i_val)) << "corrupted: " << line;
+        EXPECT_TRUE(seen.insert(line).second) << "duplicate: " << line;
+        EXPECT_LE(next[t_val], i_val) << line;
+        next[t_val] = i_val + 1;
+    }
+    EXPECT_EQ(THREADS * PER_THR, (int)seen.size());
+}
+
+// 信号只做标记，下一条日志到来时导出
+TEST(RingBufferSinkTest, SignalRequestsDump)
+{
+    auto target = std::make_shared<DumpCapture>();
+    auto ring = std::make_shared<RingBufferSink>(64 * 1024, target, Xulog::LogLevel::value::OFF);
+    auto logger = makeLogger("ring_signal", ring);
+    RingBufferSink::dumpOnSignal(SIGUSR1);
+
+    debug(logger, "before");
+    EXPECT_TRUE(target->lines().empty());
+    std::raise(SIGUSR1);
+    debug(logger, "after");
+
+    auto lines = target->lines();
+    ASSERT_EQ(2u, lines.size());
+    EXPECT_EQ("DEBUG|before", lines[0]);
+    EXPECT_EQ("DEBUG|after", lines[1]);
+}
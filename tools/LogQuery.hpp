@@ -2,6 +2,7 @@
 //
 // CLI 和 MCP 服务端共用的查询逻辑。
 // 所有用户可控值走 sqlite3 参数绑定，不拼字符串。
+// 传入的库是 DataBaseSink 的分区清单时，按时间范围裁剪分区后在多个线程中并行查询再合并。
 #pragma once
 
 #include <sqlite3.h>
@@ -10,6 +11,15 @@
 #include <vector>
 #include <sstream>
 #include <set>
+#include <cstdio>
+#include <cctype>
+#include <ctime>
+#include <climits>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <thread>
 
 namespace LogQuery
 {
@@ -18,11 +28,13 @@ namespace LogQuery
         std::string level;     // 逗号分隔多等级 "ERROR,WARN"
         std::string from_time; // "YYYY-MM-DD HH:MM"
         std::string to_time;   // "YYYY-MM-DD HH:MM"
-        std::string keyword;   // 全文搜索（LIKE %keyword%）
+        std::string keyword;   // 全文搜索：有 logs_fts 时走 FTS5 MATCH（支持 "短语" 与 前缀*），否则 LIKE %keyword%
         std::string logger;    // 日志器名称
         std::string tid;       // 线程 ID
         int limit = 1000;      // 默认上限，避免返回巨量数据
-        int offset = 0;
+        int offset = 0;        // 仅为兼容保留：深翻页时 OFFSET 要先扫过被跳过的行，应改用游标
+        long long after_id = 0;  // 游标：只返回 id > after_id 的行（0 为不限）
+        long long before_id = 0; // 游标：只返回 id < before_id 的行（0 为不限）；仅设此项时取紧邻游标之前的 limit 行
         std::string group_by;  // level / logger / hour（仅 logStats 使用）
     };
 
@@ -62,123 +74,632 @@ namespace LogQuery
                 return s;
             return s + ":00"; // HH:MM → HH:MM:00
         }
+
+        // "YYYY-MM-DD HH:MM[:SS]" 按本地时区解析为纪元微秒
+        bool parseLocalTime(const std::string &s, long long *us)
+        {
+            struct tm t = {};
+            int sec = 0;
+            if (sscanf(s.c_str(), "%d-%d-%d %d:%d:%d", &t.tm_year, &t.tm_mon, &t.tm_mday,
+                       &t.tm_hour, &t.tm_min, &sec) < 5)
+                return false;
+            t.tm_year -= 1900;
+            t.tm_mon -= 1;
+            t.tm_sec = sec;
+            t.tm_isdst = -1;
+            time_t epoch = mktime(&t);
+            if (epoch == (time_t)-1)
+                return false;
+            *us = (long long)epoch * 1000000;
+            return true;
+        }
+
+        // 关键词 → FTS5 查询串：空白分隔的每个词作为一个短语（词内按分词器切分后须相邻），
+        // 双引号包住的多词为短语，末尾 * 为前缀匹配；各部分之间为 AND。
+        // 关键词含非 ASCII 字符（unicode61 不切分中文）或没有可索引字符时返回 false，退回 LIKE。
+        bool ftsQuery(const std::string &keyword, std::string *out)
+        {
+            std::vector<std::pair<std::string, bool>> terms; // (短语, 是否前缀)
+            size_t i = 0;
+            while (i < keyword.size())
+            {
+                unsigned char c = keyword[i];
+                if (c >= 0x80)
+                    return false;
+                if (isspace(c))
+                {
+                    i++;
+                    continue;
+                }
+                std::string term;
+                if (c == '"')
+                {
+                    size_t end = keyword.find('"', i + 1);
+                    if (end == std::string::npos)
+                        end = keyword.size();
+                    term = keyword.substr(i + 1, end - i - 1);
+                    i = end + 1;
+                }
+                else
+                {
+                    size_t end = i;
+                    while (end < keyword.size() && !isspace((unsigned char)keyword[end]))
+                        end++;
+                    term = keyword.substr(i, end - i);
+                    i = end;
+                }
+                bool prefix = false;
+                if (i < keyword.size() && keyword[i] == '*')
+                {
+                    prefix = true; // "短语"*
+                    i++;
+                }
+                else if (!term.empty() && term.back() == '*')
+                {
+                    prefix = true; // 词*
+                    term.pop_back();
+                }
+                bool indexable = false;
+                for (unsigned char t : term)
+                {
+                    if (t >= 0x80)
+                        return false;
+                    indexable = indexable || isalnum(t);
+                }
+                if (indexable)
+                    terms.push_back({term, prefix});
+            }
+            if (terms.empty())
+                return false;
+            out->clear();
+            for (auto &t : terms)
+            {
+                if (!out->empty())
+                    *out += " ";
+                *out += '"';
+                for (char ch : t.first)
+                {
+                    if (ch == '"')
+                        *out += '"';
+                    *out += ch;
+                }
+                *out += '"';
+                if (t.second)
+                    *out += '*';
+            }
+            return true;
+        }
     } // anonymous namespace
 
-    /// @brief 按条件检索日志
-    inline Json::Value queryLogs(sqlite3 *db, const Params &p)
+    /// @brief 表结构版本：0 为旧库（log_time 为 +8 小时的 TEXT），2 为 UTC 纪元微秒 INTEGER，
+    /// 3 为字典编码（logs 是连接维度表的视图，列与 v2 相同），4 增加分钟汇总表 log_rollup_minute
+    inline int schemaVersion(sqlite3 *db)
+    {
+        BoundStmt stmt(db, "PRAGMA user_version");
+        if (!stmt || sqlite3_step(stmt.get()) != SQLITE_ROW)
+            return 0;
+        return sqlite3_column_int(stmt.get(), 0);
+    }
+
+    /// @brief 把 log_time 列转为可显示本地时间的 SQL 表达式，v2 精确到毫秒
+    inline std::string timeTextExpr(int version)
+    {
+        return version >= 2 ? "strftime('%Y-%m-%d %H:%M:%f', log_time / 1000000.0, 'unixepoch', 'localtime')"
+                            : "log_time";
+    }
+
+    /// @brief 日志库是否带有 FTS5 全文索引 logs_fts
+    inline bool hasFullText(sqlite3 *db)
+    {
+        BoundStmt stmt(db, "SELECT 1 FROM sqlite_master WHERE name='logs_fts'");
+        return stmt && sqlite3_step(stmt.get()) == SQLITE_ROW;
+    }
+
+    /// @brief 只读打开日志库
+    /// 写端使用 WAL 时读者不会阻塞写者；遇到检查点等短暂的锁时等待，而不是立即报 SQLITE_BUSY
+    inline int openReadOnly(const std::string &path, sqlite3 **db, int busy_timeout_ms = 5000)
+    {
+        int rc = sqlite3_open_v2(path.c_str(), db, SQLITE_OPEN_READONLY, nullptr);
+        if (rc == SQLITE_OK)
+            sqlite3_busy_timeout(*db, busy_timeout_ms);
+        return rc;
+    }
+
+    /// @brief 分区清单中的一个分区，时间范围为 [start_us, end_us)，分区内 id 也落在该区间
+    struct Partition
+    {
+        std::string path;
+        long long start_us;
+        long long end_us;
+    };
+
+    /// @brief 是否为 DataBaseSink 按时间分区时写出的清单库
+    inline bool isPartitioned(sqlite3 *db)
+    {
+        BoundStmt stmt(db, "SELECT 1 FROM sqlite_master WHERE type='table' AND name='log_partitions'");
+        return stmt && sqlite3_step(stmt.get()) == SQLITE_ROW;
+    }
+
+    /// @brief 列出与 [from_us, to_us) 相交的分区，按时间升序；路径相对清单库所在目录解析
+    inline std::vector<Partition> partitions(sqlite3 *db, long long from_us = LLONG_MIN, long long to_us = LLONG_MAX)
+    {
+        std::vector<Partition> parts;
+        std::string dir;
+        const char *main = sqlite3_db_filename(db, "main");
+        if (main)
+        {
+            dir = main;
+            size_t pos = dir.find_last_of('/');
+            dir = pos == std::string::npos ? "" : dir.substr(0, pos + 1);
+        }
+        BoundStmt stmt(db, "SELECT file, start_us, end_us FROM log_partitions "
+                           "WHERE end_us > ? AND start_us < ? ORDER BY start_us ASC");
+        if (!stmt)
+            return parts;
+        stmt.bindInt64(from_us);
+        stmt.bindInt64(to_us);
+        while (sqlite3_step(stmt.get()) == SQLITE_ROW)
+            parts.push_back(Partition{dir + (const char *)sqlite3_column_text(stmt.get(), 0),
+                                      sqlite3_column_int64(stmt.get(), 1),
+                                      sqlite3_column_int64(stmt.get(), 2)});
+        return parts;
+    }
+
+    /// @brief 逐行回调：row 在回调返回后即被复用，需要保留时自行拷贝；返回 false 提前结束检索
+    using RowCallback = std::function<bool(const Json::Value &row)>;
+
+    namespace
     {
-        std::string sql = "SELECT id, log_time, line_number, thread_id, log_level, "
-                          "source_file, logger_name, message FROM logs WHERE 1=1";
-        std::vector<std::string> texts;
-        std::vector<int> ints;
+        // 检索条件：WHERE 子句及其参数，文本参数全部位于整数参数之前
+        struct Filter
+        {
+            std::string where;
+            std::vector<std::string> texts;
+            std::vector<long long> ints; // 游标与 v2 时间范围
+        };
+
+        Filter buildFilter(sqlite3 *db, const Params &p, int version)
+        {
+            Filter f;
+            f.where = " WHERE 1=1";
+            bool v2 = version >= 2;
+
+            // 等级过滤：level="ERROR,WARN" → WHERE log_level IN (?,?)
+            if (!p.level.empty())
+            {
+                std::istringstream iss(p.level);
+                std::string token;
+                std::vector<std::string> levels;
+                while (std::getline(iss, token, ','))
+                    levels.push_back(token);
+
+                f.where += " AND log_level IN (";
+                for (size_t i = 0; i < levels.size(); i++)
+                {
+                    if (i > 0)
+                        f.where += ",";
+                    f.where += "?";
+                    f.texts.push_back(levels[i]);
+                }
+                f.where += ")";
+            }
+
+            std::string match;
+            if (!p.keyword.empty() && hasFullText(db) && ftsQuery(p.keyword, &match))
+            {
+                f.where += " AND id IN (SELECT rowid FROM logs_fts WHERE logs_fts MATCH ?)";
+                f.texts.push_back(match);
+            }
+            else if (!p.keyword.empty())
+            {
+                f.where += " AND message LIKE ?";
+                f.texts.push_back("%" + p.keyword + "%");
+            }
+            if (!p.logger.empty())
+            {
+                f.where += " AND logger_name = ?";
+                f.texts.push_back(p.logger);
+            }
+            if (!p.tid.empty())
+            {
+                f.where += " AND thread_id = ?";
+                f.texts.push_back(p.tid);
+            }
+            long long us = 0;
+            if (!p.from_time.empty())
+            {
+                if (!v2)
+                {
+                    f.where += " AND log_time >= ?";
+                    f.texts.push_back(padTime(p.from_time));
+                }
+                else if (parseLocalTime(p.from_time, &us))
+                {
+                    f.where += " AND log_time >= ?";
+                    f.ints.push_back(us);
+                }
+            }
+            if (!p.to_time.empty())
+            {
+                if (!v2)
+                {
+                    f.where += " AND log_time <= ?";
+                    f.texts.push_back(padTime(p.to_time));
+                }
+                else if (parseLocalTime(p.to_time, &us))
+                {
+                    // 精度到秒的上界包含该秒内的全部记录
+                    f.where += " AND log_time < ?";
+                    f.ints.push_back(us + 1000000);
+                }
+            }
+
+            // 游标条件走主键范围扫描，翻到多深都只读取本页的行
+            if (p.after_id > 0)
+            {
+                f.where += " AND id > ?";
+                f.ints.push_back(p.after_id);
+            }
+            if (p.before_id > 0)
+            {
+                f.where += " AND id < ?";
+                f.ints.push_back(p.before_id);
+            }
+            return f;
+        }
+
+        void bindFilter(BoundStmt &stmt, const Filter &f)
+        {
+            for (auto &t : f.texts)
+                stmt.bindText(t);
+            for (auto v : f.ints)
+                stmt.bindInt64(v);
+        }
+
+        // 只给 before_id 时向前翻页：取紧邻游标之前的行
+        bool isBackward(const Params &p) { return p.before_id > 0 && p.after_id <= 0; }
+
+        // 在单个库上检索，按 id 升序逐行交给 fn，返回交出的行数；分区查询时对每个分区调用
+        size_t scanOne(sqlite3 *db, const Params &p, const RowCallback &fn)
+        {
+            int version = schemaVersion(db);
+            bool v2 = version >= 2;
+            Filter f = buildFilter(db, p, version);
+            std::string sql = "SELECT id, " + timeTextExpr(version) + ", line_number, thread_id, log_level, "
+                              "source_file, logger_name, message, log_time FROM logs" + f.where;
+            // 向前翻页先倒序取紧邻游标的行，外层再按升序输出
+            if (isBackward(p))
+                sql = "SELECT * FROM (" + sql + " ORDER BY id DESC LIMIT ? OFFSET ?) ORDER BY id ASC";
+            else
+                sql += " ORDER BY id ASC LIMIT ? OFFSET ?";
+
+            BoundStmt stmt(db, sql);
+            if (!stmt)
+                return 0;
+            bindFilter(stmt, f);
+            stmt.bindInt(p.limit);
+            stmt.bindInt(p.offset);
 
-        // 等级过滤：level="ERROR,WARN" → WHERE log_level IN (?,?)
-        if (!p.level.empty())
+            size_t n = 0;
+            Json::Value row(Json::objectValue);
+            while (sqlite3_step(stmt.get()) == SQLITE_ROW)
+            {
+                row["id"] = (Json::Int64)sqlite3_column_int64(stmt.get(), 0);
+                row["log_time"] = (const char *)sqlite3_column_text(stmt.get(), 1);
+                if (v2)
+                    row["log_time_us"] = (Json::Int64)sqlite3_column_int64(stmt.get(), 8);
+                row["line_number"] = sqlite3_column_int(stmt.get(), 2);
+                row["thread_id"] = (const char *)sqlite3_column_text(stmt.get(), 3);
+                row["log_level"] = (const char *)sqlite3_column_text(stmt.get(), 4);
+                row["source_file"] = (const char *)sqlite3_column_text(stmt.get(), 5);
+                row["logger_name"] = (const char *)sqlite3_column_text(stmt.get(), 6);
+                row["message"] = (const char *)sqlite3_column_text(stmt.get(), 7);
+                n++;
+                if (!fn(row))
+                    break;
+            }
+            return n;
+        }
+
+        Json::Value queryOne(sqlite3 *db, const Params &p)
+        {
+            Json::Value rows(Json::arrayValue);
+            scanOne(db, p, [&rows](const Json::Value &row)
+                    { rows.append(row); return true; });
+            return rows;
+        }
+
+        // 单个库中 id 小于 before_id 且满足条件的行数，至多数到 cap
+        long long countBefore(sqlite3 *db, const Params &p, long long cap)
+        {
+            Filter f = buildFilter(db, p, schemaVersion(db));
+            BoundStmt stmt(db, "SELECT COUNT(*) FROM (SELECT 1 FROM logs" + f.where + " LIMIT ?)");
+            if (!stmt)
+                return 0;
+            bindFilter(stmt, f);
+            stmt.bindInt64(cap);
+            return sqlite3_step(stmt.get()) == SQLITE_ROW ? sqlite3_column_int64(stmt.get(), 0) : 0;
+        }
+
+        // 在单个库上按 group_by 计数；v4 起读分钟汇总表，代价与分钟桶数成正比而不是行数
+        Json::Value statsOne(sqlite3 *db, const Params &p)
         {
-            std::istringstream iss(p.level);
-            std::string token;
-            std::vector<std::string> levels;
-            while (std::getline(iss, token, ','))
-                levels.push_back(token);
+            int version = schemaVersion(db);
+            std::string sql;
+            if (version >= 4)
+            {
+                if (p.group_by == "logger")
+                    sql = "SELECT g.name AS grp, SUM(r.count) AS cnt FROM log_rollup_minute r "
+                          "JOIN log_loggers g ON g.id = r.logger_ref";
+                else if (p.group_by == "hour")
+                    sql = "SELECT strftime('%Y-%m-%d %H:00', r.minute * 60, 'unixepoch', 'localtime') AS grp, "
+                          "SUM(r.count) AS cnt FROM log_rollup_minute r";
+                else
+                    sql = "SELECT l.name AS grp, SUM(r.count) AS cnt FROM log_rollup_minute r "
+                          "JOIN log_levels l ON l.id = r.level_ref";
+                sql += " GROUP BY grp HAVING cnt > 0";
+            }
+            else
+            {
+                std::string group_col;
+                if (p.group_by == "level")
+                    group_col = "log_level";
+                else if (p.group_by == "logger")
+                    group_col = "logger_name";
+                else if (p.group_by == "hour")
+                    group_col = version >= 2
+                                    ? "strftime('%Y-%m-%d %H:00', log_time / 1000000, 'unixepoch', 'localtime')"
+                                    : "strftime('%Y-%m-%d %H:00', log_time)";
+                else
+                    group_col = "log_level";
+                sql = "SELECT " + group_col + " AS grp, COUNT(*) AS cnt FROM logs WHERE 1=1 GROUP BY grp";
+            }
 
-            sql += " AND log_level IN (";
-            for (size_t i = 0; i < levels.size(); i++)
+            BoundStmt stmt(db, sql + " ORDER BY cnt DESC");
+            if (!stmt)
+                return Json::Value(Json::objectValue);
+
+            Json::Value result(Json::objectValue);
+            Json::Value groups(Json::arrayValue);
+            int total = 0;
+
+            while (sqlite3_step(stmt.get()) == SQLITE_ROW)
             {
-                if (i > 0)
-                    sql += ",";
-                sql += "?";
-                texts.push_back(levels[i]);
+                Json::Value g;
+                g["group"] = (const char *)sqlite3_column_text(stmt.get(), 0);
+                g["count"] = sqlite3_column_int(stmt.get(), 1);
+                groups.append(g);
+                total += sqlite3_column_int(stmt.get(), 1);
             }
-            sql += ")";
+            result["groups"] = groups;
+            result["total"] = total;
+            return result;
         }
 
-        if (!p.keyword.empty())
+        // 单个库中的日志器名称
+        Json::Value loggersOne(sqlite3 *db)
         {
-            sql += " AND message LIKE ?";
-            texts.push_back("%" + p.keyword + "%");
+            // v3 起日志器名称在维度表中，无需扫描全部日志
+            BoundStmt stmt(db, schemaVersion(db) >= 3 ? "SELECT name FROM log_loggers ORDER BY name"
+                                                      : "SELECT DISTINCT logger_name FROM logs ORDER BY logger_name");
+            if (!stmt)
+                return Json::Value(Json::arrayValue);
+
+            Json::Value arr(Json::arrayValue);
+            while (sqlite3_step(stmt.get()) == SQLITE_ROW)
+                arr.append((const char *)sqlite3_column_text(stmt.get(), 0));
+            return arr;
         }
-        if (!p.logger.empty())
+
+        // 查询条件对应的时间范围 [from_us, to_us)，用于裁剪分区
+        void timeRange(const Params &p, long long *from_us, long long *to_us)
         {
-            sql += " AND logger_name = ?";
-            texts.push_back(p.logger);
+            long long us = 0;
+            *from_us = LLONG_MIN;
+            *to_us = LLONG_MAX;
+            if (!p.from_time.empty() && parseLocalTime(p.from_time, &us))
+                *from_us = us;
+            if (!p.to_time.empty() && parseLocalTime(p.to_time, &us))
+                *to_us = us + 1000000;
         }
-        if (!p.tid.empty())
+
+        // 在各分区上并行执行 fn(i, db)：线程数不超过分区数与 CPU 核数，每个线程使用自己的只读连接
+        template <typename Fn>
+        void fanOut(const std::vector<Partition> &parts, Fn fn)
         {
-            sql += " AND thread_id = ?";
-            texts.push_back(p.tid);
+            size_t cores = std::max(1u, std::thread::hardware_concurrency());
+            size_t workers = std::min(parts.size(), cores);
+            std::atomic<size_t> next(0);
+            auto run = [&]()
+            {
+                for (size_t i = next++; i < parts.size(); i = next++)
+                {
+                    sqlite3 *db = nullptr;
+                    if (openReadOnly(parts[i].path, &db) == SQLITE_OK)
+                        fn(i, db);
+                    sqlite3_close(db);
+                }
+            };
+            std::vector<std::thread> threads;
+            for (size_t w = 1; w < workers; w++)
+                threads.emplace_back(run);
+            run();
+            for (auto &t : threads)
+                t.join();
         }
-        if (!p.from_time.empty())
+
+        // 与查询条件相交的分区：分区内 id 落在分区时间范围内，游标同样可以用来裁剪
+        std::vector<Partition> queryPartitions(sqlite3 *db, const Params &p)
         {
-            sql += " AND log_time >= ?";
-            texts.push_back(padTime(p.from_time));
+            long long from_us = 0, to_us = 0;
+            timeRange(p, &from_us, &to_us);
+            if (p.after_id > 0)
+                from_us = std::max(from_us, p.after_id + 1);
+            if (p.before_id > 0)
+                to_us = std::min(to_us, p.before_id);
+            return partitions(db, from_us, to_us);
         }
-        if (!p.to_time.empty())
+    } // anonymous namespace
+
+    /// @brief 流式检索：按 id 升序逐行回调，不在内存中累积结果，导出任意多行时内存占用不变
+    /// 分区库按顺序逐个分区读取；回调返回 false 时停止
+    /// @return 回调过的行数
+    inline size_t forEachLog(sqlite3 *db, const Params &p, const RowCallback &fn)
+    {
+        if (!isPartitioned(db))
+            return scanOne(db, p, fn);
+        std::vector<Partition> parts = queryPartitions(db, p);
+        long long limit = p.limit < 0 ? LLONG_MAX : p.limit;
+        long long skip = std::max(0, p.offset);
+
+        // 向前翻页：从最新的分区往回数，确定凑够 offset + limit 行需要哪些分区、每个分区取几行，
+        // 然后和向后翻页一样从最早的分区开始升序输出，只是丢掉最靠近游标的 offset 行
+        size_t first = 0;
+        std::vector<long long> take(parts.size(), 0);
+        if (isBackward(p))
         {
-            sql += " AND log_time <= ?";
-            texts.push_back(padTime(p.to_time));
+            long long need = limit == LLONG_MAX ? LLONG_MAX : limit + skip;
+            long long total = 0;
+            first = parts.size();
+            while (first > 0 && need > 0)
+            {
+                first--;
+                sqlite3 *part = nullptr;
+                if (openReadOnly(parts[first].path, &part) == SQLITE_OK)
+                    take[first] = countBefore(part, p, need);
+                sqlite3_close(part);
+                need -= take[first];
+                total += take[first];
+            }
+            limit = std::min(limit, std::max(0LL, total - skip));
+            skip = 0;
         }
 
-        sql += " ORDER BY id ASC";
-        sql += " LIMIT ? OFFSET ?";
+        size_t emitted = 0;
+        bool stopped = false;
+        for (size_t i = first; i < parts.size() && !stopped && limit > 0; i++)
+        {
+            Params one = p;
+            one.offset = 0;
+            long long rows = isBackward(p) ? take[i] : (limit == LLONG_MAX ? -1 : limit + skip);
+            one.limit = rows < 0 || rows > INT_MAX ? -1 : (int)rows;
+            if (one.limit == 0)
+                continue;
+            sqlite3 *part = nullptr;
+            if (openReadOnly(parts[i].path, &part) == SQLITE_OK)
+                scanOne(part, one, [&](const Json::Value &row)
+                        {
+                            if (skip > 0)
+                            {
+                                skip--;
+                                return true;
+                            }
+                            emitted++;
+                            limit--;
+                            if (!fn(row))
+                                stopped = true;
+                            return !stopped && limit > 0; });
+            sqlite3_close(part);
+        }
+        return emitted;
+    }
 
-        BoundStmt stmt(db, sql);
-        if (!stmt)
-            return Json::Value(Json::arrayValue);
+    /// @brief 按条件检索日志，结果按 id 升序
+    inline Json::Value queryLogs(sqlite3 *db, const Params &p)
+    {
+        // 单库以及带游标的分页不会很大，直接收集流式结果
+        if (!isPartitioned(db) || p.after_id > 0 || p.before_id > 0)
+        {
+            Json::Value rows(Json::arrayValue);
+            forEachLog(db, p, [&rows](const Json::Value &row)
+                       { rows.append(row); return true; });
+            return rows;
+        }
+        std::vector<Partition> parts = queryPartitions(db, p);
 
-        for (auto &t : texts)
-            stmt.bindText(t);
-        for (auto &i : ints)
-            stmt.bindInt(i);
-        stmt.bindInt(p.limit);
-        stmt.bindInt(p.offset);
+        // 各分区 id 区间互不重叠且随时间递增，按分区顺序拼接即为全局 id 序，
+        // 因此每个分区至多取 offset + limit 行，在各分区上并行查询后再统一跳过 offset
+        Params sub = p;
+        sub.offset = 0;
+        sub.limit = p.limit < 0 ? -1 : p.limit + p.offset;
+        std::vector<Json::Value> results(parts.size());
+        fanOut(parts, [&](size_t i, sqlite3 *part)
+               { results[i] = queryOne(part, sub); });
 
         Json::Value rows(Json::arrayValue);
-        while (sqlite3_step(stmt.get()) == SQLITE_ROW)
+        int skip = p.offset;
+        for (auto &r : results)
         {
-            Json::Value row;
-            row["id"] = sqlite3_column_int(stmt.get(), 0);
-            row["log_time"] = (const char *)sqlite3_column_text(stmt.get(), 1);
-            row["line_number"] = sqlite3_column_int(stmt.get(), 2);
-            row["thread_id"] = (const char *)sqlite3_column_text(stmt.get(), 3);
-            row["log_level"] = (const char *)sqlite3_column_text(stmt.get(), 4);
-            row["source_file"] = (const char *)sqlite3_column_text(stmt.get(), 5);
-            row["logger_name"] = (const char *)sqlite3_column_text(stmt.get(), 6);
-            row["message"] = (const char *)sqlite3_column_text(stmt.get(), 7);
-            rows.append(row);
+            for (auto &row : r)
+            {
+                if (skip > 0)
+                {
+                    skip--;
+                    continue;
+                }
+                if (p.limit >= 0 && (int)rows.size() >= p.limit)
+                    return rows;
+                rows.append(row);
+            }
         }
         return rows;
     }
 
+    /// @brief 游标翻页：返回 {rows, has_more, next_after_id, next_before_id}
+    /// 多取一行判断是否还有下一页。向后翻页把 next_after_id 作为下一次的 after_id；
+    /// 只给 before_id 向前翻页时，has_more 表示更早的行，next_before_id 作为下一次的 before_id
+    inline Json::Value queryPage(sqlite3 *db, const Params &p)
+    {
+        bool backward = p.before_id > 0 && p.after_id <= 0;
+        Params probe = p;
+        if (p.limit >= 0)
+            probe.limit = p.limit + 1;
+        Json::Value rows = queryLogs(db, probe);
+        bool more = p.limit >= 0 && (int)rows.size() > p.limit;
+
+        Json::Value page(Json::arrayValue);
+        int first = backward && more ? 1 : 0;
+        int last = (int)rows.size() - (!backward && more ? 1 : 0);
+        for (int i = first; i < last; i++)
+            page.append(rows[i]);
+
+        Json::Value result(Json::objectValue);
+        result["rows"] = page;
+        result["has_more"] = more;
+        result["next_after_id"] = page.empty() ? (Json::Int64)p.after_id : page[page.size() - 1]["id"].asInt64();
+        result["next_before_id"] = page.empty() ? (Json::Int64)p.before_id : page[0]["id"].asInt64();
+        return result;
+    }
+
     /// @brief 聚合统计
     inline Json::Value logStats(sqlite3 *db, const Params &p)
     {
-        std::string group_col;
-        if (p.group_by == "level")
-            group_col = "log_level";
-        else if (p.group_by == "logger")
-            group_col = "logger_name";
-        else if (p.group_by == "hour")
-            group_col = "strftime('%Y-%m-%d %H:00', log_time)";
-        else
-            group_col = "log_level";
+        if (!isPartitioned(db))
+            return statsOne(db, p);
+        std::vector<Partition> parts = partitions(db);
+        std::vector<Json::Value> results(parts.size());
+        fanOut(parts, [&](size_t i, sqlite3 *part)
+               { results[i] = statsOne(part, p); });
 
-        std::string sql = "SELECT " + group_col + " AS grp, COUNT(*) AS cnt FROM logs WHERE 1=1";
-
-        BoundStmt stmt(db, sql + " GROUP BY grp ORDER BY cnt DESC");
-        if (!stmt)
-            return Json::Value(Json::objectValue);
+        std::map<std::string, int> counts;
+        for (auto &r : results)
+            for (auto &g : r["groups"])
+                counts[g["group"].asString()] += g["count"].asInt();
+        std::vector<std::pair<std::string, int>> sorted(counts.begin(), counts.end());
+        std::stable_sort(sorted.begin(), sorted.end(),
+                         [](const std::pair<std::string, int> &a, const std::pair<std::string, int> &b)
+                         { return a.second > b.second; });
 
         Json::Value result(Json::objectValue);
         Json::Value groups(Json::arrayValue);
         int total = 0;
-
-        while (sqlite3_step(stmt.get()) == SQLITE_ROW)
+        for (auto &kv : sorted)
         {
             Json::Value g;
-            g["group"] = (const char *)sqlite3_column_text(stmt.get(), 0);
-            g["count"] = sqlite3_column_int(stmt.get(), 1);
+            g["group"] = kv.first;
+            g["count"] = kv.second;
             groups.append(g);
-            total += sqlite3_column_int(stmt.get(), 1);
+            total += kv.second;
         }
         result["groups"] = groups;
         result["total"] = total;
@@ -188,14 +709,83 @@ namespace LogQuery
     /// @brief 列出所有日志器名称
     inline Json::Value listLoggers(sqlite3 *db)
     {
-        BoundStmt stmt(db, "SELECT DISTINCT logger_name FROM logs ORDER BY logger_name");
-        if (!stmt)
-            return Json::Value(Json::arrayValue);
-
+        if (!isPartitioned(db))
+            return loggersOne(db);
+        std::vector<Partition> parts = partitions(db);
+        std::vector<Json::Value> results(parts.size());
+        fanOut(parts, [&](size_t i, sqlite3 *part)
+               { results[i] = loggersOne(part); });
+        std::set<std::string> names;
+        for (auto &r : results)
+            for (auto &n : r)
+                names.insert(n.asString());
         Json::Value arr(Json::arrayValue);
-        while (sqlite3_step(stmt.get()) == SQLITE_ROW)
-            arr.append((const char *)sqlite3_column_text(stmt.get(), 0));
+        for (auto &n : names)
+            arr.append(n);
         return arr;
     }
 
+    /// @brief 当前最大的日志 id，实时推送以此为起点
+    inline long long maxId(sqlite3 *db)
+    {
+        auto maxOf = [](sqlite3 *one) -> long long
+        {
+            BoundStmt stmt(one, "SELECT COALESCE(MAX(id), 0) FROM logs");
+            return stmt && sqlite3_step(stmt.get()) == SQLITE_ROW ? sqlite3_column_int64(stmt.get(), 0) : 0;
+        };
+        if (!isPartitioned(db))
+            return maxOf(db);
+        std::vector<Partition> parts = partitions(db);
+        for (auto it = parts.rbegin(); it != parts.rend(); ++it)
+        {
+            sqlite3 *part = nullptr;
+            long long id = openReadOnly(it->path, &part) == SQLITE_OK ? maxOf(part) : 0;
+            sqlite3_close(part);
+            if (id > 0)
+                return id;
+        }
+        return 0;
+    }
+
+    /// @brief id 大于 after_id 的至多 limit 条日志，按 id 升序，供实时推送使用
+    inline Json::Value tailLogs(sqlite3 *db, long long after_id, int limit)
+    {
+        Json::Value rows(Json::arrayValue);
+        auto tailOne = [&](sqlite3 *one)
+        {
+            BoundStmt stmt(one, "SELECT id, " + timeTextExpr(schemaVersion(one)) +
+                                    ", log_level, logger_name, message FROM logs WHERE id > ? ORDER BY id ASC LIMIT ?");
+            if (!stmt)
+                return;
+            stmt.bindInt64(after_id);
+            stmt.bindInt(limit - (int)rows.size());
+            while (sqlite3_step(stmt.get()) == SQLITE_ROW)
+            {
+                Json::Value row;
+                row["id"] = (Json::Int64)sqlite3_column_int64(stmt.get(), 0);
+                row["log_time"] = (const char *)sqlite3_column_text(stmt.get(), 1);
+                row["log_level"] = (const char *)sqlite3_column_text(stmt.get(), 2);
+                row["logger_name"] = (const char *)sqlite3_column_text(stmt.get(), 3);
+                row["message"] = (const char *)sqlite3_column_text(stmt.get(), 4);
+                rows.append(row);
+            }
+        };
+        if (!isPartitioned(db))
+        {
+            tailOne(db);
+            return rows;
+        }
+        // 分区内 id 不超过分区结束时间，只需查看结束时间晚于 after_id 的分区
+        for (auto &part : partitions(db, after_id + 1))
+        {
+            if ((int)rows.size() >= limit)
+                break;
+            sqlite3 *one = nullptr;
+            if (openReadOnly(part.path, &one) == SQLITE_OK)
+                tailOne(one);
+            sqlite3_close(one);
+        }
+        return rows;
+    }
+
 } // namespace LogQuery
@@ -2,13 +2,14 @@
 //
 // 用法: ./logcli --db <path> [--level ERROR,WARN] [--from "2026-07-01 10:00"]
 //                [--to "2026-07-01 12:00"] [--grep keyword] [--logger name]
-//                [--tid 0x1234] [--limit 100] [--offset 0]
+//                [--tid 0x1234] [--limit 100] [--after-id N | --before-id N] [--offset 0]
 //                [--stats] [--group-by level|logger|hour]
-//                [--format table|json|csv]
+//                [--format table|json|ndjson|csv]
 #include "../LogQuery.hpp"
 #include <sqlite3.h>
 #include <jsoncpp/json/json.h>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <cstring>
 
@@ -19,41 +20,99 @@ static void usage(const char *prog)
               << "  --level STR      日志等级过滤，逗号分隔（ERROR,WARN）\n"
               << "  --from TIME      起始时间 YYYY-MM-DD HH:MM\n"
               << "  --to TIME        结束时间 YYYY-MM-DD HH:MM\n"
-              << "  --grep STR       关键词搜索\n"
+              << "  --grep STR       关键词搜索（有全文索引时支持 \"短语\" 与 前缀*）\n"
               << "  --logger STR     日志器名称\n"
               << "  --tid STR        线程 ID\n"
               << "  --limit N        返回条数上限（默认1000）\n"
-              << "  --offset N       偏移量（默认0）\n"
+              << "  --after-id N     游标翻页：只取 id 大于 N 的行，下一页游标输出到 stderr\n"
+              << "  --before-id N    游标翻页：取 id 小于 N 的最近若干行（向前翻页）\n"
+              << "  --offset N       偏移量（默认0，仅为兼容保留，深翻页请用游标）\n"
               << "  --stats          聚合统计模式\n"
               << "  --group-by STR   分组维度: level / logger / hour\n"
-              << "  --format STR     输出格式: table / json / csv（默认table）\n";
+              << "  --format STR     输出格式: table / json / ndjson / csv（默认table）\n";
 }
 
-// 表格输出
-static void printTable(const Json::Value &rows)
+// 流式输出：逐行写出，不在内存中累积结果
+class RowPrinter
 {
-    if (rows.empty())
+public:
+    explicit RowPrinter(const std::string &format) : _format(format)
     {
-        std::cout << "(no results)\n";
-        return;
+        Json::StreamWriterBuilder w;
+        w["indentation"] = format == "json" ? "  " : "";
+        _writer.reset(w.newStreamWriter());
     }
-    // 简易对齐表格
-    std::cout << "ID\tTIME\t\t\tLEVEL\tLOGGER\t\tMESSAGE\n";
-    std::cout << "──\t────\t\t\t─────\t──────\t\t───────\n";
-    for (auto &r : rows)
+
+    void row(const Json::Value &r)
     {
-        std::string time = r["log_time"].asString();
-        if (time.size() > 19) time = time.substr(0, 19);
-        std::string msg = r["message"].asString();
-        if (msg.size() > 60) msg = msg.substr(0, 57) + "...";
-        std::cout << r["id"].asInt() << "\t"
-                  << time << "\t"
-                  << r["log_level"].asString() << "\t"
-                  << r["logger_name"].asString() << "\t\t"
-                  << msg << "\n";
+        if (_count++ == 0)
+            header();
+        else if (_format == "json")
+            std::cout << ",\n";
+        if (_format == "json" || _format == "ndjson")
+        {
+            _writer->write(r, &std::cout);
+            if (_format == "ndjson")
+                std::cout << "\n";
+        }
+        else if (_format == "csv")
+            std::cout << r["id"].asInt64() << ","
+                      << r["log_time"].asString() << ","
+                      << r["log_level"].asString() << ","
+                      << r["logger_name"].asString() << ","
+                      << r["source_file"].asString() << ","
+                      << r["line_number"].asInt() << ","
+                      << r["thread_id"].asString() << ","
+                      << "\"" << r["message"].asString() << "\"\n";
+        else
+        {
+            // 简易对齐表格
+            std::string time = r["log_time"].asString();
+            if (time.size() > 19) time = time.substr(0, 19);
+            std::string msg = r["message"].asString();
+            if (msg.size() > 60) msg = msg.substr(0, 57) + "...";
+            std::cout << r["id"].asInt64() << "\t"
+                      << time << "\t"
+                      << r["log_level"].asString() << "\t"
+                      << r["logger_name"].asString() << "\t\t"
+                      << msg << "\n";
+        }
+    }
+
+    void finish()
+    {
+        if (_format == "json")
+            std::cout << (_count ? "\n]\n" : "[]\n");
+        else if (_format == "csv" || _format == "ndjson")
+        {
+            if (_format == "csv" && !_count)
+                header();
+        }
+        else if (!_count)
+            std::cout << "(no results)\n";
+        else
+            std::cout << "──\n" << _count << " row(s)\n";
+        std::cout.flush();
     }
-    std::cout << "──\n" << rows.size() << " row(s)\n";
-}
+
+private:
+    void header()
+    {
+        if (_format == "json")
+            std::cout << "[\n";
+        else if (_format == "csv")
+            std::cout << "id,time,level,logger,file,line,tid,message\n";
+        else if (_format != "ndjson")
+        {
+            std::cout << "ID\tTIME\t\t\tLEVEL\tLOGGER\t\tMESSAGE\n";
+            std::cout << "──\t────\t\t\t─────\t──────\t\t───────\n";
+        }
+    }
+
+    std::string _format;
+    std::unique_ptr<Json::StreamWriter> _writer;
+    size_t _count = 0;
+};
 
 // 统计输出
 static void printStats(const Json::Value &result, const std::string &format)
@@ -75,6 +134,7 @@ int main(int argc, char *argv[])
 {
     std::string db_path, level, from_time, to_time, keyword, logger, tid, group_by, format = "table";
     int limit = 1000, offset = 0;
+    long long after_id = 0, before_id = 0;
     bool stats = false;
 
     for (int i = 1; i < argc; i++)
@@ -89,6 +149,8 @@ int main(int argc, char *argv[])
         else if (arg == "--tid" && i + 1 < argc) tid = argv[++i];
         else if (arg == "--limit" && i + 1 < argc) limit = std::stoi(argv[++i]);
         else if (arg == "--offset" && i + 1 < argc) offset = std::stoi(argv[++i]);
+        else if (arg == "--after-id" && i + 1 < argc) after_id = std::stoll(argv[++i]);
+        else if (arg == "--before-id" && i + 1 < argc) before_id = std::stoll(argv[++i]);
         else if (arg == "--group-by" && i + 1 < argc) group_by = argv[++i];
         else if (arg == "--format" && i + 1 < argc) format = argv[++i];
         else if (arg == "--stats") stats = true;
@@ -99,7 +161,7 @@ int main(int argc, char *argv[])
     if (db_path.empty()) { usage(argv[0]); return 1; }
 
     sqlite3 *db = nullptr;
-    if (sqlite3_open_v2(db_path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK)
+    if (LogQuery::openReadOnly(db_path, &db) != SQLITE_OK)
     {
         std::cerr << "无法打开数据库: " << db_path << " (" << sqlite3_errmsg(db) << ")\n";
         return 1;
@@ -114,13 +176,15 @@ int main(int argc, char *argv[])
     p.tid = tid;
     p.limit = limit;
     p.offset = offset;
+    p.after_id = after_id;
+    p.before_id = before_id;
     p.group_by = group_by;
 
     int rc = 0;
     if (stats)
     {
         auto result = LogQuery::logStats(db, p);
-        if (format == "json")
+        if (format == "json" || format == "ndjson")
             printStats(result, "json");
         else if (format == "csv")
         {
@@ -133,28 +197,34 @@ int main(int argc, char *argv[])
     }
     else
     {
-        auto rows = LogQuery::queryLogs(db, p);
-        if (format == "json")
-        {
-            Json::StreamWriterBuilder w;
-            w["indentation"] = "  ";
-            std::cout << Json::writeString(w, rows) << "\n";
-        }
-        else if (format == "csv")
+        // 逐行输出，--limit 再大内存占用也不变
+        RowPrinter printer(format);
+        long long first_id = 0, last_id = 0;
+        LogQuery::forEachLog(db, p, [&](const Json::Value &r)
+                             {
+                                 last_id = r["id"].asInt64();
+                                 if (!first_id)
+                                     first_id = last_id;
+                                 printer.row(r);
+                                 return true; });
+        printer.finish();
+
+        // 翻页方向上再探一行，判断是否还有下一页；游标写到 stderr，不混入 json/csv 输出
+        bool backward = before_id > 0 && after_id <= 0;
+        LogQuery::Params probe = p;
+        probe.offset = 0;
+        probe.limit = 1;
+        if (backward)
+            probe.before_id = first_id;
+        else
+            probe.after_id = last_id;
+        if (p.limit >= 0 && last_id && !LogQuery::queryLogs(db, probe).empty())
         {
-            std::cout << "id,time,level,logger,file,line,tid,message\n";
-            for (auto &r : rows)
-                std::cout << r["id"].asInt() << ","
-                          << r["log_time"].asString() << ","
-                          << r["log_level"].asString() << ","
-                          << r["logger_name"].asString() << ","
-                          << r["source_file"].asString() << ","
-                          << r["line_number"].asInt() << ","
-                          << r["thread_id"].asString() << ","
-                          << "\"" << r["message"].asString() << "\"\n";
+            if (backward)
+                std::cerr << "more: --before-id " << first_id << "\n";
+            else
+                std::cerr << "more: --after-id " << last_id << "\n";
         }
-        else
-            printTable(rows);
     }
 
     sqlite3_close(db);
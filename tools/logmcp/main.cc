@@ -50,7 +50,8 @@ static Json::Value toolList()
         t["name"] = "query_logs";
         t["description"] = "Query log entries from the SQLite database. "
                            "Filter by log level, time range, keyword search, logger name, or thread ID. "
-                           "Returns matching log entries with all fields.";
+                           "Returns {rows, has_more, next_after_id, next_before_id}: pass next_after_id as after_id "
+                           "to fetch the next page (or next_before_id as before_id when paging backwards).";
         t["inputSchema"]["type"] = "object";
         t["inputSchema"]["properties"]["db_path"]["type"] = "string";
         t["inputSchema"]["properties"]["db_path"]["description"] = "Path to the SQLite log database file";
@@ -61,7 +62,8 @@ static Json::Value toolList()
         t["inputSchema"]["properties"]["to_time"]["type"] = "string";
         t["inputSchema"]["properties"]["to_time"]["description"] = "End time in format YYYY-MM-DD HH:MM";
         t["inputSchema"]["properties"]["keyword"]["type"] = "string";
-        t["inputSchema"]["properties"]["keyword"]["description"] = "Keyword to search in log messages";
+        t["inputSchema"]["properties"]["keyword"]["description"] = "Keyword to search in log messages. When the database has a full-text index, "
+                                                                        "words are ANDed, \"quoted phrase\" matches adjacent words and word* matches a prefix";
         t["inputSchema"]["properties"]["logger"]["type"] = "string";
         t["inputSchema"]["properties"]["logger"]["description"] = "Logger name filter";
         t["inputSchema"]["properties"]["tid"]["type"] = "string";
@@ -69,7 +71,11 @@ static Json::Value toolList()
         t["inputSchema"]["properties"]["limit"]["type"] = "integer";
         t["inputSchema"]["properties"]["limit"]["description"] = "Maximum number of results (default 1000)";
         t["inputSchema"]["properties"]["offset"]["type"] = "integer";
-        t["inputSchema"]["properties"]["offset"]["description"] = "Result offset for pagination";
+        t["inputSchema"]["properties"]["offset"]["description"] = "Result offset (kept for compatibility; prefer after_id/before_id)";
+        t["inputSchema"]["properties"]["after_id"]["type"] = "integer";
+        t["inputSchema"]["properties"]["after_id"]["description"] = "Cursor: only return entries with id greater than this (next_after_id of the previous page)";
+        t["inputSchema"]["properties"]["before_id"]["type"] = "integer";
+        t["inputSchema"]["properties"]["before_id"]["description"] = "Cursor: return the newest entries with id less than this (page backwards)";
         t["inputSchema"]["required"] = Json::Value(Json::arrayValue);
         t["inputSchema"]["required"].append("db_path");
         tools.append(t);
@@ -135,7 +141,7 @@ static Json::Value handleCall(const Json::Value &params, const std::string &db_p
     }
 
     sqlite3 *db = nullptr;
-    if (sqlite3_open_v2(db_path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK)
+    if (LogQuery::openReadOnly(db_path, &db) != SQLITE_OK)
     {
         std::string errmsg = "Cannot open database: " + db_path;
         if (db) { errmsg += " (" + std::string(sqlite3_errmsg(db)) + ")"; sqlite3_close(db); }
@@ -158,15 +164,17 @@ static Json::Value handleCall(const Json::Value &params, const std::string &db_p
     p.tid = args.get("tid", "").asString();
     p.limit = args.get("limit", 1000).asInt();
     p.offset = args.get("offset", 0).asInt();
+    p.after_id = args.get("after_id", 0).asInt64();
+    p.before_id = args.get("before_id", 0).asInt64();
     p.group_by = args.get("group_by", "").asString();
 
     Json::Value result;
     if (name == "query_logs")
     {
-        auto rows = LogQuery::queryLogs(db, p);
+        auto page = LogQuery::queryPage(db, p);
         Json::StreamWriterBuilder w;
         w["indentation"] = "  ";
-        std::string json = Json::writeString(w, rows);
+        std::string json = Json::writeString(w, page);
         result["content"] = Json::Value(Json::arrayValue);
         Json::Value c;
         c["type"] = "text";
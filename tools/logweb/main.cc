@@ -10,9 +10,14 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
 #include <cstring>
 #include <vector>
 #include <map>
+#include <memory>
 #include <set>
 #include <thread>
 #include <chrono>
@@ -115,9 +120,83 @@ static void send404(int fd)
     sendResponse(fd, 404, "text/plain", "Not Found");
 }
 
+// HTTP/1.1 分块传输：攒满一块再发，整个响应不在内存中拼成一个字符串
+class ChunkedWriter
+{
+public:
+    ChunkedWriter(int fd, const std::string &contentType) : _fd(fd)
+    {
+        std::string hdr = "HTTP/1.1 200 OK\r\n"
+                          "Content-Type: " + contentType + "\r\n"
+                          "Transfer-Encoding: chunked\r\n"
+                          "Access-Control-Allow-Origin: *\r\n"
+                          "Connection: close\r\n\r\n";
+        _ok = sendAll(hdr.data(), hdr.size());
+    }
+    /// @brief 追加正文；对端断开后返回 false，调用方据此停止查询
+    bool write(const std::string &data)
+    {
+        _buf += data;
+        if (_buf.size() >= CHUNK_SIZE)
+            flushChunk();
+        return _ok;
+    }
+    void finish()
+    {
+        flushChunk();
+        if (_ok)
+            sendAll("0\r\n\r\n", 5);
+    }
+
+private:
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    void flushChunk()
+    {
+        if (_buf.empty() || !_ok)
+            return;
+        char len[32];
+        int n = snprintf(len, sizeof(len), "%zx\r\n", _buf.size());
+        _buf += "\r\n";
+        _ok = sendAll(len, n) && sendAll(_buf.data(), _buf.size());
+        _buf.clear();
+    }
+    bool sendAll(const char *data, size_t len)
+    {
+        while (len > 0)
+        {
+            ssize_t n = ::send(_fd, data, len, MSG_NOSIGNAL);
+            if (n <= 0)
+                return false;
+            data += n;
+            len -= n;
+        }
+        return true;
+    }
+
+    int _fd;
+    bool _ok = true;
+    std::string _buf;
+};
+
 // ── API 处理 ──────────────────────────────────────────────────
 
-static std::string apiLogs(sqlite3 *db, const std::map<std::string, std::string> &q)
+// 非流式 /api/logs 一页最多返回的行数：整页在内存中拼成 JSON，更多行请翻页或用 format=ndjson
+static constexpr int MAX_PAGE_ROWS = 5000;
+
+// 数字参数解析失败时保留默认值，不让异常打断服务
+static long long numberParam(const std::string &s, long long def)
+{
+    char *end = nullptr;
+    errno = 0;
+    long long v = strtoll(s.c_str(), &end, 10);
+    if (end == s.c_str() || *end != '\0' || errno == ERANGE)
+        return def;
+    return v;
+}
+
+// 响应体保持为行数组；游标放在响应头 X-Next-After-Id / X-Next-Before-Id / X-Has-More
+static LogQuery::Params logsParams(const std::map<std::string, std::string> &q)
 {
     LogQuery::Params p;
     auto it = q.find("level");
@@ -133,14 +212,48 @@ static std::string apiLogs(sqlite3 *db, const std::map<std::string, std::string>
     it = q.find("to_time");
     if (it != q.end()) p.to_time = it->second;
     it = q.find("limit");
-    if (it != q.end()) p.limit = std::stoi(it->second);
+    if (it != q.end()) p.limit = (int)std::max<long long>(-1, std::min<long long>(INT_MAX, numberParam(it->second, p.limit)));
     it = q.find("offset");
-    if (it != q.end()) p.offset = std::stoi(it->second);
+    if (it != q.end()) p.offset = (int)std::max<long long>(0, std::min<long long>(INT_MAX, numberParam(it->second, p.offset)));
+    it = q.find("after_id");
+    if (it != q.end()) p.after_id = numberParam(it->second, p.after_id);
+    it = q.find("before_id");
+    if (it != q.end()) p.before_id = numberParam(it->second, p.before_id);
+    return p;
+}
 
-    auto rows = LogQuery::queryLogs(db, p);
+static std::string apiLogs(sqlite3 *db, const std::map<std::string, std::string> &q,
+                           std::map<std::string, std::string> *headers)
+{
+    // 整页先在内存中组装，limit 不设上限时一个请求就能把全库读进内存；超出上限按上限返回，X-Has-More 提示继续翻页
+    LogQuery::Params p = logsParams(q);
+    if (p.limit < 0 || p.limit > MAX_PAGE_ROWS)
+        p.limit = MAX_PAGE_ROWS;
+    auto page = LogQuery::queryPage(db, p);
+    (*headers)["X-Next-After-Id"] = std::to_string(page["next_after_id"].asInt64());
+    (*headers)["X-Next-Before-Id"] = std::to_string(page["next_before_id"].asInt64());
+    (*headers)["X-Has-More"] = page["has_more"].asBool() ? "1" : "0";
+    (*headers)["Access-Control-Expose-Headers"] = "X-Next-After-Id, X-Next-Before-Id, X-Has-More";
     Json::StreamWriterBuilder w;
     w["indentation"] = "";
-    return Json::writeString(w, rows);
+    return Json::writeString(w, page["rows"]);
+}
+
+// format=ndjson：逐行流式导出，每行一个 JSON 对象，分块发送，导出多少行内存占用都不变
+static void apiLogsStream(int fd, sqlite3 *db, const std::map<std::string, std::string> &q)
+{
+    Json::StreamWriterBuilder w;
+    w["indentation"] = "";
+    std::unique_ptr<Json::StreamWriter> writer(w.newStreamWriter());
+    ChunkedWriter out(fd, "application/x-ndjson");
+    std::ostringstream line;
+    LogQuery::forEachLog(db, logsParams(q), [&](const Json::Value &row)
+                         {
+                             line.str("");
+                             writer->write(row, &line);
+                             line << "\n";
+                             return out.write(line.str()); });
+    out.finish();
 }
 
 static std::string apiStats(sqlite3 *db, const std::map<std::string, std::string> &q)
@@ -178,41 +291,32 @@ static void handleSSE(int fd, sqlite3 *db)
                       "Connection: keep-alive\r\n\r\n";
     ::send(fd, hdr.c_str(), hdr.size(), 0);
 
-    int lastId = 0;
-    // 获取当前最大 id
-    {
-        sqlite3_stmt *s;
-        sqlite3_prepare_v2(db, "SELECT COALESCE(MAX(id),0) FROM logs", -1, &s, nullptr);
-        if (sqlite3_step(s) == SQLITE_ROW)
-            lastId = sqlite3_column_int(s, 0);
-        sqlite3_finalize(s);
-    }
+    // 从当前最大 id 开始推送；分区库由 LogQuery 负责找到最新的分区
+    long long lastId = LogQuery::maxId(db);
 
     // 每隔 2 秒检查新记录
     for (int i = 0; i < 150; i++) // 5 分钟超时
     {
         std::this_thread::sleep_for(std::chrono::seconds(2));
-        sqlite3_stmt *s;
-        sqlite3_prepare_v2(db, "SELECT id, log_time, log_level, logger_name, message FROM logs WHERE id > ? ORDER BY id ASC LIMIT 50",
-                           -1, &s, nullptr);
-        sqlite3_bind_int(s, 1, lastId);
+        Json::StreamWriterBuilder w;
+        w["indentation"] = "";
 
         std::ostringstream data;
         bool has = false;
-        while (sqlite3_step(s) == SQLITE_ROW)
+        for (auto &r : LogQuery::tailLogs(db, lastId, 50))
         {
             if (!has) { data << "data: ["; has = true; }
             else data << ",";
 
-            int id = sqlite3_column_int(s, 0);
-            data << "{\"id\":" << id
-                 << ",\"time\":\"" << sqlite3_column_text(s, 1) << "\""
-                 << ",\"level\":\"" << sqlite3_column_text(s, 2) << "\""
-                 << ",\"logger\":\"" << sqlite3_column_text(s, 3) << "\""
-                 << ",\"msg\":\"" << sqlite3_column_text(s, 4) << "\"}";
-            lastId = std::max(lastId, id);
+            Json::Value ev;
+            ev["id"] = r["id"];
+            ev["time"] = r["log_time"];
+            ev["level"] = r["log_level"];
+            ev["logger"] = r["logger_name"];
+            ev["msg"] = r["message"];
+            data << Json::writeString(w, ev);
+            lastId = std::max(lastId, (long long)r["id"].asInt64());
         }
-        sqlite3_finalize(s);
 
         if (has)
         {
@@ -283,6 +387,7 @@ main{display:flex;flex:1;overflow:hidden}
 <input id="q-from" placeholder="起始时间 YYYY-MM-DD HH:MM">
 <input id="q-to" placeholder="结束时间 YYYY-MM-DD HH:MM">
 <button onclick="doSearch()">搜索</button>
+<button id="q-more" onclick="doSearch(true)" disabled>下一页</button>
 <div id="results"></div>
 </div>
 </main>
@@ -306,14 +411,20 @@ function loadStats() {
     R('st-warn').textContent = (groups.find(g=>g.group=='WARN')||{}).count||0;
   });
 }
-function doSearch() {
+let nextAfter = 0;
+function doSearch(more) {
   let p = new URLSearchParams();
   let v = R('q-level').value; if(v) p.set('level',v);
   v = R('q-keyword').value; if(v) p.set('keyword',v);
   v = R('q-from').value; if(v) p.set('from_time',v);
   v = R('q-to').value; if(v) p.set('to_time',v);
   p.set('limit','100');
-  fetch('/api/logs?'+p).then(r=>r.json()).then(rows=>{
+  if (more) p.set('after_id', nextAfter);
+  fetch('/api/logs?'+p).then(r=>{
+    nextAfter = r.headers.get('X-Next-After-Id') || 0;
+    R('q-more').disabled = r.headers.get('X-Has-More') != '1';
+    return r.json();
+  }).then(rows=>{
     R('results').innerHTML = '';
     rows.forEach(r=>addLog(R('results'),null,r,false));
   });
@@ -393,16 +504,21 @@ int main(int argc, char *argv[])
 
         // 每个请求独立打开数据库（简单、线程安全）
         sqlite3 *db = nullptr;
-        sqlite3_open_v2(db_path.c_str(), &db, SQLITE_OPEN_READONLY, nullptr);
+        LogQuery::openReadOnly(db_path, &db);
 
         if (req.path == "/" || req.path == "/index.html")
         {
             sendResponse(clientFd, 200, "text/html; charset=utf-8", HTML);
         }
+        else if (req.path == "/api/logs" && db && req.query.count("format") && req.query.at("format") == "ndjson")
+        {
+            apiLogsStream(clientFd, db, req.query);
+        }
         else if (req.path == "/api/logs")
         {
-            std::string json = db ? apiLogs(db, req.query) : "[]";
-            sendResponse(clientFd, 200, "application/json", json);
+            std::map<std::string, std::string> headers;
+            std::string json = db ? apiLogs(db, req.query, &headers) : "[]";
+            sendResponse(clientFd, 200, "application/json", json, headers);
         }
         else if (req.path == "/api/stats")
         {
@@ -65,7 +65,13 @@ echo "=== Test 6: 404 处理 ==="
 RESP=$(curl -s --max-time 3 "$BASE/nosuch" 2>/dev/null || echo "")
 check "404 body" "Not Found" "$RESP"
 
-echo "=== Test 7: SSE /api/stream ==="
+echo "=== Test 7: limit 越界 / 非法参数不打断服务 ==="
+HEADERS=$(curl -s -D - -o /dev/null "$BASE/api/logs?limit=-1")
+check "unbounded limit capped" "X-Has-More" "$HEADERS"
+RESP=$(curl -s "$BASE/api/logs?limit=abc&after_id=x")
+check "bad number falls back" "[" "$RESP"
+
+echo "=== Test 8: SSE /api/stream ==="
 HEADERS=$(curl -sI --max-time 3 "$BASE/api/stream" 2>/dev/null || true)
 check "SSE content-type" "text/event-stream" "$HEADERS"
 